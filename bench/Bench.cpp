@@ -0,0 +1,167 @@
+/*
+ * Copyright (c) 2022-2023, NeKz
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "Bench.hpp"
+#include "../src/Scanner.hpp"
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+
+static std::vector<std::pair<const Benchmark*, BenchmarkResult>> results;
+
+std::vector<Benchmark*>& Benchmark::benchmarks()
+{
+    static std::vector<Benchmark*> list;
+    return list;
+}
+
+Benchmark::Benchmark(const char* name, _BenchmarkFunction callback)
+    : name(name)
+    , callback(callback)
+{
+    Benchmark::benchmarks().push_back(this);
+}
+
+auto random_code_byte(std::mt19937& rng) -> uint8_t
+{
+    auto common = std::uniform_int_distribution<size_t>(0, sizeof(Scanner::common_bytes) - 1);
+    auto any = std::uniform_int_distribution<int>(0, 255);
+    return rng() % 2 ? Scanner::common_bytes[common(rng)] : uint8_t(any(rng));
+}
+
+auto make_synthetic_image(size_t size, uint32_t seed) -> std::vector<uint8_t>
+{
+    auto rng = std::mt19937(seed);
+    auto image = std::vector<uint8_t>(size);
+    for (auto& value : image) {
+        value = random_code_byte(rng);
+    }
+    return image;
+}
+
+auto make_random_signature(std::mt19937& rng, size_t length, double wildcard_ratio) -> std::string
+{
+    auto wildcard = std::bernoulli_distribution(wildcard_ratio);
+    auto signature = std::string();
+
+    for (auto i = size_t(0); i < length; ++i) {
+        // First two bytes are always fixed like most real signatures
+        if (i >= 2 && wildcard(rng)) {
+            signature += "?";
+        } else {
+            char hex[3];
+            std::snprintf(hex, sizeof(hex), "%02X", random_code_byte(rng));
+            signature += hex;
+        }
+
+        if (i + 1 != length) {
+            signature += " ";
+        }
+    }
+
+    return signature;
+}
+
+auto plant_signature(std::vector<uint8_t>& image, size_t offset, const std::string& signature, std::mt19937& rng)
+    -> void
+{
+    auto parsed = Scanner::Signature();
+    Scanner::Parse(signature.c_str(), &parsed);
+
+    for (auto i = size_t(0); i < parsed.bytes.size() && offset + i < image.size(); ++i) {
+        image[offset + i] = parsed.mask[i] ? parsed.bytes[i] : random_code_byte(rng);
+    }
+}
+
+auto report(const Benchmark* bench, const BenchmarkResult& result) -> void
+{
+    auto params = std::string();
+    for (const auto& [key, value] : result.params) {
+        char buffer[64];
+        std::snprintf(buffer, sizeof(buffer), "%s%s=%g", params.empty() ? "" : " ", key.c_str(), value);
+        params += buffer;
+    }
+
+    std::printf("%-28s %-40s %10.3f ms %10.3f ms %8.2f GB/s %12.2f us/scan %10zu matches\n", result.name.c_str(),
+        params.c_str(), result.time.best_ms, result.time.mean_ms, result.gb_per_s(), result.us_per_scan(),
+        result.matches);
+
+    results.emplace_back(bench, result);
+}
+
+static auto write_json_string(FILE* file, const std::string& value) -> void
+{
+    std::fputc('"', file);
+    for (auto c : value) {
+        if (c == '"' || c == '\\') {
+            std::fputc('\\', file);
+        }
+        std::fputc(c, file);
+    }
+    std::fputc('"', file);
+}
+
+/*
+ * Writes all results as:
+ *
+ *     { "backend": "AVX2", "results": [{ "benchmark": "...", "name": "...", "params": { ... }, ... }] }
+ */
+static auto write_json(const char* path) -> bool
+{
+    auto file = std::fopen(path, "w");
+    if (!file) {
+        return false;
+    }
+
+    std::fprintf(file, "{\n  \"backend\": ");
+    write_json_string(file, Scanner::GetBackendName(Scanner::GetBackend()));
+    std::fprintf(file, ",\n  \"results\": [");
+
+    for (auto i = size_t(0); i < results.size(); ++i) {
+        const auto& [bench, result] = results[i];
+
+        std::fprintf(file, "%s\n    { \"benchmark\": ", i ? "," : "");
+        write_json_string(file, bench->name);
+        std::fprintf(file, ", \"name\": ");
+        write_json_string(file, result.name);
+        std::fprintf(file, ", \"params\": {");
+        for (auto j = size_t(0); j < result.params.size(); ++j) {
+            std::fprintf(file, "%s ", j ? "," : "");
+            write_json_string(file, result.params[j].first);
+            std::fprintf(file, ": %.17g", result.params[j].second);
+        }
+        std::fprintf(file,
+            " }, \"bytes\": %zu, \"scans\": %zu, \"matches\": %zu, \"best_ms\": %.6f, \"mean_ms\": %.6f, "
+            "\"gb_per_s\": %.6f, \"us_per_scan\": %.6f }",
+            result.bytes, result.scans, result.matches, result.time.best_ms, result.time.mean_ms, result.gb_per_s(),
+            result.us_per_scan());
+    }
+
+    std::fprintf(file, "\n  ]\n}\n");
+    return std::fclose(file) == 0;
+}
+
+auto run_all_benchmarks(const char* filter, const char* json_path) -> int
+{
+    std::cout << "backend: " << Scanner::GetBackendName(Scanner::GetBackend()) << std::endl << std::endl;
+
+    for (auto& benchmark : Benchmark::benchmarks()) {
+        if (filter && !std::strstr(benchmark->name, filter)) {
+            continue;
+        }
+
+        std::cout << "[" << benchmark->name << "]" << std::endl;
+        benchmark->callback(benchmark);
+        std::cout << std::endl;
+    }
+
+    if (json_path && !write_json(json_path)) {
+        std::cerr << "unable to write " << json_path << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
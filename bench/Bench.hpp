@@ -0,0 +1,108 @@
+/*
+ * Copyright (c) 2022-2023, NeKz
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+using _BenchmarkFunction = void (*)(struct Benchmark* bench);
+
+struct Benchmark {
+    const char* name;
+    _BenchmarkFunction callback;
+
+    static std::vector<Benchmark*>& benchmarks();
+
+    Benchmark(const char* name, _BenchmarkFunction callback);
+};
+
+#define BENCHMARK(name)                                                                                                \
+    void name##_benchmark(Benchmark* bench);                                                                           \
+    Benchmark name##_instance(#name, name##_benchmark);                                                                \
+    void name##_benchmark(Benchmark* bench)
+
+struct Stopwatch {
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    inline auto elapsed_ms() const -> double
+    {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - this->start).count();
+    }
+};
+
+struct Measurement {
+    double best_ms;
+    double mean_ms;
+};
+
+/*
+ * Runs callback a few times and returns the fastest and the average run in milliseconds.
+ */
+template <typename F> inline auto measure_runs(F callback, int runs = 5) -> Measurement
+{
+    auto result = Measurement { 0.0, 0.0 };
+    for (auto i = 0; i < runs; ++i) {
+        auto watch = Stopwatch();
+        callback();
+        auto elapsed = watch.elapsed_ms();
+        result.best_ms = i == 0 || elapsed < result.best_ms ? elapsed : result.best_ms;
+        result.mean_ms += elapsed / runs;
+    }
+    return result;
+}
+template <typename F> inline auto measure(F callback, int runs = 5) -> double
+{
+    return measure_runs(callback, runs).best_ms;
+}
+
+/*
+ * One measured case of a benchmark. Throughput is derived from the bytes
+ * which one run scans, latency from the number of scan calls per run.
+ */
+typedef std::vector<std::pair<std::string, double>> BenchmarkParams;
+
+struct BenchmarkResult {
+    std::string name;
+    BenchmarkParams params;
+    size_t bytes;
+    size_t scans;
+    size_t matches;
+    Measurement time;
+
+    inline auto gb_per_s() const -> double
+    {
+        return this->time.best_ms > 0.0 ? this->bytes / this->time.best_ms / 1e6 : 0.0;
+    }
+    inline auto us_per_scan() const -> double { return this->scans ? this->time.best_ms * 1000.0 / this->scans : 0.0; }
+};
+
+/*
+ * Prints a result and keeps it for the JSON report.
+ */
+extern auto report(const Benchmark* bench, const BenchmarkResult& result) -> void;
+
+/*
+ * Random bytes with roughly the distribution of x86 code.
+ */
+extern auto random_code_byte(std::mt19937& rng) -> uint8_t;
+extern auto make_synthetic_image(size_t size, uint32_t seed) -> std::vector<uint8_t>;
+extern auto make_random_signature(std::mt19937& rng, size_t length, double wildcard_ratio) -> std::string;
+
+/*
+ * Writes the bytes of a signature into the image, wildcards get random values.
+ */
+extern auto plant_signature(std::vector<uint8_t>& image, size_t offset, const std::string& signature,
+    std::mt19937& rng) -> void;
+
+/*
+ * Runs every benchmark whose name contains filter and writes all results to
+ * json_path if set.
+ */
+extern auto run_all_benchmarks(const char* filter, const char* json_path = nullptr) -> int;
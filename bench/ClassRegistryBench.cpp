@@ -0,0 +1,91 @@
+/*
+ * Copyright (c) 2022-2023, NeKz
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "../src/ClassRegistry.hpp"
+#include "Bench.hpp"
+#include <memory>
+
+namespace {
+struct BenchClass {
+    BenchClass* super_field;
+};
+
+struct BenchInstance {
+    BenchClass* class_object;
+};
+}
+
+// Walks every object and its class chain like a g_Objects sweep does
+static auto sweep_instances(BenchInstance* const* objects, size_t size, const BenchClass* class_object) -> size_t
+{
+    auto found = size_t(0);
+    for (auto i = size_t(0); i < size; ++i) {
+        auto object = objects[i];
+        if (!object) {
+            continue;
+        }
+
+        for (auto field = object->class_object; field; field = field->super_field) {
+            if (field == class_object) {
+                ++found;
+                break;
+            }
+        }
+    }
+    return found;
+}
+
+BENCHMARK(class_instances)
+{
+    const auto class_count = uint32_t(2000);
+    const auto object_count = uint32_t(100'000);
+
+    auto rng = std::mt19937(8);
+
+    // Each class derives from a random earlier one
+    auto classes = std::vector<std::unique_ptr<BenchClass>>();
+    for (auto i = uint32_t(0); i < class_count; ++i) {
+        auto super_field = i ? classes[rng() % i].get() : nullptr;
+        classes.push_back(std::make_unique<BenchClass>(BenchClass { super_field }));
+    }
+
+    auto storage = std::vector<std::unique_ptr<BenchInstance>>();
+    auto objects = std::vector<BenchInstance*>();
+    for (auto i = uint32_t(0); i < object_count; ++i) {
+        storage.push_back(std::make_unique<BenchInstance>(BenchInstance { classes[rng() % class_count].get() }));
+        objects.push_back(storage.back().get());
+    }
+
+    auto params = BenchmarkParams { { "objects", double(object_count) } };
+
+    auto registry = ClassRegistry<BenchInstance>();
+    auto build = measure_runs(
+        [&]() {
+            registry.Clear();
+            registry.Update(objects.data(), objects.size());
+        },
+        3);
+    report(bench, { "build_registry", params, 0, 1, registry.GetInstanceCount(), build });
+
+    auto update = measure_runs([&]() { registry.Update(objects.data(), objects.size(), 4096); });
+    report(bench, { "update_budget_4096", params, 0, 1, registry.GetInstanceCount(), update });
+
+    // A leaf class and a class with many subclasses
+    for (auto class_index : { class_count - 1, uint32_t(1) }) {
+        auto class_object = classes[class_index].get();
+        auto class_params = BenchmarkParams { { "objects", double(object_count) }, { "class", double(class_index) } };
+
+        auto found = size_t(0);
+        auto sweep = measure_runs([&]() { found = sweep_instances(objects.data(), objects.size(), class_object); });
+        report(bench, { "find_instances_sweep", class_params, 0, 1, found, sweep });
+
+        registry.ForEach(objects.data(), objects.size(), class_object, [](BenchInstance*) {});
+        auto indexed = measure_runs([&]() {
+            found = registry.ForEach(objects.data(), objects.size(), class_object, [](BenchInstance*) {});
+        });
+        report(bench, { "find_instances_registry", class_params, 0, 1, found, indexed });
+    }
+}
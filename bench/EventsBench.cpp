@@ -0,0 +1,85 @@
+/*
+ * Copyright (c) 2022-2023, NeKz
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "../src/Events.hpp"
+#include "Bench.hpp"
+#include <cstdio>
+
+// Roughly the number of names in GridGame.exe
+const auto name_count = uint32_t(0x10000);
+const auto event_count = size_t(1 << 20);
+
+static auto handled = size_t(0);
+
+static auto on_event(UObject*, UFunction*, void*) -> bool
+{
+    ++handled;
+    return true;
+}
+
+struct EventKey {
+    uint32_t object;
+    uint32_t function;
+};
+
+BENCHMARK(process_event_dispatch)
+{
+    auto rng = std::mt19937(5);
+
+    auto events = std::vector<EventKey>(event_count);
+    for (auto& event : events) {
+        event = { uint32_t(rng() % name_count), uint32_t(rng() % name_count) };
+    }
+
+    for (auto count : { 0, 10, 100 }) {
+        Events::Clear();
+
+        auto keys = std::vector<EventKey>();
+        while (keys.size() < size_t(count)) {
+            keys.push_back({ uint32_t(rng() % name_count), uint32_t(rng() % name_count) });
+            Events::Register(keys.back().object, keys.back().function, on_event);
+        }
+
+        // One in 64 events has a handler, the others go straight to the original
+        for (auto i = size_t(0); count && i < events.size(); i += 64) {
+            events[i] = keys[(i / 64) % keys.size()];
+        }
+
+        // What ProcessEvent did before: compare every key against the event
+        auto handled_chain = size_t(0);
+        auto chain = measure_runs([&]() {
+            handled = 0;
+            for (const auto& event : events) {
+                for (const auto& key : keys) {
+                    if (event.object == key.object && event.function == key.function) {
+                        on_event(nullptr, nullptr, nullptr);
+                    }
+                }
+            }
+            handled_chain = handled;
+        });
+
+        auto handled_table = size_t(0);
+        auto table = measure_runs([&]() {
+            handled = 0;
+            for (const auto& event : events) {
+                Events::Dispatch(event.object, event.function, nullptr, nullptr, nullptr);
+            }
+            handled_table = handled;
+        });
+
+        // Scans are dispatched events, us_per_scan is the overhead per event
+        auto params = BenchmarkParams { { "handlers", double(count) }, { "names", double(name_count) } };
+        report(bench, { "if_chain", params, 0, events.size(), handled_chain, chain });
+        report(bench, { "dispatch_table", params, 0, events.size(), handled_table, table });
+
+        if (handled_chain != handled_table) {
+            std::printf("handled mismatch: %zu != %zu\n", handled_chain, handled_table);
+        }
+    }
+
+    Events::Clear();
+}
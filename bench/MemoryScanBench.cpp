@@ -0,0 +1,195 @@
+/*
+ * Copyright (c) 2022-2023, NeKz
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "../src/Memory.hpp"
+#include "../src/Scanner.hpp"
+#include "Bench.hpp"
+#include <cstdio>
+
+#define SYNTHETIC_MODULE "synthetic.bin"
+
+/*
+ * Registers the image as module so that the module based scans can be measured on it.
+ */
+static auto add_synthetic_module(const std::vector<uint8_t>& image) -> void
+{
+    auto module = Memory::ModuleInfo();
+    std::snprintf(module.name, sizeof(module.name), "%s", SYNTHETIC_MODULE);
+    module.base = uintptr_t(image.data());
+    module.size = image.size();
+    Memory::AddModule(module);
+}
+
+/*
+ * Plants count copies of the signature evenly spread over the image.
+ */
+static auto plant_hits(std::vector<uint8_t>& image, const std::string& signature, size_t count, std::mt19937& rng)
+    -> void
+{
+    if (!count) {
+        return;
+    }
+
+    auto stride = image.size() / count;
+    for (auto i = size_t(0); i < count; ++i) {
+        plant_signature(image, i * stride + rng() % (stride - 64), signature, rng);
+    }
+}
+
+BENCHMARK(memory_scan_image_size)
+{
+    for (auto image_mb : { 1, 4, 16, 64 }) {
+        auto image = make_synthetic_image(size_t(image_mb) << 20, 10 + image_mb);
+        auto rng = std::mt19937(image_mb);
+
+        // Single hit at the end, first match scans have to cover the whole image
+        auto text = make_random_signature(rng, 16, 0.25);
+        plant_signature(image, image.size() - 64, text, rng);
+
+        auto signature = Scanner::Signature();
+        Scanner::Parse(text.c_str(), &signature);
+        auto pattern = Memory::Pattern { text.c_str(), signature.view(), { 0 } };
+
+        add_synthetic_module(image);
+
+        auto start = uintptr_t(image.data());
+        auto end = start + image.size();
+        auto params = BenchmarkParams { { "image_mb", double(image_mb) }, { "length", 16 }, { "wildcards", 0.25 } };
+
+        auto found = uintptr_t(0);
+        auto time = measure_runs([&]() { found = Memory::FindAddress(start, end, text.c_str()); });
+        report(bench, { "FindAddress(text)", params, image.size(), 1, found ? 1u : 0u, time });
+
+        time = measure_runs([&]() { found = Memory::FindAddress(start, end, signature.view()); });
+        report(bench, { "FindAddress(signature)", params, image.size(), 1, found ? 1u : 0u, time });
+
+        time = measure_runs([&]() { found = Memory::Scan(SYNTHETIC_MODULE, text.c_str()); });
+        report(bench, { "Scan(text)", params, image.size(), 1, found ? 1u : 0u, time });
+
+        auto results = std::vector<uintptr_t>();
+        time = measure_runs([&]() { results = Memory::Scan(SYNTHETIC_MODULE, &pattern); });
+        report(bench, { "Scan(pattern)", params, image.size(), 1, results.size(), time });
+
+        Memory::RemoveModule(SYNTHETIC_MODULE);
+    }
+}
+
+BENCHMARK(memory_scan_hit_density)
+{
+    const auto image_mb = 16;
+    const auto pattern_count = 16;
+
+    for (auto hits_per_mb : { 0, 1, 16, 256 }) {
+        auto image = make_synthetic_image(size_t(image_mb) << 20, 20 + hits_per_mb);
+        auto rng = std::mt19937(hits_per_mb);
+
+        auto texts = std::vector<std::string>();
+        auto signatures = std::vector<Scanner::Signature>(pattern_count);
+        for (auto& signature : signatures) {
+            texts.push_back(make_random_signature(rng, 16, 0.25));
+            plant_hits(image, texts.back(), size_t(hits_per_mb) * image_mb / pattern_count, rng);
+            Scanner::Parse(texts.back().c_str(), &signature);
+        }
+
+        auto pattern_storage = std::vector<Memory::Pattern>();
+        for (auto i = 0; i < pattern_count; ++i) {
+            pattern_storage.push_back({ texts[i].c_str(), signatures[i].view(), { 0 } });
+        }
+        auto patterns = Memory::Patterns();
+        for (auto& pattern : pattern_storage) {
+            patterns.push_back(&pattern);
+        }
+
+        add_synthetic_module(image);
+
+        auto params = BenchmarkParams { { "image_mb", double(image_mb) }, { "hits_per_mb", double(hits_per_mb) },
+            { "patterns", double(pattern_count) } };
+
+        auto results = std::vector<uintptr_t>();
+        auto time = measure_runs([&]() { results = Memory::MultiScan(SYNTHETIC_MODULE, texts[0].c_str()); });
+        report(bench, { "MultiScan(text)", params, image.size(), 1, results.size(), time });
+
+        auto visited = size_t(0);
+        auto view = signatures[0].view();
+        time = measure_runs([&]() {
+            visited = Memory::ForEachMatch(SYNTHETIC_MODULE, view, [](uintptr_t) { return true; });
+        });
+        report(bench, { "ForEachMatch(signature)", params, image.size(), 1, visited, time });
+
+        auto grouped = std::vector<std::vector<uintptr_t>>();
+        time = measure_runs([&]() { grouped = Memory::MultiScan(SYNTHETIC_MODULE, &patterns); }, 3);
+        report(bench, { "MultiScan(patterns)", params, image.size(), 1, grouped.size(), time });
+
+        Memory::RemoveModule(SYNTHETIC_MODULE);
+    }
+}
+
+BENCHMARK(memory_scan_pattern_length)
+{
+    const auto image_mb = 16;
+
+    auto image = make_synthetic_image(size_t(image_mb) << 20, 30);
+    auto rng = std::mt19937(30);
+
+    add_synthetic_module(image);
+
+    auto start = uintptr_t(image.data());
+    auto end = start + image.size();
+
+    for (auto length : { 4, 8, 16, 32, 64 }) {
+        auto text = make_random_signature(rng, length, 0.25);
+        auto signature = Scanner::Signature();
+        Scanner::Parse(text.c_str(), &signature);
+
+        auto params = BenchmarkParams { { "image_mb", double(image_mb) }, { "length", double(length) },
+            { "wildcards", 0.25 } };
+
+        // Mostly misses, the first match scan only stops early for short signatures
+        auto found = uintptr_t(0);
+        auto time = measure_runs([&]() { found = Memory::FindAddress(start, end, signature.view()); });
+        report(bench, { "FindAddress(signature)", params, size_t(found ? found - start : image.size()), 1,
+            found ? 1u : 0u, time });
+
+        auto results = std::vector<uintptr_t>();
+        time = measure_runs([&]() { results = Memory::MultiScan(SYNTHETIC_MODULE, text.c_str()); });
+        report(bench, { "MultiScan(text)", params, image.size(), 1, results.size(), time });
+    }
+
+    Memory::RemoveModule(SYNTHETIC_MODULE);
+}
+
+BENCHMARK(memory_scan_wildcard_ratio)
+{
+    const auto image_mb = 16;
+
+    auto image = make_synthetic_image(size_t(image_mb) << 20, 40);
+    auto rng = std::mt19937(40);
+
+    add_synthetic_module(image);
+
+    auto start = uintptr_t(image.data());
+    auto end = start + image.size();
+
+    for (auto wildcards : { 0.0, 0.25, 0.5, 0.75 }) {
+        auto text = make_random_signature(rng, 16, wildcards);
+        auto signature = Scanner::Signature();
+        Scanner::Parse(text.c_str(), &signature);
+
+        auto params
+            = BenchmarkParams { { "image_mb", double(image_mb) }, { "length", 16 }, { "wildcards", wildcards } };
+
+        auto found = uintptr_t(0);
+        auto time = measure_runs([&]() { found = Memory::FindAddress(start, end, signature.view()); });
+        report(bench, { "FindAddress(signature)", params, size_t(found ? found - start : image.size()), 1,
+            found ? 1u : 0u, time });
+
+        auto results = std::vector<uintptr_t>();
+        time = measure_runs([&]() { results = Memory::MultiScan(SYNTHETIC_MODULE, text.c_str()); });
+        report(bench, { "MultiScan(text)", params, image.size(), 1, results.size(), time });
+    }
+
+    Memory::RemoveModule(SYNTHETIC_MODULE);
+}
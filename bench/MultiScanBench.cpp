@@ -0,0 +1,107 @@
+/*
+ * Copyright (c) 2022-2023, NeKz
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "../src/Scanner.hpp"
+#include "Bench.hpp"
+#include <cstdio>
+
+// Roughly the size of GridGame.exe
+const auto image_size = size_t(35 * 1024 * 1024);
+
+BENCHMARK(multi_scan_vs_per_pattern_loop)
+{
+    auto image = make_synthetic_image(image_size, 1);
+    auto rng = std::mt19937(2);
+
+    auto texts = std::vector<std::string>();
+    auto signatures = std::vector<Scanner::Signature>();
+
+    for (auto count : { 1, 4, 16, 64, 256 }) {
+        while (texts.size() < size_t(count)) {
+            auto text = make_random_signature(rng, 16, 0.25);
+            plant_signature(image, rng() % (image.size() - 16), text, rng);
+            texts.push_back(text);
+
+            signatures.emplace_back();
+            Scanner::Parse(text.c_str(), &signatures.back());
+        }
+
+        auto views = std::vector<Scanner::SignatureView>();
+        for (auto& signature : signatures) {
+            views.push_back(signature.view());
+        }
+
+        auto start = image.data();
+        auto end = image.data() + image.size();
+
+        auto hits_loop = size_t(0);
+        auto loop = measure_runs(
+            [&]() {
+                hits_loop = 0;
+                for (auto& view : views) {
+                    hits_loop += Scanner::FindAll(start, end, view).size();
+                }
+            },
+            3);
+
+        auto hits_set = size_t(0);
+        auto set = Scanner::SignatureSet(views);
+        auto single = measure_runs(
+            [&]() {
+                hits_set = 0;
+                for (auto& matches : set.FindAll(start, end)) {
+                    hits_set += matches.size();
+                }
+            },
+            3);
+
+        auto params = BenchmarkParams { { "image_mb", double(image_size >> 20) }, { "patterns", double(count) } };
+        report(bench, { "per_pattern_loop", params, image.size(), views.size(), hits_loop, loop });
+        report(bench, { "single_pass", params, image.size(), 1, hits_set, single });
+
+        if (hits_loop != hits_set) {
+            std::printf("hit mismatch: %zu != %zu\n", hits_loop, hits_set);
+        }
+    }
+}
+
+BENCHMARK(parallel_scan)
+{
+    auto image = make_synthetic_image(image_size, 3);
+    auto rng = std::mt19937(4);
+
+    auto signatures = std::vector<Scanner::Signature>(64);
+    auto views = std::vector<Scanner::SignatureView>();
+    for (auto& signature : signatures) {
+        auto text = make_random_signature(rng, 16, 0.25);
+        plant_signature(image, rng() % (image.size() - 16), text, rng);
+        Scanner::Parse(text.c_str(), &signature);
+        views.push_back(signature.view());
+    }
+
+    auto set = Scanner::SignatureSet(views);
+    auto start = image.data();
+    auto end = image.data() + image.size();
+
+    for (auto threads : { 1, 2, 4, 8 }) {
+        auto single_matches = size_t(0);
+        auto single = measure_runs([&]() { single_matches = Scanner::FindAll(start, end, views[0], threads).size(); });
+
+        auto batch_matches = size_t(0);
+        auto batch = measure_runs(
+            [&]() {
+                batch_matches = 0;
+                for (auto& matches : set.FindAll(start, end, threads)) {
+                    batch_matches += matches.size();
+                }
+            },
+            3);
+
+        auto params = BenchmarkParams { { "image_mb", double(image_size >> 20) }, { "threads", double(threads) } };
+        report(bench, { "find_all", params, image.size(), 1, single_matches, single });
+        report(bench, { "signature_set", params, image.size(), 1, batch_matches, batch });
+    }
+}
@@ -0,0 +1,118 @@
+/*
+ * Copyright (c) 2022-2023, NeKz
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "../src/NameIndex.hpp"
+#include "Bench.hpp"
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <string_view>
+
+namespace {
+// Same layout as FNameEntry in SDK.hpp
+struct BenchNameEntry {
+    int unk0;
+    int unk1;
+    int index;
+    int unk2;
+    char name[64];
+};
+}
+
+// What TEM::find_name and TEM::find_name_index used to do
+static auto linear_find_name(BenchNameEntry* const* names, uint32_t size, uint32_t index) -> std::string_view
+{
+    for (auto i = 0u; i < size; ++i) {
+        auto item = names[i];
+        if (item && uint32_t(item->index) == i << 1 && uint32_t(item->index) == index << 1) {
+            return item->name;
+        }
+    }
+    return "";
+}
+static auto linear_find_name_index(BenchNameEntry* const* names, uint32_t size, const char* name) -> int
+{
+    for (auto i = 0u; i < size; ++i) {
+        auto item = names[i];
+        if (item && uint32_t(item->index) == i << 1 && std::strcmp(item->name, name) == 0) {
+            return item->index >> 1;
+        }
+    }
+    return -1;
+}
+
+BENCHMARK(name_lookup)
+{
+    const auto name_count = uint32_t(100'000);
+    const auto lookups = size_t(1000);
+
+    auto rng = std::mt19937(6);
+
+    auto storage = std::vector<std::unique_ptr<BenchNameEntry>>();
+    auto entries = std::vector<BenchNameEntry*>();
+    for (auto i = uint32_t(0); i < name_count; ++i) {
+        storage.push_back(std::make_unique<BenchNameEntry>());
+        storage.back()->index = int(i << 1);
+        std::snprintf(storage.back()->name, sizeof(storage.back()->name), "Pg%08x_%u", uint32_t(rng()), i);
+        entries.push_back(storage.back().get());
+    }
+
+    auto queries = std::vector<uint32_t>(lookups);
+    for (auto& query : queries) {
+        query = uint32_t(rng() % name_count);
+    }
+
+    auto params = BenchmarkParams { { "names", double(name_count) } };
+
+    auto index = NameIndex();
+    auto build = measure_runs(
+        [&]() {
+            index.Clear();
+            index.Update(entries.data(), entries.size());
+        },
+        3);
+    report(bench, { "build_index", params, 0, 1, index.GetIndexedCount(), build });
+
+    // Index to name
+    auto found = size_t(0);
+    auto linear = measure_runs(
+        [&]() {
+            found = 0;
+            for (auto query : queries) {
+                found += !linear_find_name(entries.data(), name_count, query).empty();
+            }
+        },
+        3);
+    report(bench, { "find_name_linear", params, 0, lookups, found, linear });
+
+    auto indexed = measure_runs([&]() {
+        found = 0;
+        for (auto query : queries) {
+            found += !index.Find(query).empty();
+        }
+    });
+    report(bench, { "find_name_indexed", params, 0, lookups, found, indexed });
+
+    // Name to index
+    auto matches = size_t(0);
+    linear = measure_runs(
+        [&]() {
+            matches = 0;
+            for (auto query : queries) {
+                matches += linear_find_name_index(entries.data(), name_count, entries[query]->name) == int(query);
+            }
+        },
+        3);
+    report(bench, { "find_name_index_linear", params, 0, lookups, matches, linear });
+
+    indexed = measure_runs([&]() {
+        matches = 0;
+        for (auto query : queries) {
+            matches += index.FindIndex(entries[query]->name) == int(query);
+        }
+    });
+    report(bench, { "find_name_index_hashed", params, 0, lookups, matches, indexed });
+}
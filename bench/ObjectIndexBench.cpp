@@ -0,0 +1,131 @@
+/*
+ * Copyright (c) 2022-2023, NeKz
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "../src/ObjectIndex.hpp"
+#include "Bench.hpp"
+#include <cstdio>
+#include <memory>
+#include <string>
+
+namespace {
+// Same layout as FNameEntry in SDK.hpp
+struct BenchObjectName {
+    int unk0;
+    int unk1;
+    int index;
+    int unk2;
+    char name[64];
+};
+
+// Same members as UObject in SDK.hpp
+struct BenchObject {
+    BenchObject* outer_object;
+    struct {
+        unsigned int index;
+        unsigned int number;
+    } name;
+    BenchObject* class_object;
+};
+}
+
+// Builds the full path by walking the outer chain like the object dump does
+static auto linear_find_object(BenchObject* const* objects, size_t size, BenchObjectName* const* names,
+    const std::string& path) -> BenchObject*
+{
+    for (auto i = size_t(0); i < size; ++i) {
+        auto item = objects[i];
+        if (!item) {
+            continue;
+        }
+
+        auto full_name = std::string(names[item->name.index]->name);
+        for (auto outer = item->outer_object; outer; outer = outer->outer_object) {
+            full_name = std::string(names[outer->name.index]->name) + "." + full_name;
+        }
+
+        if (full_name == path) {
+            return item;
+        }
+    }
+    return nullptr;
+}
+
+BENCHMARK(object_lookup)
+{
+    const auto name_count = uint32_t(10'000);
+    const auto package_count = uint32_t(100);
+    const auto object_count = uint32_t(100'000);
+    const auto lookups = size_t(100);
+
+    auto rng = std::mt19937(7);
+
+    auto name_storage = std::vector<std::unique_ptr<BenchObjectName>>();
+    auto names = std::vector<BenchObjectName*>();
+    for (auto i = uint32_t(0); i < name_count; ++i) {
+        name_storage.push_back(std::make_unique<BenchObjectName>());
+        name_storage.back()->index = int(i << 1);
+        std::snprintf(name_storage.back()->name, sizeof(name_storage.back()->name), "Pg%08x_%u", uint32_t(rng()), i);
+        names.push_back(name_storage.back().get());
+    }
+
+    auto name_index = NameIndex();
+    name_index.Update(names.data(), names.size());
+
+    // Packages, classes in packages and members of classes
+    auto storage = std::vector<std::unique_ptr<BenchObject>>();
+    auto objects = std::vector<BenchObject*>();
+    for (auto i = uint32_t(0); i < object_count; ++i) {
+        auto outer = i < package_count ? nullptr : objects[rng() % (i < package_count * 10 ? package_count : i)];
+        auto name = uint32_t(rng() % name_count);
+        storage.push_back(std::make_unique<BenchObject>(BenchObject { outer, { name, 0 }, nullptr }));
+        objects.push_back(storage.back().get());
+    }
+
+    auto queries = std::vector<std::string>();
+    for (auto i = size_t(0); i < lookups; ++i) {
+        auto item = objects[rng() % object_count];
+        auto path = std::string(names[item->name.index]->name);
+        for (auto outer = item->outer_object; outer; outer = outer->outer_object) {
+            path = std::string(names[outer->name.index]->name) + "." + path;
+        }
+        queries.push_back(path);
+    }
+
+    auto params = BenchmarkParams { { "objects", double(object_count) } };
+
+    auto index = ObjectIndex<BenchObject>();
+    auto build = measure_runs(
+        [&]() {
+            index.Clear();
+            index.Update(objects.data(), objects.size());
+        },
+        3);
+    report(bench, { "build_index", params, 0, 1, index.size(), build });
+
+    auto found = size_t(0);
+    auto linear = measure_runs(
+        [&]() {
+            found = 0;
+            for (const auto& query : queries) {
+                found += linear_find_object(objects.data(), objects.size(), names.data(), query) != nullptr;
+            }
+        },
+        1);
+    report(bench, { "find_object_linear", params, 0, lookups, found, linear });
+
+    auto indexed = measure_runs([&]() {
+        found = 0;
+        for (const auto& query : queries) {
+            ObjectName path[max_object_depth];
+            auto depth = ParseObjectPath(query, name_index, path);
+            found += index.Find(objects.data(), objects.size(), path, depth) != nullptr;
+        }
+    });
+    report(bench, { "find_object_indexed", params, 0, lookups, found, indexed });
+
+    auto update = measure_runs([&]() { index.Update(objects.data(), objects.size()); });
+    report(bench, { "update_unchanged", params, 0, 1, index.size(), update });
+}
@@ -0,0 +1,85 @@
+/*
+ * Copyright (c) 2022-2023, NeKz
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "../src/ObjectMemory.hpp"
+#include "Bench.hpp"
+#include <memory>
+
+namespace {
+struct BenchClass {
+    std::string name;
+    int property_size;
+    uint32_t array_count;
+};
+
+struct BenchObject {
+    BenchObject* outer_object;
+    BenchClass* class_object;
+    struct {
+        void* data;
+        uint32_t size;
+        uint32_t max;
+    } arrays[4];
+};
+
+using Memory = ObjectMemory<BenchObject>;
+}
+
+static auto get_arrays(const BenchClass* class_object, std::vector<Memory::OwnedArray>& arrays) -> void
+{
+    for (auto i = uint32_t(0); i < class_object->array_count; ++i) {
+        arrays.push_back({ int32_t(offsetof(BenchObject, arrays) + i * sizeof(BenchObject::arrays[0])), 4 });
+    }
+}
+
+static auto get_name(const BenchClass* class_object) -> std::string { return class_object->name; }
+static auto get_name(const BenchObject* object) -> std::string { return std::to_string(uintptr_t(object)); }
+
+BENCHMARK(object_memory)
+{
+    const auto class_count = uint32_t(2000);
+    const auto package_count = uint32_t(200);
+    const auto object_count = uint32_t(100'000);
+
+    auto rng = std::mt19937(25);
+
+    auto classes = std::vector<std::unique_ptr<BenchClass>>();
+    for (auto i = uint32_t(0); i < class_count; ++i) {
+        classes.push_back(std::make_unique<BenchClass>(
+            BenchClass { "Class_" + std::to_string(i), int(sizeof(BenchObject)), uint32_t(rng() % 5) }));
+    }
+
+    // Objects live in a package or in an object which was created before them
+    auto storage = std::vector<std::unique_ptr<BenchObject>>();
+    auto objects = std::vector<BenchObject*>();
+    for (auto i = uint32_t(0); i < object_count; ++i) {
+        auto outer = i < package_count ? nullptr : objects[rng() % i];
+        auto object = BenchObject { outer, classes[rng() % class_count].get(), {} };
+        for (auto& array : object.arrays) {
+            array.max = rng() % 64;
+            array.data = array.max ? &array : nullptr;
+        }
+        storage.push_back(std::make_unique<BenchObject>(object));
+        objects.push_back(storage.back().get());
+    }
+
+    auto get_any_name = [](const auto* object) { return get_name(object); };
+    auto bytes = size_t(object_count) * sizeof(BenchObject);
+
+    for (auto budget : { size_t(1024), size_t(8192), size_t(object_count) }) {
+        auto params = BenchmarkParams { { "objects", double(object_count) }, { "budget", double(budget) } };
+
+        auto steps = size_t(0);
+        auto classes_found = size_t(0);
+        auto pass = measure_runs([&]() {
+            auto memory = Memory();
+            for (steps = 1; !memory.Step(objects.data(), objects.size(), budget, get_arrays, get_any_name); ++steps) {
+            }
+            classes_found = memory.GetClasses().size();
+        });
+        report(bench, { "full_pass", params, bytes, steps, classes_found, pass });
+    }
+}
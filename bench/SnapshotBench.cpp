@@ -0,0 +1,133 @@
+/*
+ * Copyright (c) 2022-2023, NeKz
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "../src/SnapshotDiff.hpp"
+#include "Bench.hpp"
+#include <algorithm>
+#include <iterator>
+
+BENCHMARK(snapshot_roundtrip)
+{
+    const auto package_count = uint32_t(100);
+    const auto object_count = uint32_t(100000);
+
+    auto rng = std::mt19937(23);
+
+    auto writer = Snapshot::Writer();
+    for (auto i = uint32_t(0); i < object_count; ++i) {
+        writer.SetName(i, "Name_" + std::to_string(i));
+    }
+
+    // Packages first, then objects with an outer which already exists
+    for (auto i = uint32_t(0); i < object_count; ++i) {
+        auto outer = i < package_count ? Snapshot::none : uint32_t(rng() % i);
+        auto is_struct = i % 10 == 0;
+        writer.SetObject(i,
+            { 0x10000000 + uint64_t(i) * 0x40, i, uint32_t(rng() % 3), outer, uint32_t(rng() % package_count),
+                Snapshot::none, Snapshot::none, Snapshot::none, is_struct ? uint32_t(rng() % 0x1000) : 0 });
+        if (i % 4 == 1) {
+            writer.AddProperty({ i, Snapshot::PropertyKind::Int, int32_t(i % 0x100), 4, 1, 0, 0, Snapshot::none,
+                Snapshot::none, 0 });
+        }
+    }
+
+    auto params = BenchmarkParams { { "objects", double(object_count) } };
+
+    auto data = std::vector<uint8_t>();
+    auto serialize = measure_runs([&]() { data = writer.Serialize(); });
+    report(bench, { "Serialize", params, data.size(), 1, object_count, serialize });
+
+    auto snapshot = Snapshot::Reader();
+    auto open = measure_runs([&]() { snapshot.Open(data.data(), data.size()); });
+    report(bench, { "Open", params, data.size(), 1, snapshot.GetObjects().size(), open });
+
+    auto total = size_t(0);
+    auto paths = measure_runs([&]() {
+        total = 0;
+        for (auto i = uint32_t(0); i < object_count; ++i) {
+            total += snapshot.GetPath(i).size();
+        }
+    });
+    report(bench, { "GetPath", params, data.size(), object_count, total, paths });
+
+    auto found = size_t(0);
+    auto properties = measure_runs([&]() {
+        found = 0;
+        for (auto i = uint32_t(0); i < object_count; ++i) {
+            found += snapshot.FindProperty(i) != nullptr;
+        }
+    });
+    report(bench, { "FindProperty", params, data.size(), object_count, found, properties });
+}
+
+BENCHMARK(snapshot_diff)
+{
+    const auto package_count = uint32_t(100);
+    const auto class_count = uint32_t(500);
+
+    auto rng = std::mt19937(24);
+
+    for (auto object_count : { uint32_t(10000), uint32_t(100000), uint32_t(250000) }) {
+        // 1% each get destroyed, created or reclassified, children of a destroyed outer move to a new path
+        auto before = Snapshot::Writer();
+        auto after = Snapshot::Writer();
+        for (auto i = uint32_t(0); i < object_count; ++i) {
+            before.SetName(i, "Name_" + std::to_string(i));
+            after.SetName(i, "Name_" + std::to_string(i));
+
+            auto outer = i < package_count ? Snapshot::none : uint32_t(rng() % i);
+            auto class_object = package_count + uint32_t(rng() % class_count);
+            auto object = Snapshot::ObjectRecord { 0x10000000 + uint64_t(i) * 0x40, i, 0, outer, class_object,
+                Snapshot::none, Snapshot::none, Snapshot::none, uint32_t(rng() % 0x1000) };
+
+            auto change = i < package_count + class_count ? 100 : rng() % 100;
+            if (change != 0) {
+                before.SetObject(i, object);
+            }
+            if (change == 1) {
+                object.class_object = package_count + uint32_t(rng() % class_count);
+            }
+            if (change != 2) {
+                after.SetObject(i, object);
+            }
+        }
+
+        auto before_data = before.Serialize();
+        auto after_data = after.Serialize();
+        auto before_snapshot = Snapshot::Reader();
+        auto after_snapshot = Snapshot::Reader();
+        before_snapshot.Open(before_data.data(), before_data.size());
+        after_snapshot.Open(after_data.data(), after_data.size());
+
+        auto params = BenchmarkParams { { "objects", double(object_count) } };
+        auto bytes = before_data.size() + after_data.size();
+
+        auto changes = size_t(0);
+        auto diff = measure_runs([&]() { changes = Snapshot::Diff(before_snapshot, after_snapshot).changes.size(); });
+        report(bench, { "Diff", params, bytes, 1, changes, diff });
+
+        // Joining on path strings instead of hashes
+        auto strings = measure_runs([&]() {
+            auto old_paths = std::vector<std::string>();
+            auto new_paths = std::vector<std::string>();
+            for (auto i = uint32_t(0); i < object_count; ++i) {
+                if (before_snapshot.FindObject(i)) {
+                    old_paths.push_back(before_snapshot.GetPath(i));
+                }
+                if (after_snapshot.FindObject(i)) {
+                    new_paths.push_back(after_snapshot.GetPath(i));
+                }
+            }
+            std::sort(old_paths.begin(), old_paths.end());
+            std::sort(new_paths.begin(), new_paths.end());
+            auto difference = std::vector<std::string>();
+            std::set_symmetric_difference(old_paths.begin(), old_paths.end(), new_paths.begin(), new_paths.end(),
+                std::back_inserter(difference));
+            changes = difference.size();
+        });
+        report(bench, { "path_strings", params, bytes, 1, changes, strings });
+    }
+}
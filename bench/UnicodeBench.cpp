@@ -0,0 +1,98 @@
+/*
+ * Copyright (c) 2022-2023, NeKz
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "../src/Unicode.hpp"
+#include "Bench.hpp"
+
+// One code point at a time into a growing string, like most hand written converters
+static auto naive_to_utf8(const char16_t* data, size_t size) -> std::string
+{
+    auto result = std::string();
+    for (auto i = size_t(0); i < size; ++i) {
+        auto code_point = char32_t(data[i]);
+        if (code_point >= 0xD800 && code_point <= 0xDBFF && i + 1 < size && data[i + 1] >= 0xDC00
+            && data[i + 1] <= 0xDFFF) {
+            code_point = 0x10000 + ((code_point - 0xD800) << 10) + (data[++i] - 0xDC00);
+        } else if (code_point >= 0xD800 && code_point <= 0xDFFF) {
+            code_point = 0xFFFD;
+        }
+
+        if (code_point < 0x80) {
+            result += char(code_point);
+        } else if (code_point < 0x800) {
+            result += char(0xC0 | (code_point >> 6));
+            result += char(0x80 | (code_point & 0x3F));
+        } else if (code_point < 0x10000) {
+            result += char(0xE0 | (code_point >> 12));
+            result += char(0x80 | ((code_point >> 6) & 0x3F));
+            result += char(0x80 | (code_point & 0x3F));
+        } else {
+            result += char(0xF0 | (code_point >> 18));
+            result += char(0x80 | ((code_point >> 12) & 0x3F));
+            result += char(0x80 | ((code_point >> 6) & 0x3F));
+            result += char(0x80 | (code_point & 0x3F));
+        }
+    }
+    return result;
+}
+
+BENCHMARK(utf16_to_utf8)
+{
+    const auto string_length = size_t(64);
+    const auto string_count = size_t(16384);
+
+    auto rng = std::mt19937(22);
+
+    struct Case {
+        const char* name;
+        int non_ascii_percent;
+        char16_t non_ascii;
+    };
+
+    // Console commands and constants are ASCII, localized strings are not
+    const Case cases[] = {
+        { "ascii", 0, u'a' },
+        { "latin_5", 5, u'é' },
+        { "latin_50", 50, u'é' },
+        { "cjk_100", 100, u'中' },
+    };
+
+    for (const auto& test : cases) {
+        auto text = std::u16string(string_length * string_count, u' ');
+        for (auto& unit : text) {
+            unit = int(rng() % 100) < test.non_ascii_percent ? test.non_ascii : char16_t(0x20 + rng() % 0x5F);
+        }
+
+        auto params = BenchmarkParams { { "length", double(string_length) } };
+        auto bytes = text.size() * sizeof(char16_t);
+
+        auto total = size_t(0);
+        auto naive = measure_runs([&]() {
+            total = 0;
+            for (auto i = size_t(0); i < string_count; ++i) {
+                total += naive_to_utf8(text.data() + i * string_length, string_length).size();
+            }
+        });
+        report(bench, { std::string("naive_") + test.name, params, bytes, string_count, total, naive });
+
+        auto allocating = measure_runs([&]() {
+            total = 0;
+            for (auto i = size_t(0); i < string_count; ++i) {
+                total += Unicode::ToUtf8(text.data() + i * string_length, string_length).size();
+            }
+        });
+        report(bench, { std::string("string_") + test.name, params, bytes, string_count, total, allocating });
+
+        char buffer[Unicode::MaxUtf8Size(string_length)];
+        auto buffered = measure_runs([&]() {
+            total = 0;
+            for (auto i = size_t(0); i < string_count; ++i) {
+                total += Unicode::ToUtf8(text.data() + i * string_length, string_length, buffer, sizeof(buffer));
+            }
+        });
+        report(bench, { std::string("buffer_") + test.name, params, bytes, string_count, total, buffered });
+    }
+}
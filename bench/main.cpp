@@ -0,0 +1,30 @@
+/*
+ * Copyright (c) 2022-2023, NeKz
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ *
+ * Benchmarks for the platform independent parts of tem.
+ *
+ * Usage:
+ *  bench [filter] [--json results.json]
+ */
+
+#include "Bench.hpp"
+#include <cstring>
+
+int main(int argc, char** argv)
+{
+    const char* filter = nullptr;
+    const char* json_path = nullptr;
+
+    for (auto i = 1; i < argc; ++i) {
+        if (!std::strcmp(argv[i], "--json") && i + 1 < argc) {
+            json_path = argv[++i];
+        } else {
+            filter = argv[i];
+        }
+    }
+
+    return run_all_benchmarks(filter, json_path);
+}
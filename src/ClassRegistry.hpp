@@ -0,0 +1,228 @@
+/*
+ * Copyright (c) 2022-2023, NeKz
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string_view>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+/*
+ * Live instances of every class in contiguous per-class arrays.
+ *
+ * Update keeps a record of the object in every slot of the object table.
+ * Slots past the last update always get checked, slots which were there
+ * before get swept in chunks of budget slots per call so that keeping the
+ * registry current costs a bounded amount of work per tick. Freed or reused
+ * slots are picked up once the sweep reaches them and ForEach skips
+ * instances whose slot changed in the meantime. Querying a class visits the
+ * instances of the class and of all its subclasses through super_field, the
+ * subclasses of a class are cached until a new class shows up. Object has to
+ * provide class_object like UObject. Not thread-safe.
+ */
+template <typename Object, typename Class = std::remove_pointer_t<decltype(Object::class_object)>>
+class ClassRegistry {
+private:
+    using Field = std::remove_pointer_t<decltype(Class::super_field)>;
+
+    struct Instance {
+        Object* object;
+        uint32_t slot;
+    };
+
+    struct Bucket {
+        const Class* class_object;
+        std::vector<Instance> instances;
+    };
+
+    struct Record {
+        Object* object;
+        Bucket* bucket; // Null if the slot is empty or has no class
+        uint32_t position; // Index into the instances of the bucket
+    };
+
+    std::vector<Record> records; // Object of every slot at the last update
+    std::vector<std::unique_ptr<Bucket>> buckets;
+    std::unordered_map<const Class*, Bucket*> by_class;
+    std::unordered_map<const Class*, std::vector<const Bucket*>> subclasses;
+    size_t cursor = 0;
+    size_t count = 0;
+
+    auto Unlink(uint32_t slot) -> void
+    {
+        auto& record = this->records[slot];
+        if (record.bucket) {
+            // Swap with the last instance to keep the array contiguous
+            auto& instances = record.bucket->instances;
+            auto last = instances.back();
+            instances[record.position] = last;
+            this->records[last.slot].position = record.position;
+            instances.pop_back();
+            --this->count;
+        }
+        record = { nullptr, nullptr, 0 };
+    }
+
+    auto Sync(Object* const* entries, uint32_t slot) -> bool
+    {
+        auto object = entries[slot];
+        auto class_object = object ? static_cast<const Class*>(object->class_object) : nullptr;
+
+        auto& record = this->records[slot];
+        if (record.object == object && (record.bucket ? record.bucket->class_object : nullptr) == class_object) {
+            return false;
+        }
+
+        this->Unlink(slot);
+        record.object = object;
+
+        if (class_object) {
+            auto& bucket = this->by_class[class_object];
+            if (!bucket) {
+                this->buckets.push_back(std::make_unique<Bucket>(Bucket { class_object, {} }));
+                bucket = this->buckets.back().get();
+                this->subclasses.clear();
+            }
+
+            record.bucket = bucket;
+            record.position = uint32_t(bucket->instances.size());
+            bucket->instances.push_back({ object, slot });
+            ++this->count;
+        }
+
+        return true;
+    }
+
+    auto GetSubclasses(const Class* class_object) -> const std::vector<const Bucket*>&
+    {
+        auto [entry, inserted] = this->subclasses.try_emplace(class_object);
+        if (inserted) {
+            auto base = static_cast<const Field*>(class_object);
+            for (const auto& bucket : this->buckets) {
+                // The depth limit guards against a broken super_field chain
+                auto depth = 0;
+                for (const Field* field = bucket->class_object; field && depth < 256; field = field->super_field) {
+                    if (field == base) {
+                        entry->second.push_back(bucket.get());
+                        break;
+                    }
+                    ++depth;
+                }
+            }
+        }
+        return entry->second;
+    }
+
+public:
+    /*
+     * Checks the slots past the last update and budget slots which were
+     * there before, every one of them if budget is zero. Returns the number
+     * of slots which changed.
+     */
+    auto Update(Object* const* entries, size_t size, size_t budget = 0) -> size_t
+    {
+        auto changes = size_t(0);
+        auto previous = this->records.size();
+
+        for (auto slot = size; slot < previous; ++slot) {
+            this->Unlink(uint32_t(slot));
+        }
+        this->records.resize(size, Record { nullptr, nullptr, 0 });
+
+        for (auto slot = previous; slot < size; ++slot) {
+            changes += this->Sync(entries, uint32_t(slot));
+        }
+
+        auto swept = (std::min)(previous, size);
+        if (!swept) {
+            return changes;
+        }
+
+        if (!budget || budget > swept) {
+            budget = swept;
+        }
+
+        for (auto i = size_t(0); i < budget; ++i) {
+            if (this->cursor >= swept) {
+                this->cursor = 0;
+            }
+            changes += this->Sync(entries, uint32_t(this->cursor++));
+        }
+
+        return changes;
+    }
+
+    /*
+     * Calls callback with every instance of class_object or of a subclass.
+     * Entries have to be the current object table.
+     */
+    template <typename Callback>
+    auto ForEach(Object* const* entries, size_t size, const Class* class_object, Callback callback) -> size_t
+    {
+        auto visited = size_t(0);
+        if (!class_object) {
+            return visited;
+        }
+
+        for (auto bucket : this->GetSubclasses(class_object)) {
+            for (const auto& instance : bucket->instances) {
+                // The slot might have been freed or reused since the sweep passed it
+                auto object = instance.slot < size ? entries[instance.slot] : nullptr;
+                if (object != instance.object
+                    || static_cast<const Class*>(object->class_object) != bucket->class_object) {
+                    continue;
+                }
+
+                callback(object);
+                ++visited;
+            }
+        }
+
+        return visited;
+    }
+
+    /*
+     * Tells if object is an instance in a world rather than a template which
+     * new instances get copied from. Writing to a class default object or an
+     * archetype changes every instance created afterwards. Class default
+     * objects are named Default__ and templates live in packages, instances
+     * in a world have an object of level_class as their outer. get_name gets
+     * called with object, Object has to provide outer_object like UObject.
+     */
+    template <typename GetName>
+    static auto IsWorldInstance(const Object* object, const Class* level_class, GetName get_name) -> bool
+    {
+        if (!object || !level_class) {
+            return false;
+        }
+
+        auto name = get_name(object);
+        if (std::string_view(name).starts_with("Default__")) {
+            return false;
+        }
+
+        auto outer = object->outer_object;
+        return outer && static_cast<const Class*>(outer->class_object) == level_class;
+    }
+
+    auto Clear() -> void
+    {
+        this->records.clear();
+        this->buckets.clear();
+        this->by_class.clear();
+        this->subclasses.clear();
+        this->cursor = 0;
+        this->count = 0;
+    }
+
+    inline auto size() const -> size_t { return this->records.size(); }
+    inline auto GetInstanceCount() const -> size_t { return this->count; }
+    inline auto GetClassCount() const -> size_t { return this->buckets.size(); }
+};
@@ -6,16 +6,31 @@
 
 #include "Dumper.hpp"
 #include "Console.hpp"
+#include "Memory.hpp"
 #include "Offsets.hpp"
 #include "SDK.hpp"
+#include "SnapshotDiff.hpp"
 #include "TEM.hpp"
 #include "lib/json/json.hpp"
 #include <format>
 #include <fstream>
 #include <set>
+#include <unordered_map>
+#include <vector>
+
+/*
+ * Objects and names come straight from game memory, every pointer gets
+ * checked against the region map before it is followed.
+ */
+static auto has_name(FNameEntry* entry) -> bool
+{
+    return Memory::IsReadable(uintptr_t(entry), offsetof(FNameEntry, name) + 1);
+}
 
 auto dump_engine() -> void
 {
+    Memory::RefreshRegions();
+
     auto g_Names = reinterpret_cast<TArray<FNameEntry*>*>(Offsets::g_Names);
     println("[dumper] g_Names: 0x{:04x} (size = {})", uintptr_t(g_Names), g_Names->size);
 
@@ -27,7 +42,7 @@ auto dump_engine() -> void
     for (auto i = 0u; i < g_Names->size; ++i) {
         auto item = names[i];
 
-        if (item && item->index == i << 1 && item->name) {
+        if (has_name(item) && item->index == i << 1) {
             name_stream << std::format("{} // 0x{:x}\n", item->name, item->index >> 1);
         }
     }
@@ -35,28 +50,37 @@ auto dump_engine() -> void
     auto g_Objects = reinterpret_cast<TArray<UObject*>*>(Offsets::g_Objects);
     println("[dumper] g_Objects: 0x{:04x} (size = {})", uintptr_t(g_Objects), g_Objects->size);
 
+    // Indices of a stale object can be past the end of the table, at() returns null then
+    auto get_name = [g_Names](FName name) -> const char* {
+        auto entry = g_Names->at(name.index);
+        return has_name(entry) ? entry->name : "";
+    };
+
     auto objects = g_Objects->data;
     std::ofstream object_stream("trom_evolution_objects_dump.txt");
 
     for (auto i = 0u; i < g_Objects->size; ++i) {
         auto item = objects[i];
-        if (!item || !item->name.index) {
+        if (!Memory::IsReadable(item) || !item->name.index) {
             continue;
         }
 
-        auto base_name = std::string(names[item->name.index] ? names[item->name.index]->name : "");
+        auto base_name = std::string(get_name(item->name));
 
-        auto outer_name = std::string();
+        // Outer names get collected innermost first and appended in reverse
+        auto outers = std::vector<const char*>();
         auto outer = item->outer_object;
-        while (outer) {
-            outer_name
-                = std::string(names[outer->name.index] ? names[outer->name.index]->name : "") + "::" + outer_name;
+        while (Memory::IsReadable(outer) && outers.size() < 256) {
+            outers.push_back(get_name(outer->name));
             outer = outer->outer_object;
         }
 
-        auto class_name = std::string(item->class_object && names[item->class_object->name.index]
-                ? names[item->class_object->name.index]->name
-                : "");
+        auto outer_name = std::string();
+        for (auto name = outers.rbegin(); name != outers.rend(); ++name) {
+            outer_name.append(*name).append("::");
+        }
+
+        auto class_name = std::string(Memory::IsReadable(item->class_object) ? get_name(item->class_object->name) : "");
 
         auto dump = std::format("{}{}({}) // 0x{:x}\n", outer_name, base_name, class_name, uintptr_t(item));
 
@@ -66,27 +90,31 @@ auto dump_engine() -> void
 
 auto dump_engine_to_markdown() -> void
 {
+    Memory::RefreshRegions();
+
     std::ofstream stream("classes.md");
     std::ofstream navigation("classes_navigation.md");
 
     auto g_Objects = *reinterpret_cast<TArray<UObject*>*>(Offsets::g_Objects);
     auto g_Names = *reinterpret_cast<TArray<FNameEntry*>*>(Offsets::g_Names);
 
-    auto get_name
-        = [&g_Names](FName& name) -> const char* { return g_Names[name.index] ? g_Names[name.index]->name : "unk"; };
+    auto get_name = [&g_Names](FName& name) -> const char* {
+        return has_name(g_Names[name.index]) ? g_Names[name.index]->name : "unk";
+    };
 
     auto get_object_name = [&g_Names](UObject* object) -> const char* {
-        return object && g_Names[object->name.index] ? g_Names[object->name.index]->name : "unk";
+        return Memory::IsReadable(object) && has_name(g_Names[object->name.index]) ? g_Names[object->name.index]->name
+                                                                                    : "unk";
     };
 
     auto get_outer_object_name = [&g_Names](UObject* object) -> const char* {
-        return object->outer_object && g_Names[object->outer_object->name.index]
+        return Memory::IsReadable(object->outer_object) && has_name(g_Names[object->outer_object->name.index])
             ? g_Names[object->outer_object->name.index]->name
             : "unk";
     };
 
     auto get_class_object_name = [&g_Names](UObject* object) -> const char* {
-        return object->class_object && g_Names[object->class_object->name.index]
+        return Memory::IsReadable(object->class_object) && has_name(g_Names[object->class_object->name.index])
             ? g_Names[object->class_object->name.index]->name
             : "unk";
     };
@@ -143,7 +171,7 @@ auto dump_engine_to_markdown() -> void
 
     foreach_item(item, g_Objects)
     {
-        if (!item || !item->name.index) {
+        if (!Memory::IsReadable(item) || !item->name.index) {
             continue;
         }
 
@@ -171,7 +199,7 @@ auto dump_engine_to_markdown() -> void
             stream << "Inherits: ";
 
             auto super_field = class_object->super_field;
-            while (super_field) {
+            while (Memory::IsReadable(super_field)) {
                 auto super_field_name = get_object_name(super_field);
 
                 stream << "[" << super_field_name << "](#";
@@ -205,7 +233,7 @@ auto dump_engine_to_markdown() -> void
             auto has_enums = false;
             auto has_functions = false;
 
-            while (child_field) {
+            while (Memory::IsReadable(child_field)) {
                 auto type_name = get_class_object_name(child_field);
 
                 if (strstr(type_name, "Property")) {
@@ -233,7 +261,7 @@ auto dump_engine_to_markdown() -> void
                 stream << "|---|:-:|:-:|:-:|" << std::endl;
 
                 child_field = class_object->children;
-                while (child_field) {
+                while (Memory::IsReadable(child_field)) {
                     auto child_name = get_object_name(child_field);
                     auto type_name = get_class_object_name(child_field);
 
@@ -258,7 +286,7 @@ auto dump_engine_to_markdown() -> void
                 stream << "|---|" << std::endl;
 
                 child_field = class_object->children;
-                while (child_field) {
+                while (Memory::IsReadable(child_field)) {
                     auto type_name = get_class_object_name(child_field);
 
                     if (strcmp(type_name, "State") == 0) {
@@ -277,7 +305,7 @@ auto dump_engine_to_markdown() -> void
                                     has_parameters = true;
                                 }
 
-                                while (state_parameter) {
+                                while (Memory::IsReadable(state_parameter)) {
                                     stream << "<br>&nbsp;&nbsp;&nbsp;&nbsp;" << get_object_name(state_parameter) << ": "
                                            << resolve_type(state_parameter) << ",";
 
@@ -307,7 +335,7 @@ auto dump_engine_to_markdown() -> void
                 stream << "|---|" << std::endl;
 
                 child_field = class_object->children;
-                while (child_field) {
+                while (Memory::IsReadable(child_field)) {
                     auto type_name = get_class_object_name(child_field);
 
                     if (strcmp(type_name, "Function") == 0) {
@@ -319,7 +347,7 @@ auto dump_engine_to_markdown() -> void
                         auto return_value_type = std::string("()");
                         auto has_parameters = false;
 
-                        while (function_parameter) {
+                        while (Memory::IsReadable(function_parameter)) {
                             auto parameter_name = get_object_name(function_parameter);
                             auto parameter_type = get_class_object_name(function_parameter);
 
@@ -356,7 +384,7 @@ auto dump_engine_to_markdown() -> void
                 stream << "|---|" << std::endl;
 
                 child_field = class_object->children;
-                while (child_field) {
+                while (Memory::IsReadable(child_field)) {
                     auto child_name = get_object_name(child_field);
                     auto type_name = get_class_object_name(child_field);
 
@@ -387,7 +415,7 @@ auto dump_engine_to_markdown() -> void
                 stream << "|---|:-:|" << std::endl;
 
                 child_field = class_object->children;
-                while (child_field) {
+                while (Memory::IsReadable(child_field)) {
                     auto child_name = get_object_name(child_field);
                     auto type_name = get_class_object_name(child_field);
 
@@ -410,7 +438,7 @@ auto dump_engine_to_markdown() -> void
                 stream << "|---|:-:|" << std::endl;
 
                 child_field = class_object->children;
-                while (child_field) {
+                while (Memory::IsReadable(child_field)) {
                     auto child_name = get_object_name(child_field);
                     auto type_name = get_class_object_name(child_field);
 
@@ -420,7 +448,7 @@ auto dump_engine_to_markdown() -> void
                         auto script_struct = child_field->as<UScriptStruct>();
                         auto struct_member = script_struct->children;
 
-                        while (struct_member) {
+                        while (Memory::IsReadable(struct_member)) {
                             auto member_name = get_object_name(struct_member);
                             auto member_type = get_class_object_name(struct_member);
 
@@ -430,7 +458,7 @@ auto dump_engine_to_markdown() -> void
                                 auto member_script_struct = struct_member->as<UScriptStruct>();
                                 auto member_struct_member = member_script_struct->children;
 
-                                while (member_struct_member) {
+                                while (Memory::IsReadable(member_struct_member)) {
                                     auto member_struct_name = get_object_name(member_struct_member);
                                     auto member_struct_property = member_struct_member->as<UProperty>();
 
@@ -475,31 +503,36 @@ auto dump_engine_to_markdown() -> void
 
 auto dump_engine_to_json() -> void
 {
+    Memory::RefreshRegions();
+
     auto g_Objects = *reinterpret_cast<TArray<UObject*>*>(Offsets::g_Objects);
     auto g_Names = *reinterpret_cast<TArray<FNameEntry*>*>(Offsets::g_Names);
 
-    auto get_name
-        = [&g_Names](FName& name) -> const char* { return g_Names[name.index] ? g_Names[name.index]->name : "unk"; };
+    auto get_name = [&g_Names](FName& name) -> const char* {
+        return has_name(g_Names[name.index]) ? g_Names[name.index]->name : "unk";
+    };
 
     auto get_object_name = [&g_Names](UObject* object) -> const char* {
-        return object && g_Names[object->name.index] ? g_Names[object->name.index]->name : "unk";
+        return Memory::IsReadable(object) && has_name(g_Names[object->name.index]) ? g_Names[object->name.index]->name
+                                                                                    : "unk";
     };
 
     auto get_outer_object_name = [&g_Names](UObject* object) -> const char* {
-        return object->outer_object && g_Names[object->outer_object->name.index]
+        return Memory::IsReadable(object->outer_object) && has_name(g_Names[object->outer_object->name.index])
             ? g_Names[object->outer_object->name.index]->name
             : "unk";
     };
 
     auto get_class_object_name = [&g_Names](UObject* object) -> const char* {
-        return object->class_object && g_Names[object->class_object->name.index]
+        return Memory::IsReadable(object->class_object) && has_name(g_Names[object->class_object->name.index])
             ? g_Names[object->class_object->name.index]->name
             : "unk";
     };
 
     auto get_function_friendly_name = [&g_Names](UFunction* function) -> const char* {
-        return function && g_Names[function->friendly_name.index] ? g_Names[function->friendly_name.index]->name
-                                                                  : "unk";
+        return Memory::IsReadable(function) && has_name(g_Names[function->friendly_name.index])
+            ? g_Names[function->friendly_name.index]->name
+            : "unk";
     };
 
     std::function<std::string(UField*)> resolve_type;
@@ -603,7 +636,7 @@ auto dump_engine_to_json() -> void
                 auto has_return_value = false;
 
                 auto function_parameter = type_object->children;
-                while (function_parameter) {
+                while (Memory::IsReadable(function_parameter)) {
                     auto parameter_name = get_object_name(function_parameter);
 
                     if (strcmp(parameter_name, "ReturnValue") == 0 && !has_return_value) {
@@ -632,7 +665,7 @@ auto dump_engine_to_json() -> void
                 auto members = Json::array();
 
                 auto struct_member = type_object->children;
-                while (struct_member) {
+                while (Memory::IsReadable(struct_member)) {
                     auto member = Json::object();
                     member["name"] = get_object_name(struct_member);
                     member["nameNumber"] = struct_member->name.number;
@@ -642,7 +675,7 @@ auto dump_engine_to_json() -> void
                         auto struct_members = Json::array();
 
                         auto member_struct_member = struct_member->as<UScriptStruct>()->children;
-                        while (member_struct_member) {
+                        while (Memory::IsReadable(member_struct_member)) {
                             auto member_struct_member_property = member_struct_member->as<UProperty>();
                             struct_members += {
                                 { "name", get_object_name(member_struct_member) },
@@ -764,7 +797,7 @@ auto dump_engine_to_json() -> void
                         auto parameters = Json::array();
 
                         auto state_parameter = state_child->super_field->as<UState>()->children;
-                        while (state_parameter) {
+                        while (Memory::IsReadable(state_parameter)) {
                             parameters += {
                                 { "name", get_object_name(state_parameter) },
                                 { "nameNumber", state_parameter->name.index },
@@ -785,7 +818,7 @@ auto dump_engine_to_json() -> void
 
         foreach_item(item, g_Objects)
         {
-            if (!item || !item->name.index) {
+            if (!Memory::IsReadable(item) || !item->name.index) {
                 continue;
             }
 
@@ -799,7 +832,7 @@ auto dump_engine_to_json() -> void
             auto children = Json::array();
             auto child_field = class_object->children;
 
-            while (child_field) {
+            while (Memory::IsReadable(child_field)) {
                 auto child = Json::object();
 
                 add_field_data(child, child_field);
@@ -812,7 +845,7 @@ auto dump_engine_to_json() -> void
 
             if (class_object->super_field) {
                 auto super_field = class_object->super_field;
-                while (super_field) {
+                while (Memory::IsReadable(super_field)) {
                     inherits += {
                         { "name", get_object_name(super_field) },
                         { "propertySize", super_field->class_object ? super_field->class_object->property_size : 0 },
@@ -836,6 +869,245 @@ auto dump_engine_to_json() -> void
     }
 }
 
+/*
+ * Copies names, objects and fields into snapshot records.
+ */
+static auto capture_engine_snapshot() -> Snapshot::Writer
+{
+    Memory::RefreshRegions();
+
+    auto g_Names = *reinterpret_cast<TArray<FNameEntry*>*>(Offsets::g_Names);
+    auto g_Objects = *reinterpret_cast<TArray<UObject*>*>(Offsets::g_Objects);
+
+    auto writer = Snapshot::Writer();
+
+    for (auto i = 0u; i < g_Names.size; ++i) {
+        auto item = g_Names.data[i];
+        if (has_name(item) && item->index == i << 1) {
+            writer.SetName(i, item->name);
+        }
+    }
+
+    // Records reference objects by their index in g_Objects
+    auto indices = std::unordered_map<uintptr_t, uint32_t>();
+    indices.reserve(g_Objects.size);
+    for (auto i = 0u; i < g_Objects.size; ++i) {
+        if (Memory::IsReadable(g_Objects.data[i])) {
+            indices.emplace(uintptr_t(g_Objects.data[i]), i);
+        }
+    }
+
+    auto index_of = [&indices](const void* object) -> uint32_t {
+        auto entry = indices.find(uintptr_t(object));
+        return entry != indices.end() ? entry->second : Snapshot::none;
+    };
+
+    auto get_class_name = [&g_Names](UObject* object) -> std::string_view {
+        return Memory::IsReadable(object->class_object) && has_name(g_Names[object->class_object->name.index])
+            ? g_Names[object->class_object->name.index]->name
+            : "";
+    };
+
+    auto properties = 0u;
+    for (auto i = 0u; i < g_Objects.size; ++i) {
+        auto item = g_Objects.data[i];
+        if (!Memory::IsReadable(item)) {
+            continue;
+        }
+
+        auto record = Snapshot::ObjectRecord {
+            uintptr_t(item),
+            item->name.index,
+            item->name.number,
+            index_of(item->outer_object),
+            index_of(item->class_object),
+            Snapshot::none,
+            Snapshot::none,
+            Snapshot::none,
+            0,
+        };
+
+        auto type_name = get_class_name(item);
+        auto is_property = type_name.ends_with("Property");
+        auto is_struct = type_name == "Class" || type_name == "State" || type_name == "Function"
+            || type_name == "ScriptStruct";
+        auto is_field = is_property || is_struct || type_name == "Enum" || type_name == "Const";
+
+        if (is_field && Memory::IsReadable(item->as<UField>())) {
+            record.super_field = index_of(item->as<UField>()->super_field);
+            record.next = index_of(item->as<UField>()->next);
+        }
+
+        if (is_struct && Memory::IsReadable(item->as<UStruct>())) {
+            record.children = index_of(item->as<UStruct>()->children);
+            record.property_size = uint32_t(item->as<UStruct>()->property_size);
+        }
+
+        if (is_property && Memory::IsReadable(item->as<UMapProperty>())) {
+            auto property = item->as<UProperty>();
+            auto kind = Snapshot::GetPropertyKind(type_name);
+
+            auto inner = Snapshot::none;
+            auto value = Snapshot::none;
+            switch (kind) {
+            case Snapshot::PropertyKind::Byte:
+                inner = index_of(item->as<UByteProperty>()->enum_object);
+                break;
+            case Snapshot::PropertyKind::Object:
+                inner = index_of(item->as<UObjectProperty>()->property_class);
+                break;
+            case Snapshot::PropertyKind::Class:
+                inner = index_of(item->as<UClassProperty>()->meta_class);
+                break;
+            case Snapshot::PropertyKind::Interface:
+                inner = index_of(item->as<UInterfaceProperty>()->interface_class);
+                break;
+            case Snapshot::PropertyKind::Struct:
+                inner = index_of(item->as<UStructProperty>()->property_struct);
+                break;
+            case Snapshot::PropertyKind::Array:
+                inner = index_of(item->as<UArrayProperty>()->inner);
+                break;
+            case Snapshot::PropertyKind::Map:
+                inner = index_of(item->as<UMapProperty>()->key);
+                value = index_of(item->as<UMapProperty>()->value);
+                break;
+            case Snapshot::PropertyKind::Component:
+                inner = index_of(item->as<UComponentProperty>()->component);
+                break;
+            default:
+                break;
+            }
+
+            writer.AddProperty({
+                i,
+                kind,
+                property->offset,
+                uint32_t(property->element_size),
+                uint32_t(property->array_dim),
+                uint32_t(property->property_flags),
+                kind == Snapshot::PropertyKind::Bool ? uint32_t(item->as<UBoolProperty>()->bit_mask) : 0,
+                inner,
+                value,
+                0,
+            });
+            ++properties;
+        }
+
+        if (type_name == "Enum" && Memory::IsReadable(item->as<UEnum>())) {
+            auto names = std::vector<uint32_t>();
+            auto enum_names = item->as<UEnum>()->names;
+            if (Memory::IsReadable(uintptr_t(enum_names.data), enum_names.size * sizeof(FName))) {
+                for (auto n = 0u; n < enum_names.size; ++n) {
+                    names.push_back(enum_names.data[n].index);
+                }
+            }
+            writer.AddEnum(i, names);
+        }
+
+        if (type_name == "Const" && Memory::IsReadable(item->as<UConst>())) {
+            const auto& value = item->as<UConst>()->value;
+            if (Memory::IsReadable(uintptr_t(value.data), value.size * sizeof(wchar_t))) {
+                writer.AddConst(i, value.str());
+            }
+        }
+
+        writer.SetObject(i, record);
+    }
+
+    println("[dumper] Captured {} names, {} objects and {} properties", g_Names.size, indices.size(), properties);
+    return writer;
+}
+
+auto dump_engine_to_snapshot() -> void
+{
+    auto path = "tron_evolution.snapshot";
+    if (!capture_engine_snapshot().Save(path)) {
+        return println("[dumper] Unable to write {} :(", path);
+    }
+
+    println("[dumper] Wrote {}", path);
+}
+
+// Serialized capture which later captures get compared against
+static auto snapshot_baseline = std::vector<uint8_t>();
+
+auto capture_engine_snapshot_baseline() -> void { snapshot_baseline = capture_engine_snapshot().Serialize(); }
+
+auto dump_engine_snapshot_diff() -> void
+{
+    if (snapshot_baseline.empty()) {
+        return println("[dumper] Capture a baseline before comparing objects");
+    }
+
+    auto current = capture_engine_snapshot().Serialize();
+
+    auto before = Snapshot::Reader();
+    auto after = Snapshot::Reader();
+    if (!before.Open(snapshot_baseline.data(), snapshot_baseline.size())
+        || !after.Open(current.data(), current.size())) {
+        return println("[dumper] Unable to read snapshots :(");
+    }
+
+    auto diff = Snapshot::Diff(before, after);
+
+    auto created = 0u;
+    auto destroyed = 0u;
+    auto reclassified = 0u;
+    for (const auto& change : diff.changes) {
+        created += change.kind == Snapshot::ChangeKind::Created;
+        destroyed += change.kind == Snapshot::ChangeKind::Destroyed;
+        reclassified += change.kind == Snapshot::ChangeKind::Reclassified;
+    }
+
+    println("[dumper] {} created, {} destroyed, {} reclassified and {} unchanged objects", created, destroyed,
+        reclassified, diff.unchanged);
+
+    auto get_path = [&](const Snapshot::ChangeSummary& summary) -> std::string {
+        return summary.after != Snapshot::none ? after.GetPath(summary.after) : before.GetPath(summary.before);
+    };
+
+    std::ofstream stream("tron_evolution_diff.md");
+
+    auto write_summaries = [&](const char* title, const std::vector<Snapshot::ChangeSummary>& summaries) {
+        stream << "## " << title << std::endl << std::endl;
+        stream << "|Name|Created|Destroyed|Reclassified|Created Bytes|Destroyed Bytes|" << std::endl;
+        stream << "|---|:-:|:-:|:-:|:-:|:-:|" << std::endl;
+        for (const auto& summary : summaries) {
+            auto path = get_path(summary);
+            stream << "|" << (path.empty() ? "None" : path) << "|" << summary.created << "|" << summary.destroyed
+                   << "|" << summary.reclassified << "|" << summary.created_bytes << "|" << summary.destroyed_bytes
+                   << "|" << std::endl;
+        }
+        stream << std::endl;
+    };
+
+    stream << "# Object Diff" << std::endl << std::endl;
+    write_summaries("Classes", diff.classes);
+    write_summaries("Packages", diff.packages);
+
+    stream << "## Objects" << std::endl << std::endl;
+    stream << "|Change|Object|Class|" << std::endl;
+    stream << "|---|---|---|" << std::endl;
+    for (const auto& change : diff.changes) {
+        auto kind = change.kind == Snapshot::ChangeKind::Created ? "Created"
+            : change.kind == Snapshot::ChangeKind::Destroyed     ? "Destroyed"
+                                                                 : "Reclassified";
+        const auto& snapshot = change.after != Snapshot::none ? after : before;
+        auto object = change.after != Snapshot::none ? change.after : change.before;
+        stream << "|" << kind << "|" << snapshot.GetPath(object) << "|"
+               << snapshot.GetPath(snapshot.GetObjects()[object].class_object) << "|" << std::endl;
+    }
+
+    for (auto i = size_t(0); i < diff.classes.size() && i < 10; ++i) {
+        const auto& summary = diff.classes[i];
+        println("[dumper] {} +{} -{} ~{} ({} bytes)", get_path(summary), summary.created, summary.destroyed,
+            summary.reclassified, int64_t(summary.created_bytes) - int64_t(summary.destroyed_bytes));
+    }
+
+    println("[dumper] Wrote tron_evolution_diff.md");
+}
+
 auto dump_console_commands() -> void
 {
     if (!tem.engine() || !tem.engine()->viewport_client || !tem.engine()->viewport_client->viewport_console) {
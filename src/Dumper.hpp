@@ -9,4 +9,7 @@
 extern auto dump_engine() -> void;
 extern auto dump_engine_to_markdown() -> void;
 extern auto dump_engine_to_json() -> void;
+extern auto dump_engine_to_snapshot() -> void;
+extern auto capture_engine_snapshot_baseline() -> void;
+extern auto dump_engine_snapshot_diff() -> void;
 extern auto dump_console_commands() -> void;
@@ -0,0 +1,96 @@
+/*
+ * Copyright (c) 2022-2023, NeKz
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "Events.hpp"
+#include <algorithm>
+#include <mutex>
+
+struct Registration {
+    uint32_t id;
+    uint32_t object;
+    uint32_t function;
+    Events::Handler handler;
+};
+
+std::atomic<const Events::Table*> Events::current = nullptr;
+
+static std::mutex registrations_mutex;
+static std::vector<Registration> registrations;
+static std::vector<std::unique_ptr<Events::Table>> tables; // Published tables, the last one is current
+static uint32_t next_id = 1;
+
+/*
+ * Builds a table of every registration and publishes it. Caller holds the mutex.
+ */
+static auto publish() -> void
+{
+    auto table = std::make_unique<Events::Table>();
+
+    auto size = uint32_t(0);
+    for (const auto& registration : registrations) {
+        size = (std::max)(size, registration.object + 1);
+    }
+
+    auto buckets = std::vector<std::vector<Events::Entry>*>(size, nullptr);
+
+    for (const auto& registration : registrations) {
+        auto& bucket = buckets[registration.object];
+        if (!bucket) {
+            table->buckets.push_back(std::make_unique<std::vector<Events::Entry>>());
+            bucket = table->buckets.back().get();
+        }
+
+        bucket->push_back({ registration.function, registration.handler });
+    }
+
+    table->objects.assign(buckets.begin(), buckets.end());
+
+    Events::current.store(registrations.empty() ? nullptr : table.get(), std::memory_order_release);
+    tables.push_back(std::move(table));
+}
+
+auto Events::Register(uint32_t objectName, uint32_t functionName, Handler handler) -> uint32_t
+{
+    if (!handler) {
+        return 0;
+    }
+
+    auto lock = std::unique_lock(registrations_mutex);
+
+    auto id = next_id++;
+    registrations.push_back({ id, objectName, functionName, handler });
+    publish();
+    return id;
+}
+auto Events::Remove(uint32_t id) -> bool
+{
+    auto lock = std::unique_lock(registrations_mutex);
+
+    auto registration = std::find_if(registrations.begin(), registrations.end(), [id](const Registration& item) {
+        return item.id == id;
+    });
+
+    if (registration == registrations.end()) {
+        return false;
+    }
+
+    registrations.erase(registration);
+    publish();
+    return true;
+}
+auto Events::Clear() -> void
+{
+    auto lock = std::unique_lock(registrations_mutex);
+
+    Events::current.store(nullptr, std::memory_order_release);
+    registrations.clear();
+    tables.clear();
+}
+auto Events::GetHandlerCount() -> size_t
+{
+    auto lock = std::unique_lock(registrations_mutex);
+    return registrations.size();
+}
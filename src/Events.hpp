@@ -0,0 +1,85 @@
+/*
+ * Copyright (c) 2022-2023, NeKz
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+struct UObject;
+struct UFunction;
+
+/*
+ * Dispatch table for ProcessEvent keyed by the FName index of the object and
+ * of the function.
+ *
+ * The table is a flat array indexed by the object name. An event without a
+ * handler for its object costs one bounds-checked load. Registering or
+ * removing a handler builds a new table and publishes it atomically, the
+ * hot path never takes a lock. Replaced tables are kept until Clear because
+ * another thread might still be dispatching through them.
+ */
+namespace Events {
+
+/*
+ * Returning false skips the original ProcessEvent and every later handler.
+ */
+using Handler = auto (*)(UObject* object, UFunction* func, void* params) -> bool;
+
+struct Entry {
+    uint32_t function;
+    Handler handler;
+};
+
+struct Table {
+    std::vector<const std::vector<Entry>*> objects; // Indexed by object name, null if nothing is registered
+    std::vector<std::unique_ptr<std::vector<Entry>>> buckets;
+};
+
+extern std::atomic<const Table*> current;
+
+/*
+ * Handlers of the same key run in registration order. Returns an id for
+ * Remove, zero if the handler is null.
+ */
+auto Register(uint32_t objectName, uint32_t functionName, Handler handler) -> uint32_t;
+auto Remove(uint32_t id) -> bool;
+
+/*
+ * Drops every handler and frees all tables. Nothing may dispatch while or
+ * after this runs, e.g. call it once the ProcessEvent hook is removed.
+ */
+auto Clear() -> void;
+
+auto GetHandlerCount() -> size_t;
+
+/*
+ * Runs the handlers for the event. Returns false if the original should be
+ * skipped.
+ */
+inline auto Dispatch(uint32_t objectName, uint32_t functionName, UObject* object, UFunction* func, void* params)
+    -> bool
+{
+    auto table = Events::current.load(std::memory_order_acquire);
+    if (!table || objectName >= table->objects.size()) {
+        return true;
+    }
+
+    auto bucket = table->objects[objectName];
+    if (!bucket) {
+        return true;
+    }
+
+    for (const auto& entry : *bucket) {
+        if (entry.function == functionName && !entry.handler(object, func, params)) {
+            return false;
+        }
+    }
+    return true;
+}
+}
@@ -628,10 +628,13 @@ auto xlive_debug_break(bool resume_main_thread = true) -> void
 #define JUMP_TO(address) __asm jmp address
 
 #define CALL_ORIGINAL(_ordinal, _name, ...)                                                                            \
+    HOOK_STATS(_name);                                                                                                 \
     auto ordinal = _ordinal;                                                                                           \
     auto name = _name;                                                                                                 \
     auto original = xlive_##_ordinal;                                                                                  \
-    auto result = original(##__VA_ARGS__)
+    hook_stats.Pause();                                                                                                \
+    auto result = original(##__VA_ARGS__);                                                                             \
+    hook_stats.Resume()
 
 #define CALL_ORIGINAL_AND_RETURN(ordinal, name, ...)                                                                   \
     CALL_ORIGINAL(ordinal, name, ##__VA_ARGS__);                                                                       \
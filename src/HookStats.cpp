@@ -0,0 +1,298 @@
+/*
+ * Copyright (c) 2022-2023, NeKz
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "HookStats.hpp"
+#include "lib/json/json.hpp"
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+struct Counters {
+    std::atomic<uint64_t> calls;
+    std::atomic<uint64_t> inclusive;
+    std::atomic<uint64_t> self;
+    std::atomic<uint64_t> max;
+    std::array<std::atomic<uint64_t>, HookStats::histogram_buckets> histogram;
+};
+
+struct ThreadCounters {
+    std::array<Counters, HookStats::max_hooks> hooks;
+};
+
+struct Totals {
+    uint64_t calls;
+    uint64_t inclusive;
+    uint64_t self;
+    uint64_t max;
+    std::array<uint64_t, HookStats::histogram_buckets> histogram;
+};
+
+std::atomic<bool> HookStats::enabled = false;
+
+static std::mutex stats_mutex;
+static std::vector<std::string> names;
+static std::vector<std::unique_ptr<ThreadCounters>> threads; // Kept after a thread exits, its calls still count
+static std::vector<Totals> baseline = std::vector<Totals>(HookStats::max_hooks);
+static std::chrono::steady_clock::time_point reset_time = std::chrono::steady_clock::now();
+
+// Timestamp counter ticks get converted with the rate since the first measurement
+static uint64_t calibration_ticks = HookStats::Now();
+static std::chrono::steady_clock::time_point calibration_time = std::chrono::steady_clock::now();
+
+static thread_local ThreadCounters* local_counters = nullptr;
+
+/*
+ * Only the owning thread writes, a plain load and store is enough.
+ */
+static inline auto add(std::atomic<uint64_t>& counter, uint64_t value) -> void
+{
+    counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+}
+
+static auto get_thread_counters() -> ThreadCounters*
+{
+    if (!local_counters) {
+        auto lock = std::unique_lock(stats_mutex);
+        threads.push_back(std::make_unique<ThreadCounters>());
+        local_counters = threads.back().get();
+    }
+    return local_counters;
+}
+
+static auto get_ticks_per_us() -> double
+{
+#ifdef HOOK_STATS_RDTSC
+    // A short interval gives a bad rate, this only waits right after the module loaded
+    auto minimum = std::chrono::milliseconds(10);
+    auto elapsed = std::chrono::steady_clock::now() - calibration_time;
+    if (elapsed < minimum) {
+        std::this_thread::sleep_for(minimum - elapsed);
+    }
+
+    auto ticks = HookStats::Now() - calibration_ticks;
+    auto us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - calibration_time).count();
+    return us > 0.0 ? ticks / us : 1.0;
+#else
+    return 1000.0;
+#endif
+}
+
+static auto percentile(const Totals& totals, double fraction, double ticks_per_us) -> double
+{
+    auto target = uint64_t(std::ceil(totals.calls * fraction));
+    auto count = uint64_t(0);
+    for (auto i = size_t(0); i < totals.histogram.size(); ++i) {
+        count += totals.histogram[i];
+        if (count >= target) {
+            return double(uint64_t(1) << (i + 1)) / ticks_per_us;
+        }
+    }
+    return totals.max / ticks_per_us;
+}
+
+auto HookStats::Register(const char* name) -> int
+{
+    auto lock = std::unique_lock(stats_mutex);
+
+    auto existing = std::find(names.begin(), names.end(), name);
+    if (existing != names.end()) {
+        return int(existing - names.begin());
+    }
+
+    if (names.size() == HookStats::max_hooks) {
+        return -1;
+    }
+
+    names.push_back(name);
+    return int(names.size() - 1);
+}
+auto HookStats::Record(int id, uint64_t inclusive, uint64_t self) -> void
+{
+    if (id < 0 || size_t(id) >= HookStats::max_hooks) {
+        return;
+    }
+
+    auto& counters = get_thread_counters()->hooks[id];
+    add(counters.calls, 1);
+    add(counters.inclusive, inclusive);
+    add(counters.self, self);
+
+    if (inclusive > counters.max.load(std::memory_order_relaxed)) {
+        counters.max.store(inclusive, std::memory_order_relaxed);
+    }
+
+    auto bucket = (std::min)(size_t(std::bit_width(inclusive | 1)) - 1, HookStats::histogram_buckets - 1);
+    add(counters.histogram[bucket], 1);
+}
+auto HookStats::SetEnabled(bool enable) -> void { HookStats::enabled.store(enable, std::memory_order_relaxed); }
+
+auto HookStats::GetSnapshot() -> Snapshot
+{
+    auto snapshot = Snapshot();
+    snapshot.ticks_per_us = get_ticks_per_us();
+
+    auto lock = std::unique_lock(stats_mutex);
+
+    snapshot.elapsed_ms
+        = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - reset_time).count();
+
+    for (auto id = size_t(0); id < names.size(); ++id) {
+        auto totals = Totals();
+        for (const auto& thread : threads) {
+            const auto& counters = thread->hooks[id];
+            totals.calls += counters.calls.load(std::memory_order_relaxed);
+            totals.inclusive += counters.inclusive.load(std::memory_order_relaxed);
+            totals.self += counters.self.load(std::memory_order_relaxed);
+            totals.max = (std::max)(totals.max, counters.max.load(std::memory_order_relaxed));
+            for (auto i = size_t(0); i < totals.histogram.size(); ++i) {
+                totals.histogram[i] += counters.histogram[i].load(std::memory_order_relaxed);
+            }
+        }
+
+        const auto& base = baseline[id];
+        totals.calls -= base.calls;
+        totals.inclusive -= base.inclusive;
+        totals.self -= base.self;
+        for (auto i = size_t(0); i < totals.histogram.size(); ++i) {
+            totals.histogram[i] -= base.histogram[i];
+        }
+
+        if (!totals.calls) {
+            continue;
+        }
+
+        auto ticks_per_us = snapshot.ticks_per_us;
+        snapshot.hooks.push_back({
+            names[id],
+            totals.calls,
+            totals.inclusive / ticks_per_us,
+            totals.self / ticks_per_us,
+            totals.inclusive / ticks_per_us / totals.calls,
+            totals.max / ticks_per_us,
+            percentile(totals, 0.50, ticks_per_us),
+            percentile(totals, 0.99, ticks_per_us),
+            totals.histogram,
+        });
+    }
+
+    return snapshot;
+}
+auto HookStats::GetDifference(const Snapshot& later, const Snapshot& earlier) -> Snapshot
+{
+    if (later.elapsed_ms < earlier.elapsed_ms) {
+        return later;
+    }
+
+    auto difference = Snapshot { later.ticks_per_us, later.elapsed_ms - earlier.elapsed_ms, {} };
+
+    for (const auto& hook : later.hooks) {
+        auto totals = Totals { hook.calls, 0, 0, uint64_t(hook.max_us * later.ticks_per_us), hook.histogram };
+        auto inclusive_us = hook.inclusive_us;
+        auto self_us = hook.self_us;
+
+        auto before = std::find_if(earlier.hooks.begin(), earlier.hooks.end(),
+            [&hook](const HookSnapshot& other) { return other.name == hook.name; });
+        if (before != earlier.hooks.end()) {
+            totals.calls -= before->calls;
+            for (auto i = size_t(0); i < totals.histogram.size(); ++i) {
+                totals.histogram[i] -= before->histogram[i];
+            }
+            inclusive_us -= before->inclusive_us;
+            self_us -= before->self_us;
+        }
+
+        if (!totals.calls) {
+            continue;
+        }
+
+        difference.hooks.push_back({
+            hook.name,
+            totals.calls,
+            inclusive_us,
+            self_us,
+            inclusive_us / totals.calls,
+            hook.max_us,
+            percentile(totals, 0.50, later.ticks_per_us),
+            percentile(totals, 0.99, later.ticks_per_us),
+            totals.histogram,
+        });
+    }
+
+    return difference;
+}
+auto HookStats::Reset() -> void
+{
+    auto lock = std::unique_lock(stats_mutex);
+
+    for (auto id = size_t(0); id < names.size(); ++id) {
+        auto& base = baseline[id];
+        base = {};
+        for (const auto& thread : threads) {
+            auto& counters = thread->hooks[id];
+            base.calls += counters.calls.load(std::memory_order_relaxed);
+            base.inclusive += counters.inclusive.load(std::memory_order_relaxed);
+            base.self += counters.self.load(std::memory_order_relaxed);
+            for (auto i = size_t(0); i < base.histogram.size(); ++i) {
+                base.histogram[i] += counters.histogram[i].load(std::memory_order_relaxed);
+            }
+
+            // Racy with the owning thread, a call which finishes right now might keep its maximum
+            counters.max.store(0, std::memory_order_relaxed);
+        }
+    }
+
+    reset_time = std::chrono::steady_clock::now();
+}
+
+auto HookStats::ToJson(const Snapshot& snapshot) -> std::string
+{
+    using Json = nlohmann::json;
+
+    auto json = Json {
+        { "ticks_per_us", snapshot.ticks_per_us },
+        { "elapsed_ms", snapshot.elapsed_ms },
+        { "hooks", Json::array() },
+    };
+
+    for (const auto& hook : snapshot.hooks) {
+        // Buckets are keyed by their upper bound in microseconds, empty ones are left out
+        auto histogram = Json::array();
+        for (auto i = size_t(0); i < hook.histogram.size(); ++i) {
+            if (hook.histogram[i]) {
+                auto upper_us = double(uint64_t(1) << (i + 1)) / snapshot.ticks_per_us;
+                histogram.push_back({ { "le_us", upper_us }, { "calls", hook.histogram[i] } });
+            }
+        }
+
+        json["hooks"].push_back({
+            { "name", hook.name },
+            { "calls", hook.calls },
+            { "inclusive_us", hook.inclusive_us },
+            { "self_us", hook.self_us },
+            { "mean_us", hook.mean_us },
+            { "max_us", hook.max_us },
+            { "p50_us", hook.p50_us },
+            { "p99_us", hook.p99_us },
+            { "histogram", histogram },
+        });
+    }
+
+    return json.dump(2);
+}
+auto HookStats::SaveJson(const std::string& path) -> bool
+{
+    auto file = std::ofstream(path);
+    if (!file) {
+        return false;
+    }
+
+    file << HookStats::ToJson(HookStats::GetSnapshot());
+    return bool(file);
+}
@@ -0,0 +1,156 @@
+/*
+ * Copyright (c) 2022-2023, NeKz
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#if defined(_M_IX86) || defined(_M_X64)
+#include <intrin.h>
+#define HOOK_STATS_RDTSC
+#elif defined(__i386__) || defined(__x86_64__)
+#include <x86intrin.h>
+#define HOOK_STATS_RDTSC
+#endif
+
+/*
+ * Opt-in call counts and latency histograms of hooks.
+ *
+ * Every thread records into its own counters, recording never locks or
+ * waits for another thread. Time is measured in timestamp counter ticks and
+ * converted when taking a snapshot. Recording is off until SetEnabled.
+ *
+ * Inclusive time covers the whole detour including the original function.
+ * Self time leaves out the time between Pause and Resume, e.g. the call to
+ * the original, which is the time the hook adds.
+ */
+namespace HookStats {
+
+constexpr auto max_hooks = size_t(256);
+constexpr auto histogram_buckets = size_t(32); // Bucket i counts calls with [2^i, 2^(i+1)) ticks
+
+extern std::atomic<bool> enabled;
+
+inline auto Now() -> uint64_t
+{
+#ifdef HOOK_STATS_RDTSC
+    return __rdtsc();
+#else
+    return uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch())
+                        .count());
+#endif
+}
+
+/*
+ * Returns the id of a hook name, the same name always gets the same id.
+ * Returns -1 once max_hooks names are registered.
+ */
+auto Register(const char* name) -> int;
+auto Record(int id, uint64_t inclusive, uint64_t self) -> void;
+
+auto SetEnabled(bool enable) -> void;
+inline auto IsEnabled() -> bool { return HookStats::enabled.load(std::memory_order_relaxed); }
+
+/*
+ * Measures one call of a hook from construction to destruction.
+ */
+class Scope {
+private:
+    int id;
+    uint64_t start;
+    uint64_t paused; // Ticks excluded from self time
+    uint64_t pause_start;
+
+public:
+    inline Scope(int id)
+        : id(HookStats::IsEnabled() ? id : -1)
+        , start(this->id >= 0 ? HookStats::Now() : 0)
+        , paused(0)
+        , pause_start(0)
+    {
+    }
+    inline ~Scope()
+    {
+        if (this->id >= 0) {
+            auto end = HookStats::Now();
+            auto self_end = this->pause_start ? this->pause_start : end;
+            HookStats::Record(this->id, end - this->start, self_end - this->start - this->paused);
+        }
+    }
+    Scope(const Scope&) = delete;
+    auto operator=(const Scope&) -> Scope& = delete;
+
+    /*
+     * A pause without resume lasts until the end of the scope.
+     */
+    inline auto Pause() -> void
+    {
+        if (this->id >= 0 && !this->pause_start) {
+            this->pause_start = HookStats::Now();
+        }
+    }
+    inline auto Resume() -> void
+    {
+        if (this->id >= 0 && this->pause_start) {
+            this->paused += HookStats::Now() - this->pause_start;
+            this->pause_start = 0;
+        }
+    }
+};
+
+struct HookSnapshot {
+    std::string name;
+    uint64_t calls;
+    double inclusive_us; // Total
+    double self_us; // Total
+    double mean_us; // Inclusive
+    double max_us; // Inclusive
+    double p50_us; // Upper bound of the bucket
+    double p99_us; // Upper bound of the bucket
+    std::array<uint64_t, histogram_buckets> histogram;
+};
+
+struct Snapshot {
+    double ticks_per_us;
+    double elapsed_ms; // Since the last reset
+    std::vector<HookSnapshot> hooks; // Hooks which have been called
+};
+
+/*
+ * Sums up the counters of every thread. Counts of calls which finish while
+ * the snapshot is taken might be missing.
+ */
+auto GetSnapshot() -> Snapshot;
+
+/*
+ * Calls between two snapshots, e.g. to show rates per frame without
+ * resetting the counters. Max stays the maximum of the later snapshot. The
+ * later snapshot is returned as is if a reset happened in between.
+ */
+auto GetDifference(const Snapshot& later, const Snapshot& earlier) -> Snapshot;
+
+/*
+ * Later snapshots only count calls after the reset.
+ */
+auto Reset() -> void;
+
+auto ToJson(const Snapshot& snapshot) -> std::string;
+auto SaveJson(const std::string& path) -> bool;
+}
+
+/*
+ * Measures the detour it is placed in, see HookStats::Scope. Call
+ * hook_stats.Pause() before the original to leave it out of the self time.
+ */
+#define HOOK_STATS(name)                                                                                               \
+    static const auto hook_stats_id = HookStats::Register(name);                                                       \
+    auto hook_stats = HookStats::Scope(hook_stats_id)
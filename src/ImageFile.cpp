@@ -0,0 +1,259 @@
+/*
+ * Copyright (c) 2022-2023, NeKz
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "ImageFile.hpp"
+#include <algorithm>
+#include <cstring>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// windows.h defines min as macro
+static auto min_size(size_t a, size_t b) -> size_t { return a < b ? a : b; }
+
+Memory::ImageFile::~ImageFile() { this->Close(); }
+
+auto Memory::ImageFile::Open(const char* path) -> bool
+{
+    this->Close();
+
+#ifdef _WIN32
+    this->file
+        = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (this->file == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+
+    auto file_size = LARGE_INTEGER();
+    if (!GetFileSizeEx(this->file, &file_size) || !file_size.QuadPart || file_size.QuadPart > SIZE_MAX) {
+        this->Close();
+        return false;
+    }
+
+    this->mapping = CreateFileMappingA(this->file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!this->mapping) {
+        this->Close();
+        return false;
+    }
+
+    this->data = static_cast<const uint8_t*>(MapViewOfFile(this->mapping, FILE_MAP_READ, 0, 0, 0));
+    this->size = size_t(file_size.QuadPart);
+#else
+    this->file = open(path, O_RDONLY | O_CLOEXEC);
+    if (this->file == -1) {
+        return false;
+    }
+
+    struct stat file_stat = {};
+    if (fstat(this->file, &file_stat) || file_stat.st_size <= 0) {
+        this->Close();
+        return false;
+    }
+
+    auto view = mmap(nullptr, size_t(file_stat.st_size), PROT_READ, MAP_PRIVATE, this->file, 0);
+    this->data = view != MAP_FAILED ? static_cast<const uint8_t*>(view) : nullptr;
+    this->size = size_t(file_stat.st_size);
+#endif
+
+    if (!this->data || !Memory::ParseSections(this->data, this->size, &this->sections)
+        || !Memory::ParseFingerprint(this->data, this->size, &this->fingerprint)) {
+        this->Close();
+        return false;
+    }
+
+    // OptionalHeader.ImageBase is 32-bit for PE32 and 64-bit for PE32+
+    auto nt = uint32_t();
+    auto magic = uint16_t();
+    std::memcpy(&nt, this->data + 0x3C, sizeof(nt));
+    if (size_t(nt) + 24 + 32 <= this->size) {
+        std::memcpy(&magic, this->data + nt + 24, sizeof(magic));
+        if (magic == 0x20B) {
+            std::memcpy(&this->image_base, this->data + nt + 24 + 24, sizeof(uint64_t));
+        } else {
+            auto image_base = uint32_t();
+            std::memcpy(&image_base, this->data + nt + 24 + 28, sizeof(image_base));
+            this->image_base = image_base;
+        }
+    }
+
+    return true;
+}
+auto Memory::ImageFile::Close() -> void
+{
+#ifdef _WIN32
+    if (this->data) {
+        UnmapViewOfFile(this->data);
+    }
+    if (this->mapping) {
+        CloseHandle(this->mapping);
+    }
+    if (this->file != INVALID_HANDLE_VALUE) {
+        CloseHandle(this->file);
+    }
+    this->mapping = nullptr;
+    this->file = INVALID_HANDLE_VALUE;
+#else
+    if (this->data) {
+        munmap(const_cast<uint8_t*>(this->data), this->size);
+    }
+    if (this->file != -1) {
+        close(this->file);
+    }
+    this->file = -1;
+#endif
+
+    this->data = nullptr;
+    this->size = 0;
+    this->image_base = 0;
+    this->sections.clear();
+    this->fingerprint = {};
+}
+
+/*
+ * Headers are only part of Section::Image, like they are part of a loaded module.
+ */
+auto Memory::ImageFile::GetRanges(Memory::Section section) const -> std::vector<Range>
+{
+    auto ranges = std::vector<Range>();
+
+    if (section == Section::Image) {
+        auto headers_end = this->size;
+        for (const auto& info : this->sections) {
+            if (info.raw_offset && info.raw_size) {
+                headers_end = min_size(headers_end, info.raw_offset);
+            }
+        }
+        ranges.push_back({ this->data, this->data + headers_end, 0 });
+    }
+
+    for (const auto& info : this->sections) {
+        if (section != Section::Image && !Memory::MatchesSection(info, section)) {
+            continue;
+        }
+
+        // Data past the virtual size is only file alignment
+        auto start = size_t(info.raw_offset);
+        auto length = info.size ? min_size(info.raw_size, info.size) : size_t(info.raw_size);
+        if (!length || start >= this->size) {
+            continue;
+        }
+
+        length = min_size(length, this->size - start);
+        ranges.push_back({ this->data + start, this->data + start + length, info.base });
+    }
+
+    std::sort(ranges.begin(), ranges.end(), [](const Range& a, const Range& b) { return a.rva < b.rva; });
+    return ranges;
+}
+
+auto Memory::ImageFile::OffsetToRva(size_t offset, uintptr_t* rva) const -> bool
+{
+    for (const auto& range : this->GetRanges(Section::Image)) {
+        if (offset >= size_t(range.start - this->data) && offset < size_t(range.end - this->data)) {
+            *rva = range.rva + (offset - size_t(range.start - this->data));
+            return true;
+        }
+    }
+    return false;
+}
+auto Memory::ImageFile::RvaToOffset(uintptr_t rva, size_t* offset) const -> bool
+{
+    for (const auto& range : this->GetRanges(Section::Image)) {
+        if (rva >= range.rva && rva < range.rva + uintptr_t(range.end - range.start)) {
+            *offset = size_t(range.start - this->data) + (rva - range.rva);
+            return true;
+        }
+    }
+    return false;
+}
+
+auto Memory::ImageFile::Scan(const char* pattern, uintptr_t* rva, int offset, Memory::Section section) const -> bool
+{
+    auto signature = Scanner::Signature();
+    if (!Scanner::Parse(pattern, &signature)) {
+        return false;
+    }
+
+    return this->Scan(signature.view(), rva, offset, section);
+}
+auto Memory::ImageFile::Scan(
+    const Scanner::SignatureView& signature, uintptr_t* rva, int offset, Memory::Section section) const -> bool
+{
+    for (const auto& range : this->GetRanges(section)) {
+        auto match = Scanner::Find(range.start, range.end, signature);
+        if (match) {
+            *rva = range.rva + uintptr_t(match - range.start) + offset;
+            return true;
+        }
+    }
+    return false;
+}
+auto Memory::ImageFile::MultiScan(const char* pattern, int offset, Memory::Section section) const
+    -> std::vector<uintptr_t>
+{
+    std::vector<uintptr_t> result;
+
+    auto signature = Scanner::Signature();
+    if (!Scanner::Parse(pattern, &signature)) {
+        return result;
+    }
+
+    for (const auto& range : this->GetRanges(section)) {
+        for (auto const& match : Scanner::FindAll(range.start, range.end, signature.view())) {
+            result.push_back(range.rva + uintptr_t(match - range.start) + offset);
+        }
+    }
+    return result;
+}
+auto Memory::ImageFile::Scan(const Memory::Pattern* pattern, Memory::Section section) const -> std::vector<uintptr_t>
+{
+    std::vector<uintptr_t> result;
+
+    auto rva = uintptr_t();
+    if (this->Scan(pattern->binary, &rva, 0, section)) {
+        for (auto const& offset : pattern->offsets) {
+            result.push_back(rva + offset);
+        }
+    }
+    return result;
+}
+auto Memory::ImageFile::MultiScan(const Memory::Patterns* patterns, Memory::Section section) const
+    -> std::vector<std::vector<uintptr_t>>
+{
+    auto results = std::vector<std::vector<uintptr_t>>();
+
+    auto signatures = std::vector<Scanner::SignatureView>();
+    for (const auto& pattern : *patterns) {
+        signatures.push_back(pattern->binary);
+    }
+
+    auto set = Scanner::SignatureSet(signatures);
+    auto matches = std::vector<std::vector<uintptr_t>>(patterns->size());
+
+    for (const auto& range : this->GetRanges(section)) {
+        auto range_matches = set.FindAll(range.start, range.end);
+        for (auto i = size_t(0); i < matches.size(); ++i) {
+            for (auto const& match : range_matches[i]) {
+                matches[i].push_back(range.rva + uintptr_t(match - range.start));
+            }
+        }
+    }
+
+    for (auto i = size_t(0); i < patterns->size(); ++i) {
+        for (auto const& rva : matches[i]) {
+            auto result = std::vector<uintptr_t>();
+            for (const auto& offset : patterns->at(i)->offsets) {
+                result.push_back(rva + offset);
+            }
+            results.push_back(result);
+        }
+    }
+    return results;
+}
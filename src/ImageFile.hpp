@@ -0,0 +1,100 @@
+/*
+ * Copyright (c) 2022-2023, NeKz
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+#include "Memory.hpp"
+#include "ScanCache.hpp"
+#include "Scanner.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace Memory {
+
+/*
+ * PE file on disk which gets scanned without loading it, e.g. to check the
+ * offsets of a new GridGame.exe build on a machine without the game.
+ *
+ * The file is mapped read-only and never copied. Sections are scanned in
+ * place and every hit is translated to its RVA, which is the address the hit
+ * would have relative to the module base once the image is loaded:
+ *
+ *     auto image = Memory::ImageFile();
+ *     if (image.Open("GridGame.exe")) {
+ *         auto rva = uintptr_t();
+ *         if (image.Scan("E8 ? ? ? ? 8B", &rva, 0, Memory::Section::Code)) {
+ *             auto address = image.ToVirtualAddress(rva); // Comparable to Offsets.hpp
+ *         }
+ *     }
+ */
+class ImageFile {
+public:
+    struct Range {
+        const uint8_t* start;
+        const uint8_t* end;
+        uintptr_t rva;
+    };
+
+private:
+    const uint8_t* data = nullptr;
+    size_t size = 0;
+#ifdef _WIN32
+    HANDLE file = INVALID_HANDLE_VALUE;
+    HANDLE mapping = nullptr;
+#else
+    int file = -1;
+#endif
+    uint64_t image_base = 0;
+    std::vector<SectionInfo> sections;
+    ScanCache::Fingerprint fingerprint = {};
+
+public:
+    ImageFile() = default;
+    ImageFile(const ImageFile&) = delete;
+    auto operator=(const ImageFile&) -> ImageFile& = delete;
+    ~ImageFile();
+
+    /*
+     * Maps the file and reads its section table. Fails if the file is not a PE image.
+     */
+    auto Open(const char* path) -> bool;
+    auto Close() -> void;
+
+    inline auto IsOpen() const -> bool { return this->data != nullptr; }
+    inline auto GetData() const -> const uint8_t* { return this->data; }
+    inline auto GetSize() const -> size_t { return this->size; }
+    inline auto GetImageBase() const -> uint64_t { return this->image_base; }
+    inline auto GetSections() const -> const std::vector<SectionInfo>& { return this->sections; }
+    inline auto GetFingerprint() const -> const ScanCache::Fingerprint& { return this->fingerprint; }
+    inline auto ToVirtualAddress(uintptr_t rva) const -> uint64_t { return this->image_base + rva; }
+
+    /*
+     * Returns the parts of the file which match the section filter in RVA order.
+     */
+    auto GetRanges(Section section) const -> std::vector<Range>;
+
+    /*
+     * Translates between file offsets and RVAs. Returns false for offsets
+     * outside of the headers and the raw data of all sections.
+     */
+    auto OffsetToRva(size_t offset, uintptr_t* rva) const -> bool;
+    auto RvaToOffset(uintptr_t rva, size_t* offset) const -> bool;
+
+    /*
+     * Same as the module scans but every result is an RVA. The headers start
+     * at RVA 0, which makes it a valid match, so the single scans return false
+     * if nothing matched and write the RVA otherwise.
+     */
+    auto Scan(const char* pattern, uintptr_t* rva, int offset = 0, Section section = Section::Image) const -> bool;
+    auto Scan(const Scanner::SignatureView& signature, uintptr_t* rva, int offset = 0,
+        Section section = Section::Image) const -> bool;
+    auto MultiScan(const char* pattern, int offset = 0, Section section = Section::Image) const
+        -> std::vector<uintptr_t>;
+    auto Scan(const Pattern* pattern, Section section = Section::Image) const -> std::vector<uintptr_t>;
+    auto MultiScan(const Patterns* patterns, Section section = Section::Image) const
+        -> std::vector<std::vector<uintptr_t>>;
+};
+}
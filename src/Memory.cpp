@@ -5,9 +5,20 @@
  */
 
 #include "Memory.hpp"
-
+#include "ScanCache.hpp"
+#include "Scanner.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <cstddef>
+#include <cstdio>
 #include <cstring>
 #include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string_view>
+#include <unordered_map>
 #include <vector>
 
 #ifdef _WIN32
@@ -19,87 +30,487 @@
 #include <cstdint>
 #include <dlfcn.h>
 #include <link.h>
+#include <sys/stat.h>
 #include <sys/uio.h>
 #include <unistd.h>
 #endif
 
-#define INRANGE(x, a, b) (x >= a && x <= b)
-#define getBits(x)                                                                                                     \
-    (INRANGE((x & (~0x20)), 'A', 'F') ? ((x & (~0x20)) - 'A' + 0xA) : (INRANGE(x, '0', '9') ? x - '0' : 0))
-#define getByte(x) (getBits(x[0]) << 4 | getBits(x[1]))
+template <typename T> static auto read_at(const uint8_t* image, size_t size, size_t offset, T* value) -> bool
+{
+    if (offset + sizeof(T) > size) {
+        return false;
+    }
 
-std::vector<Memory::ModuleInfo> Memory::moduleList;
+    std::memcpy(value, image + offset, sizeof(T));
+    return true;
+}
 
-auto Memory::TryGetModule(const char* moduleName, Memory::ModuleInfo* info) -> bool
+auto Memory::ParseSections(const uint8_t* image, size_t size, std::vector<Memory::SectionInfo>* sections) -> bool
+{
+    const auto image_scn_mem_execute = 0x20000000u;
+    const auto image_scn_mem_read = 0x40000000u;
+    const auto image_scn_mem_write = 0x80000000u;
+
+    sections->clear();
+
+    // IMAGE_DOS_HEADER::e_magic and e_lfanew
+    auto magic = uint16_t();
+    auto nt = uint32_t();
+    if (!read_at(image, size, 0x00, &magic) || magic != 0x5A4D || !read_at(image, size, 0x3C, &nt)) {
+        return false;
+    }
+
+    // IMAGE_NT_HEADERS::Signature, FileHeader.NumberOfSections and FileHeader.SizeOfOptionalHeader
+    auto signature = uint32_t();
+    auto number_of_sections = uint16_t();
+    auto size_of_optional_header = uint16_t();
+    if (!read_at(image, size, nt, &signature) || signature != 0x00004550
+        || !read_at(image, size, nt + 6, &number_of_sections)
+        || !read_at(image, size, nt + 20, &size_of_optional_header)) {
+        return false;
+    }
+
+    // IMAGE_SECTION_HEADER
+    auto section_header = size_t(nt) + 24 + size_of_optional_header;
+    for (auto i = 0; i < number_of_sections; ++i, section_header += 40) {
+        auto section = Memory::SectionInfo();
+        auto virtual_size = uint32_t();
+        auto virtual_address = uint32_t();
+        auto characteristics = uint32_t();
+
+        if (section_header + 40 > size || !read_at(image, size, section_header + 8, &virtual_size)
+            || !read_at(image, size, section_header + 12, &virtual_address)
+            || !read_at(image, size, section_header + 16, &section.raw_size)
+            || !read_at(image, size, section_header + 20, &section.raw_offset)
+            || !read_at(image, size, section_header + 36, &characteristics)) {
+            return false;
+        }
+
+        std::memcpy(section.name, image + section_header, 8);
+        section.name[8] = '\0';
+        section.base = virtual_address;
+        section.size = virtual_size;
+        section.flags = (characteristics & image_scn_mem_read ? SECTION_READ : 0)
+            | (characteristics & image_scn_mem_write ? SECTION_WRITE : 0)
+            | (characteristics & image_scn_mem_execute ? SECTION_EXECUTE : 0);
+
+        sections->push_back(section);
+    }
+
+    return true;
+}
+auto Memory::ParseFingerprint(const uint8_t* image, size_t size, ScanCache::Fingerprint* fingerprint) -> bool
+{
+    *fingerprint = {};
+
+    auto nt = uint32_t();
+    auto signature = uint32_t();
+    if (!read_at(image, size, 0x3C, &nt) || !read_at(image, size, nt, &signature) || signature != 0x00004550) {
+        return false;
+    }
+
+    // FileHeader.TimeDateStamp, OptionalHeader.SizeOfImage and OptionalHeader.CheckSum
+    return read_at(image, size, nt + 8, &fingerprint->timestamp)
+        && read_at(image, size, nt + 24 + 56, &fingerprint->size)
+        && read_at(image, size, nt + 24 + 64, &fingerprint->checksum);
+}
+auto Memory::MatchesSection(const Memory::SectionInfo& section, Memory::Section filter) -> bool
+{
+    if (!(section.flags & SECTION_READ)) {
+        return false;
+    }
+
+    switch (filter) {
+    case Section::Image:
+    case Section::Readable:
+        return true;
+    case Section::Code:
+        return section.flags & SECTION_EXECUTE;
+    case Section::ReadOnlyData:
+        return !(section.flags & (SECTION_WRITE | SECTION_EXECUTE));
+    case Section::Data:
+        return (section.flags & SECTION_WRITE) && !(section.flags & SECTION_EXECUTE);
+    default:
+        return false;
+    }
+}
+auto Memory::ModuleInfo::FindSection(const char* name) const -> const Memory::SectionInfo*
 {
-    if (Memory::moduleList.empty()) {
+    for (const auto& section : this->sections) {
+        if (!std::strcmp(section.name, name)) {
+            return &section;
+        }
+    }
+    return nullptr;
+}
+
+/*
+ * Modules are looked up by name, case-insensitive like the Windows loader does.
+ */
+struct ModuleNameHash {
+    using is_transparent = void;
+
+    auto operator()(std::string_view name) const -> size_t
+    {
+        auto hash = size_t(2166136261u);
+        for (auto c : name) {
+            hash = (hash ^ size_t(std::tolower(static_cast<unsigned char>(c)))) * size_t(16777619u);
+        }
+        return hash;
+    }
+};
+struct ModuleNameEqual {
+    using is_transparent = void;
+
+    auto operator()(std::string_view a, std::string_view b) const -> bool
+    {
+        return a.size() == b.size() && std::equal(a.begin(), a.end(), b.begin(), [](char x, char y) {
+            return std::tolower(static_cast<unsigned char>(x)) == std::tolower(static_cast<unsigned char>(y));
+        });
+    }
+};
+
+/*
+ * Entries are never freed while the process runs. Unloaded modules are moved
+ * to the retired list so that names and paths which were handed out stay valid.
+ */
+struct ModuleRegistry {
+    std::shared_mutex mutex;
+    std::unordered_map<std::string, std::unique_ptr<Memory::ModuleInfo>, ModuleNameHash, ModuleNameEqual> modules;
+    std::unordered_map<std::string, std::unique_ptr<Memory::ModuleInfo>, ModuleNameHash, ModuleNameEqual> added;
+    std::vector<std::unique_ptr<Memory::ModuleInfo>> retired;
+    std::atomic_bool is_dirty = true;
 #ifdef _WIN32
-        HMODULE hMods[1024];
-        HANDLE pHandle = GetCurrentProcess();
-        DWORD cbNeeded;
-        if (EnumProcessModules(pHandle, hMods, sizeof(hMods), &cbNeeded)) {
-            for (unsigned i = 0; i < (cbNeeded / sizeof(HMODULE)); ++i) {
-                char buffer[MAX_PATH];
-                if (!GetModuleFileNameA(hMods[i], buffer, sizeof(buffer))) {
-                    continue;
+    void* notification_cookie = nullptr;
+#else
+    std::atomic_ullong generation = 0;
+#endif
+};
+
+static ModuleRegistry registry;
+
+#ifdef _WIN32
+auto CALLBACK on_dll_notification(ULONG, const void*, PVOID) -> VOID
+{
+    // Runs under the loader lock, the next lookup does the actual work
+    registry.is_dirty = true;
+}
+#endif
+
+static auto walk_modules() -> std::vector<Memory::ModuleInfo>
+{
+    auto modules = std::vector<Memory::ModuleInfo>();
+
+#ifdef _WIN32
+    HMODULE hMods[1024];
+    HANDLE pHandle = GetCurrentProcess();
+    DWORD cbNeeded;
+    if (EnumProcessModules(pHandle, hMods, sizeof(hMods), &cbNeeded)) {
+        // More modules than the buffer can hold are cut off
+        auto count = cbNeeded / sizeof(HMODULE) < std::size(hMods) ? cbNeeded / sizeof(HMODULE) : std::size(hMods);
+        for (auto i = size_t(0); i < count; ++i) {
+            char buffer[MAX_PATH];
+            if (!GetModuleFileNameA(hMods[i], buffer, sizeof(buffer))) {
+                continue;
+            }
+
+            auto modinfo = MODULEINFO();
+            if (!GetModuleInformation(pHandle, hMods[i], &modinfo, sizeof(modinfo))) {
+                continue;
+            }
+
+            auto module = Memory::ModuleInfo();
+
+            auto temp = std::string(buffer);
+            auto index = temp.find_last_of("\\/");
+            temp = temp.substr(index + 1, temp.length() - index);
+
+            std::snprintf(module.name, sizeof(module.name), "%s", temp.c_str());
+            module.base = uintptr_t(modinfo.lpBaseOfDll);
+            module.size = uintptr_t(modinfo.SizeOfImage);
+            std::snprintf(module.path, sizeof(module.path), "%s", buffer);
+
+            auto image = reinterpret_cast<const uint8_t*>(module.base);
+            if (Memory::ParseSections(image, module.size, &module.sections)) {
+                for (auto& section : module.sections) {
+                    section.base += module.base;
                 }
+            }
+
+            Memory::ParseFingerprint(image, module.size, &module.fingerprint);
+
+            modules.push_back(std::move(module));
+        }
+    }
+#else
+    dl_iterate_phdr(
+        [](struct dl_phdr_info* info, size_t, void* data) {
+            auto module = Memory::ModuleInfo();
+
+            // The main program has no name
+            if (info->dlpi_name[0]) {
+                std::snprintf(module.path, sizeof(module.path), "%s", info->dlpi_name);
+            } else if (readlink("/proc/self/exe", module.path, sizeof(module.path) - 1) < 0) {
+                module.path[0] = '\0';
+            }
 
-                auto modinfo = MODULEINFO();
-                if (!GetModuleInformation(pHandle, hMods[i], &modinfo, sizeof(modinfo))) {
+            auto temp = std::string(module.path);
+            auto index = temp.find_last_of("\\/");
+            temp = temp.substr(index + 1, temp.length() - index);
+            std::snprintf(module.name, sizeof(module.name), "%s", temp.c_str());
+
+            // Every loadable segment becomes a section
+            auto start = UINTPTR_MAX;
+            auto end = uintptr_t(0);
+            for (auto i = 0; i < info->dlpi_phnum; ++i) {
+                auto& phdr = info->dlpi_phdr[i];
+                if (phdr.p_type != PT_LOAD) {
                     continue;
                 }
 
-                auto module = ModuleInfo();
+                auto section = Memory::SectionInfo();
+                std::snprintf(section.name, sizeof(section.name), "load%d", int(module.sections.size()));
+                section.base = info->dlpi_addr + phdr.p_vaddr;
+                section.size = phdr.p_memsz;
+                section.flags = (phdr.p_flags & PF_R ? SECTION_READ : 0) | (phdr.p_flags & PF_W ? SECTION_WRITE : 0)
+                    | (phdr.p_flags & PF_X ? SECTION_EXECUTE : 0);
+                module.sections.push_back(section);
 
-                auto temp = std::string(buffer);
-                auto index = temp.find_last_of("\\/");
-                temp = temp.substr(index + 1, temp.length() - index);
+                start = std::min(start, section.base);
+                end = std::max(end, section.base + section.size);
+            }
 
-                std::snprintf(module.name, sizeof(module.name), "%s", temp.c_str());
-                module.base = uintptr_t(modinfo.lpBaseOfDll);
-                module.size = uintptr_t(modinfo.SizeOfImage);
-                std::snprintf(module.path, sizeof(module.path), "%s", buffer);
+            module.base = start != UINTPTR_MAX ? start : info->dlpi_addr;
+            module.size = end > module.base ? end - module.base : 0;
 
-                Memory::moduleList.push_back(module);
+            // ELF has no link timestamp, the file itself has to do
+            struct stat file = {};
+            if (module.path[0] && !stat(module.path, &file)) {
+                module.fingerprint.timestamp = uint32_t(file.st_mtime);
+                module.fingerprint.size = uint32_t(file.st_size);
             }
-        }
 
-#else
-        dl_iterate_phdr(
-            [](struct dl_phdr_info* info, size_t, uintptr_t) {
-                auto module = Memory::ModuleInfo();
-
-                auto temp = std::string(info->dlpi_name);
-                auto index = temp.find_last_of("\\/");
-                temp = temp.substr(index + 1, temp.length() - index);
-                std::snprintf(module.name, sizeof(module.name), "%s", temp.c_str());
-
-                module.base = info->dlpi_addr + info->dlpi_phdr[0].p_paddr;
-                module.size = info->dlpi_phdr[0].p_memsz;
-                std::strncpy(module.path, info->dlpi_name, sizeof(module.path));
-
-                Memory::moduleList.push_back(module);
-                return 0;
-            },
-            nullptr);
+            static_cast<std::vector<Memory::ModuleInfo>*>(data)->push_back(std::move(module));
+            return 0;
+        },
+        &modules);
 #endif
+
+    return modules;
+}
+
+/*
+ * Detects loads and unloads since the last walk. Windows relies on the loader
+ * notification, Linux on the load and unload counters of the dynamic linker.
+ */
+static auto has_module_changes() -> bool
+{
+#ifndef _WIN32
+    auto generation = 0ull;
+    dl_iterate_phdr(
+        [](struct dl_phdr_info* info, size_t size, void* data) {
+            if (size >= offsetof(dl_phdr_info, dlpi_subs) + sizeof(info->dlpi_subs)) {
+                *static_cast<unsigned long long*>(data) = info->dlpi_adds + (info->dlpi_subs << 32);
+            }
+            return 1;
+        },
+        &generation);
+
+    if (registry.generation.exchange(generation) != generation) {
+        registry.is_dirty = true;
     }
+#endif
+    return registry.is_dirty;
+}
 
-    for (Memory::ModuleInfo& item : Memory::moduleList) {
-        if (!std::strcmp(item.name, moduleName)) {
-            if (info) {
-                *info = item;
+/*
+ * Merges a new walk into the registry. Unchanged modules keep their entry.
+ */
+static auto refresh_registry() -> void
+{
+    auto lock = std::unique_lock(registry.mutex);
+
+    registry.is_dirty = false;
+
+    auto modules = walk_modules();
+    auto seen = std::unordered_map<std::string_view, bool, ModuleNameHash, ModuleNameEqual>();
+
+    for (auto& module : modules) {
+        auto name = std::string_view(module.name);
+        if (seen.contains(name)) {
+            continue;
+        }
+
+        auto entry = registry.modules.find(name);
+        if (entry != registry.modules.end()) {
+            auto& current = *entry->second;
+            if (current.base == module.base && current.size == module.size && !std::strcmp(current.path, module.path)) {
+                seen.emplace(std::string_view(current.name), true);
+                continue;
             }
-            return true;
+
+            registry.retired.push_back(std::move(entry->second));
+            registry.modules.erase(entry);
         }
+
+        auto info = std::make_unique<Memory::ModuleInfo>(std::move(module));
+        auto key = std::string(info->name);
+        auto inserted = registry.modules.emplace(std::move(key), std::move(info)).first;
+        seen.emplace(std::string_view(inserted->second->name), true);
     }
 
-    return false;
+    for (auto entry = registry.modules.begin(); entry != registry.modules.end();) {
+        if (!seen.contains(std::string_view(entry->second->name))) {
+            registry.retired.push_back(std::move(entry->second));
+            entry = registry.modules.erase(entry);
+        } else {
+            ++entry;
+        }
+    }
+}
+
+/*
+ * Returns the registry entry of a module, refreshes the registry once if the
+ * module is unknown. Entries stay valid for the lifetime of the process.
+ */
+static auto find_module(const char* moduleName) -> const Memory::ModuleInfo*
+{
+    if (!moduleName) {
+        return nullptr;
+    }
+
+    {
+        auto lock = std::shared_lock(registry.mutex);
+        auto entry = registry.added.find(std::string_view(moduleName));
+        if (entry != registry.added.end()) {
+            return entry->second.get();
+        }
+    }
+
+    auto refreshed = false;
+    if (has_module_changes()) {
+        refresh_registry();
+        refreshed = true;
+    }
+
+    {
+        auto lock = std::shared_lock(registry.mutex);
+        auto entry = registry.modules.find(std::string_view(moduleName));
+        if (entry != registry.modules.end()) {
+            return entry->second.get();
+        }
+    }
+
+    if (refreshed) {
+        return nullptr;
+    }
+
+    refresh_registry();
+
+    auto lock = std::shared_lock(registry.mutex);
+    auto entry = registry.modules.find(std::string_view(moduleName));
+    return entry != registry.modules.end() ? entry->second.get() : nullptr;
+}
+
+auto Memory::TryGetModule(const char* moduleName, Memory::ModuleInfo* info) -> bool
+{
+    auto module = find_module(moduleName);
+    if (module && info) {
+        auto lock = std::shared_lock(registry.mutex);
+        *info = *module;
+    }
+    return module != nullptr;
+}
+auto Memory::GetModules() -> std::vector<Memory::ModuleInfo>
+{
+    if (has_module_changes()) {
+        refresh_registry();
+    }
+
+    auto modules = std::vector<Memory::ModuleInfo>();
+
+    auto lock = std::shared_lock(registry.mutex);
+    for (const auto& [name, module] : registry.modules) {
+        modules.push_back(*module);
+    }
+    for (const auto& [name, module] : registry.added) {
+        modules.push_back(*module);
+    }
+
+    std::sort(modules.begin(), modules.end(), [](const auto& a, const auto& b) { return a.base < b.base; });
+    return modules;
+}
+auto Memory::RefreshModules() -> void { refresh_registry(); }
+auto Memory::AddModule(const Memory::ModuleInfo& info) -> bool
+{
+    if (!info.name[0] || !info.base) {
+        return false;
+    }
+
+    auto lock = std::unique_lock(registry.mutex);
+
+    auto entry = registry.added.find(std::string_view(info.name));
+    if (entry != registry.added.end()) {
+        registry.retired.push_back(std::move(entry->second));
+        registry.added.erase(entry);
+    }
+
+    registry.added.emplace(std::string(info.name), std::make_unique<Memory::ModuleInfo>(info));
+    return true;
+}
+auto Memory::RemoveModule(const char* moduleName) -> bool
+{
+    auto lock = std::unique_lock(registry.mutex);
+
+    auto entry = registry.added.find(std::string_view(moduleName));
+    if (entry == registry.added.end()) {
+        return false;
+    }
+
+    registry.retired.push_back(std::move(entry->second));
+    registry.added.erase(entry);
+    return true;
+}
+auto Memory::WatchModules([[maybe_unused]] bool enable) -> bool
+{
+#ifdef _WIN32
+    typedef LONG(NTAPI * LdrRegisterDllNotification_t)(
+        ULONG flags, decltype(&on_dll_notification) callback, PVOID context, PVOID* cookie);
+    typedef LONG(NTAPI * LdrUnregisterDllNotification_t)(PVOID cookie);
+
+    auto ntdll = GetModuleHandleA("ntdll.dll");
+    if (!ntdll) {
+        return false;
+    }
+
+    auto lock = std::unique_lock(registry.mutex);
+
+    if (enable && !registry.notification_cookie) {
+        auto ldr_register_dll_notification
+            = reinterpret_cast<LdrRegisterDllNotification_t>(GetProcAddress(ntdll, "LdrRegisterDllNotification"));
+        return ldr_register_dll_notification
+            && ldr_register_dll_notification(0, on_dll_notification, nullptr, &registry.notification_cookie) >= 0;
+    }
+
+    if (!enable && registry.notification_cookie) {
+        auto ldr_unregister_dll_notification
+            = reinterpret_cast<LdrUnregisterDllNotification_t>(GetProcAddress(ntdll, "LdrUnregisterDllNotification"));
+        if (!ldr_unregister_dll_notification || ldr_unregister_dll_notification(registry.notification_cookie) < 0) {
+            return false;
+        }
+        registry.notification_cookie = nullptr;
+    }
+
+    return true;
+#else
+    // The dynamic linker counts loads and unloads, nothing to register
+    return true;
+#endif
 }
 auto Memory::GetModulePath(const char* moduleName) -> const char*
 {
-    auto info = Memory::ModuleInfo();
-    return (Memory::TryGetModule(moduleName, &info)) ? std::string(info.path).c_str() : nullptr;
+    auto module = find_module(moduleName);
+    return module ? module->path : nullptr;
 }
 auto Memory::GetModuleHandleByName(const char* moduleName) -> uintptr_t
 {
@@ -107,13 +518,13 @@ auto Memory::GetModuleHandleByName(const char* moduleName) -> uintptr_t
 #ifdef _WIN32
     return uintptr_t(Memory::TryGetModule(moduleName, &info) ? GetModuleHandleA(info.path) : nullptr);
 #else
-    return (TryGetModule(moduleName, &info)) ? dlopen(info.path, RTLD_NOLOAD | RTLD_NOW) : nullptr;
+    return uintptr_t((TryGetModule(moduleName, &info)) ? dlopen(info.path, RTLD_NOLOAD | RTLD_NOW) : nullptr);
 #endif
 }
 auto Memory::CloseModuleHandle(uintptr_t moduleHandle) -> void
 {
 #ifndef _WIN32
-    dlclose(moduleHandle);
+    dlclose(reinterpret_cast<void*>(moduleHandle));
 #endif
 }
 std::string Memory::GetProcessName()
@@ -137,127 +548,216 @@ std::string Memory::GetProcessName()
 
 auto Memory::FindAddress(const uintptr_t start, const uintptr_t end, const char* target) -> uintptr_t
 {
-    const char* pattern = target;
-    uintptr_t result = 0;
+    auto signature = Scanner::Signature();
+    if (!Scanner::Parse(target, &signature)) {
+        return 0;
+    }
 
-    for (auto position = start; position < end; ++position) {
-        if (!*pattern)
-            return result;
+    return Memory::FindAddress(start, end, signature.view());
+}
+auto Memory::FindAddress(const uintptr_t start, const uintptr_t end, const Scanner::SignatureView& signature)
+    -> uintptr_t
+{
+    auto result = Scanner::Find(
+        reinterpret_cast<const uint8_t*>(start), reinterpret_cast<const uint8_t*>(end), signature);
+    return uintptr_t(result);
+}
+/*
+ * Calls callback(start, end) for every range of a module which matches the section filter.
+ */
+template <typename F> static auto for_each_range(const Memory::ModuleInfo& info, Memory::Section filter, F callback)
+{
+    if (filter == Memory::Section::Image || info.sections.empty()) {
+        callback(reinterpret_cast<const uint8_t*>(info.base), reinterpret_cast<const uint8_t*>(info.base + info.size));
+        return;
+    }
+
+    for (const auto& section : info.sections) {
+        if (Memory::MatchesSection(section, filter)) {
+            auto start = reinterpret_cast<const uint8_t*>(section.base);
+            if (!callback(start, start + section.size)) {
+                return;
+            }
+        }
+    }
+}
 
-        auto match = *reinterpret_cast<const uint8_t*>(pattern);
-        auto byte = *reinterpret_cast<const uint8_t*>(position);
+auto Memory::Scan(const char* moduleName, const char* pattern, int offset, Memory::Section section) -> uintptr_t
+{
+    auto signature = Scanner::Signature();
+    if (!Scanner::Parse(pattern, &signature)) {
+        return 0;
+    }
 
-        if (match == '\?' || byte == getByte(pattern)) {
-            if (!result)
-                result = position;
+    return Memory::Scan(moduleName, signature.view(), offset, section);
+}
+auto Memory::MultiScan(const char* moduleName, const char* pattern, int offset, Memory::Section section)
+    -> std::vector<uintptr_t>
+{
+    std::vector<uintptr_t> result;
 
-            if (!pattern[2])
-                return result;
+    auto signature = Scanner::Signature();
+    if (!Scanner::Parse(pattern, &signature)) {
+        return result;
+    }
 
-            pattern += (match != '\?') ? 3 : 2;
-        } else {
-            pattern = target;
-            result = 0;
-        }
+    // FindAll splits large ranges over the scan threads, ForEachMatch always stays on this thread
+    auto module = find_module(moduleName);
+    if (module) {
+        for_each_range(*module, section, [&](const uint8_t* start, const uint8_t* end) {
+            for (auto const& match : Scanner::FindAll(start, end, signature.view())) {
+                result.push_back(uintptr_t(match) + offset);
+            }
+            return true;
+        });
     }
-    return 0;
+    return result;
 }
-auto Memory::Scan(const char* moduleName, const char* pattern, int offset) -> uintptr_t
+
+auto Memory::Scan(const char* moduleName, const Scanner::SignatureView& signature, int offset, Memory::Section section)
+    -> uintptr_t
 {
     uintptr_t result = 0;
 
     auto info = Memory::ModuleInfo();
     if (Memory::TryGetModule(moduleName, &info)) {
-        auto start = uintptr_t(info.base);
-        auto end = start + info.size;
-        result = Memory::FindAddress(start, end, pattern);
+        auto cacheable = info.fingerprint.timestamp || info.fingerprint.size || info.fingerprint.checksum;
+        auto hash = ScanCache::HashSignature(signature, uint32_t(section));
+
+        // A cached address has to match again, otherwise the module changed in memory
+        auto rva = uintptr_t();
+        if (cacheable && ScanCache::Lookup(info.name, info.fingerprint, hash, &rva) && rva + signature.size <= info.size
+            && Scanner::Verify(reinterpret_cast<const uint8_t*>(info.base + rva), signature)) {
+            return info.base + rva + offset;
+        }
+
+        for_each_range(info, section, [&](const uint8_t* start, const uint8_t* end) {
+            result = uintptr_t(Scanner::Find(start, end, signature));
+            return !result;
+        });
+
         if (result) {
+            if (cacheable) {
+                ScanCache::Store(info.name, info.fingerprint, hash, result - info.base);
+            }
             result += offset;
         }
     }
     return result;
 }
-auto Memory::MultiScan(const char* moduleName, const char* pattern, int offset) -> std::vector<uintptr_t>
+auto Memory::Scan(const char* moduleName, const Memory::Pattern* pattern, Memory::Section section)
+    -> std::vector<uintptr_t>
 {
     std::vector<uintptr_t> result;
-    auto length = std::strlen(pattern);
 
-    auto info = Memory::ModuleInfo();
-    if (Memory::TryGetModule(moduleName, &info)) {
-        auto start = uintptr_t(info.base);
-        auto end = start + info.size;
-        auto addr = uintptr_t();
-        while (true) {
-            auto addr = Memory::FindAddress(start, end, pattern);
-            if (addr) {
-                result.push_back(addr + offset);
-                start = addr + length;
-            } else {
-                break;
-            }
+    auto addr = Memory::Scan(moduleName, pattern->binary, 0, section);
+    if (addr) {
+        for (auto const& offset : pattern->offsets) {
+            result.push_back(addr + offset);
         }
     }
     return result;
 }
-
-auto Memory::Scan(const char* moduleName, const Memory::Pattern* pattern) -> std::vector<uintptr_t>
+auto Memory::MultiScan(const char* moduleName, const Memory::Patterns* patterns, Memory::Section section)
+    -> std::vector<std::vector<uintptr_t>>
 {
-    std::vector<uintptr_t> result;
+    auto results = std::vector<std::vector<uintptr_t>>();
 
-    auto info = Memory::ModuleInfo();
-    if (Memory::TryGetModule(moduleName, &info)) {
-        auto start = uintptr_t(info.base);
-        auto end = start + info.size;
-        auto addr = Memory::FindAddress(start, end, pattern->signature);
-        if (addr) {
-            for (auto const& offset : pattern->offsets) {
-                result.push_back(addr + offset);
+    auto signatures = std::vector<Scanner::SignatureView>();
+    for (const auto& pattern : *patterns) {
+        signatures.push_back(pattern->binary);
+    }
+
+    // One sweep for all patterns instead of one per pattern
+    auto set = Scanner::SignatureSet(signatures);
+    auto matches = std::vector<std::vector<const uint8_t*>>(patterns->size());
+
+    auto module = find_module(moduleName);
+    if (module) {
+        for_each_range(*module, section, [&](const uint8_t* start, const uint8_t* end) {
+            auto range_matches = set.FindAll(start, end);
+            for (auto i = size_t(0); i < matches.size(); ++i) {
+                matches[i].insert(matches[i].end(), range_matches[i].begin(), range_matches[i].end());
             }
-        }
+            return true;
+        });
     }
-    return result;
-}
-auto Memory::MultiScan(const char* moduleName, const Memory::Patterns* patterns) -> std::vector<std::vector<uintptr_t>>
-{
-    auto results = std::vector<std::vector<uintptr_t>>();
 
-    auto info = Memory::ModuleInfo();
-    if (Memory::TryGetModule(moduleName, &info)) {
-        auto moduleStart = uintptr_t(info.base);
-        auto moduleEnd = moduleStart + info.size;
-
-        for (const auto& pattern : *patterns) {
-            auto length = std::strlen(pattern->signature);
-            auto start = moduleStart;
-
-            while (true) {
-                auto addr = Memory::FindAddress(start, moduleEnd, pattern->signature);
-                if (addr) {
-                    auto result = std::vector<uintptr_t>();
-                    for (const auto& offset : pattern->offsets) {
-                        result.push_back(addr + offset);
-                    }
-                    results.push_back(result);
-                    start = addr + length;
-                } else {
-                    break;
-                }
+    for (auto i = size_t(0); i < patterns->size(); ++i) {
+        for (auto const& match : matches[i]) {
+            auto result = std::vector<uintptr_t>();
+            for (const auto& offset : patterns->at(i)->offsets) {
+                result.push_back(uintptr_t(match) + offset);
             }
+            results.push_back(result);
         }
     }
     return results;
 }
 
+/*
+ * Counts visited matches and stops the scan at the limit.
+ */
+class LimitedVisitor final : public Scanner::MatchVisitor {
+private:
+    Scanner::MatchVisitor& visitor;
+    size_t limit;
+
+public:
+    size_t count = 0;
+
+    LimitedVisitor(Scanner::MatchVisitor& visitor, size_t limit)
+        : visitor(visitor)
+        , limit(limit)
+    {
+    }
+
+    auto Visit(size_t index, const uint8_t* match) -> bool override
+    {
+        ++this->count;
+        return this->visitor.Visit(index, match) && this->count < this->limit;
+    }
+};
+
+auto Memory::ForEachMatch(const char* moduleName, const Scanner::SignatureView& signature,
+    Scanner::MatchVisitor& visitor, size_t limit, Memory::Section section) -> size_t
+{
+    auto module = find_module(moduleName);
+    if (!module || !limit) {
+        return 0;
+    }
+
+    auto limited = LimitedVisitor(visitor, limit);
+    for_each_range(*module, section, [&](const uint8_t* start, const uint8_t* end) {
+        return Scanner::ForEachMatch(start, end, signature, limited);
+    });
+    return limited.count;
+}
+auto Memory::ForEachMatch(const char* moduleName, const Scanner::SignatureSet& signatures,
+    Scanner::MatchVisitor& visitor, size_t limit, Memory::Section section) -> size_t
+{
+    auto module = find_module(moduleName);
+    if (!module || !limit) {
+        return 0;
+    }
+
+    auto limited = LimitedVisitor(visitor, limit);
+    for_each_range(*module, section, [&](const uint8_t* start, const uint8_t* end) {
+        return signatures.ForEachMatch(start, end, limited);
+    });
+    return limited.count;
+}
+
 #ifdef _WIN32
 auto Memory::Patch::Execute(uintptr_t location, unsigned char* bytes, unsigned int size) -> bool
 {
     this->location = location;
     this->size = size;
-    this->original = new unsigned char[this->size];
+    this->original = std::make_unique<unsigned char[]>(this->size);
 
     auto proc = GetCurrentProcess();
 
-    if (!ReadProcessMemory(proc, LPVOID(this->location), &this->original, this->size, 0)) {
+    if (!ReadProcessMemory(proc, LPVOID(this->location), this->original.get(), this->size, 0)) {
         return false;
     }
 
@@ -284,12 +784,12 @@ auto Memory::Patch::ExecuteForce(uintptr_t location, unsigned char* bytes, unsig
 {
     this->location = location;
     this->size = size;
-    this->original = new unsigned char[this->size];
+    this->original = std::make_unique<unsigned char[]>(this->size);
 
     DWORD oldProtect = 0;
     VirtualProtectEx(GetCurrentProcess(), LPVOID(this->location), this->size, PAGE_EXECUTE_READWRITE, &oldProtect);
 
-    auto result = ReadProcessMemory(GetCurrentProcess(), LPVOID(this->location), &this->original, this->size, 0)
+    auto result = ReadProcessMemory(GetCurrentProcess(), LPVOID(this->location), this->original.get(), this->size, 0)
         && WriteProcessMemory(
             GetCurrentProcess(), LPVOID(this->location), reinterpret_cast<LPCVOID>(bytes), this->size, 0);
 
@@ -300,7 +800,7 @@ auto Memory::Patch::ExecuteForce(uintptr_t location, unsigned char* bytes, unsig
 auto Memory::Patch::Restore() -> bool
 {
     return this->location && this->original
-        && WriteProcessMemory(GetCurrentProcess(), LPVOID(this->location), &this->original, this->size, 0);
+        && WriteProcessMemory(GetCurrentProcess(), LPVOID(this->location), this->original.get(), this->size, 0);
 }
 auto Memory::Patch::RestoreForce() -> bool
 {
@@ -313,7 +813,7 @@ auto Memory::Patch::RestoreForce() -> bool
     DWORD oldProtect = 0;
     VirtualProtectEx(proc, LPVOID(this->location), this->size, PAGE_EXECUTE_READWRITE, &oldProtect);
 
-    auto result = WriteProcessMemory(proc, LPVOID(this->location), &this->original, this->size, 0);
+    auto result = WriteProcessMemory(proc, LPVOID(this->location), this->original.get(), this->size, 0);
 
     VirtualProtectEx(proc, LPVOID(this->location), this->size, oldProtect, 0);
 
@@ -321,6 +821,113 @@ auto Memory::Patch::RestoreForce() -> bool
 }
 #endif
 
+/*
+ * Returns the registry entry of the module which contains the address.
+ */
+static auto find_module_containing(uintptr_t address) -> const Memory::ModuleInfo*
+{
+    if (has_module_changes()) {
+        refresh_registry();
+    }
+
+    auto lock = std::shared_lock(registry.mutex);
+    for (const auto& [name, module] : registry.modules) {
+        if (address >= module->base && address - module->base < module->size) {
+            return module.get();
+        }
+    }
+    return nullptr;
+}
+
+/*
+ * Vtable copies are shared by every Interface which hooks an object with the
+ * same original vtable. Sizes are cached per vtable and stay after the last
+ * reference to a copy is gone.
+ */
+struct VtableShadow {
+    int size;
+    size_t references;
+    std::unique_ptr<uintptr_t[]> copy; // Slots before the table followed by the entries
+};
+
+// MSVC stores the RTTI locator before the table, Itanium the offset to top and the type info
+#ifdef _WIN32
+constexpr auto vtable_prefix = 1;
+#else
+constexpr auto vtable_prefix = 2;
+#endif
+
+static std::mutex shadows_mutex;
+static std::unordered_map<uintptr_t*, VtableShadow> shadows;
+
+/*
+ * Counts the entries until the terminating null entry. The walk never leaves
+ * the section of the owning module, or readable memory if the vtable does not
+ * belong to a module.
+ */
+static auto count_vtable_entries(uintptr_t* vtable) -> int
+{
+    auto limit = reinterpret_cast<uintptr_t*>(UINTPTR_MAX);
+
+    auto module = find_module_containing(uintptr_t(vtable));
+    if (module) {
+        for (const auto& section : module->sections) {
+            if (uintptr_t(vtable) >= section.base && uintptr_t(vtable) - section.base < section.size) {
+                limit = reinterpret_cast<uintptr_t*>(section.base + section.size);
+                break;
+            }
+        }
+    }
+
+    auto size = 0;
+    while (vtable + size + 1 <= limit && Memory::IsReadable(vtable + size) && vtable[size]) {
+        ++size;
+    }
+    return size;
+}
+
+static auto get_vtable_size(uintptr_t* vtable) -> int
+{
+    {
+        auto lock = std::unique_lock(shadows_mutex);
+        auto shadow = shadows.find(vtable);
+        if (shadow != shadows.end()) {
+            return shadow->second.size;
+        }
+    }
+
+    // Walk without the lock, a racing walk of the same table gets the same result
+    auto size = count_vtable_entries(vtable);
+
+    auto lock = std::unique_lock(shadows_mutex);
+    return shadows.emplace(vtable, VtableShadow { size, 0, nullptr }).first->second.size;
+}
+
+static auto acquire_shadow(uintptr_t* vtable, int size) -> uintptr_t*
+{
+    auto lock = std::unique_lock(shadows_mutex);
+
+    auto& shadow = shadows[vtable];
+    if (!shadow.copy) {
+        shadow.size = size;
+        shadow.copy = std::make_unique<uintptr_t[]>(vtable_prefix + size);
+        std::memcpy(shadow.copy.get(), vtable - vtable_prefix, (vtable_prefix + size) * sizeof(uintptr_t));
+    }
+
+    ++shadow.references;
+    return shadow.copy.get() + vtable_prefix;
+}
+
+static auto release_shadow(uintptr_t* vtable) -> void
+{
+    auto lock = std::unique_lock(shadows_mutex);
+
+    auto shadow = shadows.find(vtable);
+    if (shadow != shadows.end() && shadow->second.references && !--shadow->second.references) {
+        shadow->second.copy.reset();
+    }
+}
+
 Memory::Interface::Interface()
     : baseclass(nullptr)
     , vtable(nullptr)
@@ -334,10 +941,7 @@ Memory::Interface::Interface(uintptr_t baseclass, bool copyVtable, bool autoHook
 {
     this->baseclass = reinterpret_cast<uintptr_t**>(baseclass);
     this->vtable = *this->baseclass;
-
-    while (this->vtable[this->vtableSize]) {
-        ++this->vtableSize;
-    }
+    this->vtableSize = get_vtable_size(this->vtable);
 
     if (copyVtable) {
         this->CopyVtable();
@@ -350,20 +954,20 @@ Memory::Interface::~Interface()
 {
     this->DisableHooks();
     if (this->copy) {
-        this->copy.reset();
+        release_shadow(this->vtable);
+        this->copy = nullptr;
     }
 }
 auto Memory::Interface::CopyVtable() -> void
 {
-    if (!this->copy) {
-        this->copy = std::make_unique<uintptr_t[]>(this->vtableSize + 1);
-        std::memcpy(this->copy.get(), this->vtable - 1, sizeof(uintptr_t) + this->vtableSize * sizeof(uintptr_t));
+    if (!this->copy && this->vtable) {
+        this->copy = acquire_shadow(this->vtable, this->vtableSize);
     }
 }
 auto Memory::Interface::EnableHooks() -> void
 {
-    if (!this->isHooked) {
-        *this->baseclass = this->copy.get() + 1;
+    if (!this->isHooked && this->copy) {
+        *this->baseclass = this->copy;
         this->isHooked = true;
     }
 }
@@ -376,8 +980,8 @@ auto Memory::Interface::DisableHooks() -> void
 }
 auto Memory::Interface::Unhook(int index) -> bool
 {
-    if (index >= 0 && index < this->vtableSize) {
-        this->copy[index + 1] = this->vtable[index];
+    if (this->copy && index >= 0 && index < this->vtableSize) {
+        this->copy[index] = this->vtable[index];
         return true;
     }
     return false;
@@ -5,6 +5,11 @@
  */
 
 #pragma once
+#include "PatchSet.hpp"
+#include "RegionMap.hpp"
+#include "ScanCache.hpp"
+#include "Scanner.hpp"
+
 #ifdef _WIN32
 #include <windows.h>
 #else
@@ -12,37 +17,99 @@
 #define MAX_PATH 4096
 #endif
 
+#include <concepts>
+#include <cstdint>
 #include <memory>
 #include <string>
 #include <vector>
 
 namespace Memory {
 
+#define SECTION_READ (1 << 0)
+#define SECTION_WRITE (1 << 1)
+#define SECTION_EXECUTE (1 << 2)
+
+struct SectionInfo {
+    char name[9];
+    uintptr_t base;
+    uintptr_t size;
+    uint32_t flags;
+    uint32_t raw_offset; // Offset of the section data in a PE file
+    uint32_t raw_size;
+};
+
+enum class Section {
+    Image, // Whole module including headers and padding
+    Readable, // Every readable section
+    Code, // Executable sections e.g. .text
+    ReadOnlyData, // Readable but not writable or executable sections e.g. .rdata
+    Data, // Writable but not executable sections e.g. .data
+};
+
 struct ModuleInfo {
     char name[MAX_PATH];
     uintptr_t base;
     uintptr_t size;
     char path[MAX_PATH];
+    std::vector<SectionInfo> sections;
+    ScanCache::Fingerprint fingerprint;
+
+    auto FindSection(const char* name) const -> const SectionInfo*;
 };
 
-extern std::vector<ModuleInfo> moduleList;
+/*
+ * Reads the section table of a PE image. Section bases are RVAs.
+ */
+auto ParseSections(const uint8_t* image, size_t size, std::vector<SectionInfo>* sections) -> bool;
+auto MatchesSection(const SectionInfo& section, Section filter) -> bool;
+
+/*
+ * Reads timestamp, image size and checksum of a PE image which identify the build of a module.
+ */
+auto ParseFingerprint(const uint8_t* image, size_t size, ScanCache::Fingerprint* fingerprint) -> bool;
 
+/*
+ * Loaded modules are kept in a registry which refreshes itself when a module
+ * gets loaded or unloaded. Lookups are case-insensitive.
+ */
 auto TryGetModule(const char* moduleName, ModuleInfo* info) -> bool;
+auto GetModules() -> std::vector<ModuleInfo>;
+auto RefreshModules() -> void;
+
+/*
+ * Registers a memory range which is not a loaded module, e.g. a copy of a
+ * module, under a name. Added modules take precedence over loaded ones and
+ * can be scanned like any other module.
+ */
+auto AddModule(const ModuleInfo& info) -> bool;
+auto RemoveModule(const char* moduleName) -> bool;
+
+/*
+ * Registers a loader notification on Windows which marks the registry as stale.
+ * Has to be disabled before the module unloads.
+ */
+auto WatchModules(bool enable) -> bool;
+
+/*
+ * Returned path stays valid for the lifetime of the process.
+ */
 auto GetModulePath(const char* moduleName) -> const char*;
 auto GetModuleHandleByName(const char* moduleName) -> uintptr_t;
 auto CloseModuleHandle(uintptr_t moduleHandle) -> void;
 auto GetProcessName() -> std::string;
 
 auto FindAddress(const uintptr_t start, const uintptr_t end, const char* target) -> uintptr_t;
-auto Scan(const char* moduleName, const char* pattern, int offset = 0) -> uintptr_t;
-auto MultiScan(const char* moduleName, const char* pattern, int offset = 0) -> std::vector<uintptr_t>;
+auto FindAddress(const uintptr_t start, const uintptr_t end, const Scanner::SignatureView& signature) -> uintptr_t;
+auto Scan(const char* moduleName, const char* pattern, int offset = 0, Section section = Section::Image) -> uintptr_t;
+auto MultiScan(const char* moduleName, const char* pattern, int offset = 0, Section section = Section::Image)
+    -> std::vector<uintptr_t>;
 
 #ifdef _WIN32
 class Patch {
 private:
-    uintptr_t location;
-    unsigned char* original;
-    size_t size;
+    uintptr_t location = 0;
+    std::unique_ptr<unsigned char[]> original;
+    size_t size = 0;
 
 public:
     auto GetLocation() -> uintptr_t { return this->location; }
@@ -56,21 +123,88 @@ public:
 
 struct Pattern {
     const char* signature;
+    Scanner::SignatureView binary;
     std::vector<int> offsets;
 };
 
 typedef std::vector<int> Offset;
 typedef std::vector<const Pattern*> Patterns;
 
+// Signatures get decoded at compile time, a malformed signature fails the build.
 #define PATTERN(name, sig, ...)                                                                                        \
+    static constexpr auto name##_binary = Scanner::StaticSignature(sig);                                               \
     Memory::Pattern name                                                                                               \
     {                                                                                                                  \
-        sig, Memory::Offset({ __VA_ARGS__ })                                                                           \
+        sig, name##_binary.view(), Memory::Offset({ __VA_ARGS__ })                                                     \
     }
 #define PATTERNS(name, ...) Memory::Patterns name({ __VA_ARGS__ })
 
-auto Scan(const char* moduleName, const Pattern* pattern) -> std::vector<uintptr_t>;
-auto MultiScan(const char* moduleName, const Patterns* patterns) -> std::vector<std::vector<uintptr_t>>;
+auto Scan(const char* moduleName, const Scanner::SignatureView& signature, int offset = 0,
+    Section section = Section::Image) -> uintptr_t;
+auto Scan(const char* moduleName, const Pattern* pattern, Section section = Section::Image) -> std::vector<uintptr_t>;
+auto MultiScan(const char* moduleName, const Patterns* patterns, Section section = Section::Image)
+    -> std::vector<std::vector<uintptr_t>>;
+
+/*
+ * Fixed capacity list which never allocates, e.g. for scan results on the
+ * stack. Pushing into a full list fails.
+ */
+template <typename T, size_t Capacity> class SmallVector {
+private:
+    T items[Capacity];
+    size_t count = 0;
+
+public:
+    inline auto push_back(const T& item) -> bool
+    {
+        if (this->count == Capacity) {
+            return false;
+        }
+
+        this->items[this->count++] = item;
+        return true;
+    }
+    inline auto clear() -> void { this->count = 0; }
+    inline auto size() const -> size_t { return this->count; }
+    inline auto capacity() const -> size_t { return Capacity; }
+    inline auto empty() const -> bool { return this->count == 0; }
+    inline auto full() const -> bool { return this->count == Capacity; }
+    inline auto operator[](size_t index) const -> const T& { return this->items[index]; }
+    inline auto begin() const -> const T* { return this->items; }
+    inline auto end() const -> const T* { return this->items + this->count; }
+};
+
+/*
+ * Streams the matches in a module to a visitor without allocating. The scan
+ * stops when the visitor returns false or after limit matches, returns the
+ * number of visited matches. Matches of a single signature arrive in address
+ * order. MultiScan and friends are wrappers which collect every match.
+ */
+auto ForEachMatch(const char* moduleName, const Scanner::SignatureView& signature, Scanner::MatchVisitor& visitor,
+    size_t limit = SIZE_MAX, Section section = Section::Image) -> size_t;
+auto ForEachMatch(const char* moduleName, const Scanner::SignatureSet& signatures, Scanner::MatchVisitor& visitor,
+    size_t limit = SIZE_MAX, Section section = Section::Image) -> size_t;
+
+template <typename F>
+    requires std::invocable<F&, uintptr_t>
+inline auto ForEachMatch(const char* moduleName, const Scanner::SignatureView& signature, F callback,
+    size_t limit = SIZE_MAX, Section section = Section::Image) -> size_t
+{
+    auto visit = [&callback](size_t, const uint8_t* match) -> bool { return callback(uintptr_t(match)); };
+    auto visitor = Scanner::MatchCallback(visit);
+    return Memory::ForEachMatch(moduleName, signature, visitor, limit, section);
+}
+
+/*
+ * Fills results with up to Capacity matches, returns the number of added matches.
+ */
+template <size_t Capacity>
+inline auto MultiScan(const char* moduleName, const Scanner::SignatureView& signature,
+    SmallVector<uintptr_t, Capacity>* results, int offset = 0, Section section = Section::Image) -> size_t
+{
+    auto add = [results, offset](uintptr_t match) { return results->push_back(match + offset); };
+    return Memory::ForEachMatch(moduleName, signature, add, Capacity - results->size(), section);
+}
 
 template <typename T = uintptr_t> inline auto Absolute(const char* moduleName, int relative) -> T
 {
@@ -82,7 +216,7 @@ template <typename T = uintptr_t> inline auto GetSymbolAddress(uintptr_t moduleH
 #ifdef _WIN32
     return T(GetProcAddress(HMODULE(moduleHandle), symbolName));
 #else
-    return T(dlsym(moduleHandle, symbolName));
+    return T(dlsym(reinterpret_cast<void*>(moduleHandle), symbolName));
 #endif
 }
 template <typename T = uintptr_t> inline auto VMT(void* ptr, int index) -> T
@@ -112,22 +246,37 @@ template <typename T = uintptr_t> inline auto DerefDeref(uintptr_t source, T* de
 {
     *destination = **reinterpret_cast<T**>(source);
 }
-template <typename T = uintptr_t> inline auto Scan(const char* moduleName, const char* pattern, int offset = 0) -> T
-{
-    uintptr_t result = 0;
 
-    auto info = Memory::ModuleInfo();
-    if (Memory::TryGetModule(moduleName, &info)) {
-        auto start = uintptr_t(info.base);
-        auto end = start + info.size;
-        result = Memory::FindAddress(start, end, pattern);
-        if (result) {
-            result += offset;
-        }
+/*
+ * Checked versions of Deref and DerefDeref which fail instead of faulting, see IsReadable.
+ */
+template <typename T = uintptr_t> inline auto TryDeref(uintptr_t source, T* destination) -> bool
+{
+    if (!Memory::IsReadable(source, sizeof(T))) {
+        return false;
     }
-    return reinterpret_cast<T>(result);
+
+    *destination = *reinterpret_cast<T*>(source);
+    return true;
+}
+template <typename T = uintptr_t> inline auto TryDerefDeref(uintptr_t source, T* destination) -> bool
+{
+    auto pointer = uintptr_t();
+    return Memory::TryDeref(source, &pointer) && Memory::TryDeref(pointer, destination);
+}
+template <typename T = uintptr_t>
+inline auto Scan(const char* moduleName, const char* pattern, int offset = 0, Section section = Section::Image) -> T
+{
+    return reinterpret_cast<T>(Memory::Scan(moduleName, pattern, offset, section));
 }
 
+/*
+ * Hooks virtual functions by pointing an object at a copy of its vtable.
+ *
+ * The copy is shared by every Interface on an object with the same original
+ * vtable and is freed with the last one. A hook installed through one of them
+ * applies to all objects which share the copy.
+ */
 class Interface {
 public:
     uintptr_t** baseclass;
@@ -136,11 +285,13 @@ public:
 
 private:
     bool isHooked;
-    std::unique_ptr<uintptr_t[]> copy;
+    uintptr_t* copy; // First entry of the shared copy
 
 public:
     Interface();
     Interface(uintptr_t baseclass, bool copyVtable = true, bool autoHook = true);
+    Interface(const Interface&) = delete;
+    auto operator=(const Interface&) -> Interface& = delete;
     ~Interface();
 
     auto CopyVtable() -> void;
@@ -156,12 +307,12 @@ public:
         }
         return (T)this->vtable[index];
     }
-    template <typename T = uintptr_t> auto Hooked(int index) -> T { return (T)this->copy[index + 1]; }
+    template <typename T = uintptr_t> auto Hooked(int index) -> T { return (T)this->copy[index]; }
     template <typename T = uintptr_t> auto Current(int index) -> T { return (T)(*this->baseclass)[index]; }
     template <typename T = uintptr_t, typename U = uintptr_t> auto Hook(T detour, U& original, int index) -> bool
     {
         if (index >= 0 && index < this->vtableSize) {
-            this->copy[index + 1] = reinterpret_cast<uintptr_t>(detour);
+            this->copy[index] = reinterpret_cast<uintptr_t>(detour);
             original = this->Original<U>(index);
             return true;
         }
@@ -0,0 +1,95 @@
+/*
+ * Copyright (c) 2022-2023, NeKz
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "NameIndex.hpp"
+
+auto NameIndex::Hash(std::string_view name) -> uint32_t
+{
+    // FNV-1a
+    auto hash = uint32_t(2166136261u);
+    for (auto c : name) {
+        hash = (hash ^ uint8_t(c)) * 16777619u;
+    }
+    return hash;
+}
+
+auto NameIndex::Insert(uint32_t index, const char* name) -> void
+{
+    auto hash = NameIndex::Hash(name);
+    auto mask = this->slots.size() - 1;
+    for (auto slot = size_t(hash) & mask;; slot = (slot + 1) & mask) {
+        if (!this->slots[slot].index) {
+            this->slots[slot] = { hash, index + 1 };
+            return;
+        }
+    }
+}
+auto NameIndex::Grow() -> void
+{
+    // Reinserting in index order keeps the lowest index of a duplicate name first
+    this->slots.assign(this->slots.empty() ? 1024 : this->slots.size() * 2, Slot { 0, 0 });
+    for (auto index = uint32_t(0); index < this->names.size(); ++index) {
+        if (this->names[index]) {
+            this->Insert(index, this->names[index]);
+        }
+    }
+}
+
+auto NameIndex::Set(uint32_t index, const char* name) -> void
+{
+    if (!name) {
+        return;
+    }
+
+    if (index >= this->names.size()) {
+        this->names.resize(index + 1, nullptr);
+    }
+
+    if (this->names[index]) {
+        return;
+    }
+
+    this->names[index] = name;
+    ++this->count;
+
+    // Keeps the load factor at or below one half
+    if (this->count * 2 > this->slots.size()) {
+        this->Grow();
+    } else {
+        this->Insert(index, name);
+    }
+}
+
+auto NameIndex::Find(uint32_t index) const -> std::string_view
+{
+    return index < this->names.size() && this->names[index] ? this->names[index] : "";
+}
+auto NameIndex::FindIndex(std::string_view name) const -> int
+{
+    if (this->slots.empty()) {
+        return -1;
+    }
+
+    auto hash = NameIndex::Hash(name);
+    auto mask = this->slots.size() - 1;
+    for (auto slot = size_t(hash) & mask;; slot = (slot + 1) & mask) {
+        const auto& entry = this->slots[slot];
+        if (!entry.index) {
+            return -1;
+        }
+
+        if (entry.hash == hash && name == this->names[entry.index - 1]) {
+            return int(entry.index - 1);
+        }
+    }
+}
+auto NameIndex::Clear() -> void
+{
+    this->names.clear();
+    this->missing.clear();
+    this->slots.clear();
+    this->count = 0;
+}
@@ -0,0 +1,90 @@
+/*
+ * Copyright (c) 2022-2023, NeKz
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+/*
+ * Lookup of the engine name table in both directions.
+ *
+ * Index to name is a direct array access, name to index an open addressing
+ * hash table with linear probing. The name table only grows, Update indexes
+ * the entries which were added since the last call. Names are not copied,
+ * the entries have to stay alive. Not thread-safe.
+ */
+class NameIndex {
+private:
+    struct Slot {
+        uint32_t hash;
+        uint32_t index; // Index + 1, zero is an empty slot
+    };
+
+    std::vector<const char*> names; // Null if the entry was missing or invalid
+    std::vector<uint32_t> missing; // Entries which get checked again by the next update
+    std::vector<Slot> slots;
+    size_t count = 0;
+
+    auto Insert(uint32_t index, const char* name) -> void;
+    auto Grow() -> void;
+
+public:
+    static auto Hash(std::string_view name) -> uint32_t;
+
+    /*
+     * Indexes every valid entry which has not been indexed yet. Entries are
+     * valid if their stored index matches their position like FNameEntry.
+     * Returns the number of indexed names.
+     */
+    template <typename Entry> auto Update(Entry* const* entries, size_t size) -> size_t
+    {
+        auto valid = [entries](uint32_t index) -> const char* {
+            auto entry = entries[index];
+            return entry && uint32_t(entry->index) == index << 1 ? entry->name : nullptr;
+        };
+
+        auto still_missing = size_t(0);
+        for (auto index : this->missing) {
+            if (index >= size) {
+                continue;
+            }
+
+            auto name = valid(index);
+            if (name) {
+                this->Set(index, name);
+            } else {
+                this->missing[still_missing++] = index;
+            }
+        }
+        this->missing.resize(still_missing);
+
+        for (auto index = uint32_t(this->names.size()); index < size; ++index) {
+            auto name = valid(index);
+            this->names.push_back(nullptr);
+            if (name) {
+                this->Set(index, name);
+            } else {
+                this->missing.push_back(index);
+            }
+        }
+
+        return this->count;
+    }
+
+    /*
+     * Indexes one name, index has to be below size().
+     */
+    auto Set(uint32_t index, const char* name) -> void;
+
+    auto Find(uint32_t index) const -> std::string_view;
+    auto FindIndex(std::string_view name) const -> int;
+    auto Clear() -> void;
+
+    inline auto size() const -> size_t { return this->names.size(); }
+    inline auto GetIndexedCount() const -> size_t { return this->count; }
+};
@@ -0,0 +1,65 @@
+/*
+ * Copyright (c) 2022-2023, NeKz
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "ObjectIndex.hpp"
+#include <charconv>
+
+static auto resolve_name(std::string_view component, const NameIndex& names, ObjectName* name) -> bool
+{
+    auto index = names.FindIndex(component);
+    if (index >= 0) {
+        *name = { uint32_t(index), 0 };
+        return true;
+    }
+
+    // "Pawn_3" is the name "Pawn" with number 4
+    auto separator = component.find_last_of('_');
+    if (separator == std::string_view::npos || separator + 1 == component.size()) {
+        return false;
+    }
+
+    auto suffix = uint32_t(0);
+    auto digits = component.substr(separator + 1);
+    auto [end, error] = std::from_chars(digits.data(), digits.data() + digits.size(), suffix);
+    if (error != std::errc() || end != digits.data() + digits.size() || (digits.size() > 1 && digits[0] == '0')) {
+        return false;
+    }
+
+    index = names.FindIndex(component.substr(0, separator));
+    if (index < 0) {
+        return false;
+    }
+
+    *name = { uint32_t(index), suffix + 1 };
+    return true;
+}
+
+auto ParseObjectPath(std::string_view path, const NameIndex& names, ObjectName (&components)[max_object_depth])
+    -> size_t
+{
+    auto depth = size_t(0);
+    for (;;) {
+        auto separator = path.find_first_of(".:");
+        auto component = path.substr(0, separator);
+
+        if (component.empty() || depth == max_object_depth || !resolve_name(component, names, &components[depth])) {
+            return 0;
+        }
+
+        ++depth;
+
+        if (separator == std::string_view::npos) {
+            return depth;
+        }
+
+        // "::" counts as one separator
+        auto colon = path[separator] == ':';
+        path.remove_prefix(separator + 1);
+        if (colon && !path.empty() && path[0] == ':') {
+            path.remove_prefix(1);
+        }
+    }
+}
@@ -0,0 +1,218 @@
+/*
+ * Copyright (c) 2022-2023, NeKz
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+#include "NameIndex.hpp"
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+struct ObjectName {
+    uint32_t index;
+    uint32_t number; // Zero if the name has no suffix, otherwise suffix + 1
+
+    inline auto operator==(const ObjectName& other) const -> bool
+    {
+        return this->index == other.index && this->number == other.number;
+    }
+};
+
+constexpr auto max_object_depth = size_t(16);
+
+/*
+ * Splits a path like "Engine.Pawn" or "Package::Outer::Name" into names,
+ * outermost first. A trailing "_N" becomes the number of the name if the
+ * whole component is not a name. Returns the depth, zero if a component is
+ * not a known name or the path is too deep.
+ */
+auto ParseObjectPath(std::string_view path, const NameIndex& names, ObjectName (&components)[max_object_depth])
+    -> size_t;
+
+/*
+ * Lookup of objects by their full path, i.e. the names of the outer chain and
+ * the name of the object, without building any strings.
+ *
+ * The key is a hash of the name indices and numbers. Class names are checked
+ * on the candidates, a lookup without class returns the first object with the
+ * path. Update compares the table with the one it indexed last time, objects
+ * which were freed or replaced in a reused slot get indexed again. Object
+ * has to provide name, outer_object and class_object like UObject. Not
+ * thread-safe.
+ */
+template <typename Object> class ObjectIndex {
+private:
+    struct Slot {
+        uint64_t hash;
+        uint32_t index; // Position in the object table + 1, zero is an empty slot
+    };
+
+    std::vector<Object*> objects; // Object of every position at the last update
+    std::vector<Slot> slots;
+    size_t count = 0; // Used slots including stale ones
+
+    static inline auto Mix(uint64_t hash, const ObjectName& name) -> uint64_t
+    {
+        // FNV-1a over both halves of the name
+        hash = (hash ^ name.index) * 1099511628211ull;
+        return (hash ^ name.number) * 1099511628211ull;
+    }
+
+    /*
+     * Collects the path of an object, outermost first.
+     */
+    static auto GetPath(Object* object, ObjectName (&path)[max_object_depth]) -> size_t
+    {
+        auto depth = size_t(0);
+        for (auto item = object; item; item = item->outer_object) {
+            if (depth == max_object_depth) {
+                return 0;
+            }
+            path[depth++] = { uint32_t(item->name.index), uint32_t(item->name.number) };
+        }
+
+        for (auto i = size_t(0); i < depth / 2; ++i) {
+            auto name = path[i];
+            path[i] = path[depth - 1 - i];
+            path[depth - 1 - i] = name;
+        }
+        return depth;
+    }
+
+    auto Insert(uint64_t hash, uint32_t index) -> void
+    {
+        auto mask = this->slots.size() - 1;
+        for (auto slot = size_t(hash) & mask;; slot = (slot + 1) & mask) {
+            if (!this->slots[slot].index) {
+                this->slots[slot] = { hash, index + 1 };
+                ++this->count;
+                return;
+            }
+        }
+    }
+
+    auto Rebuild(size_t capacity) -> void
+    {
+        this->slots.assign(capacity, Slot { 0, 0 });
+        this->count = 0;
+
+        ObjectName path[max_object_depth];
+        for (auto index = uint32_t(0); index < this->objects.size(); ++index) {
+            auto depth = this->objects[index] ? GetPath(this->objects[index], path) : 0;
+            if (depth) {
+                this->Insert(Hash(path, depth), index);
+            }
+        }
+    }
+
+public:
+    static auto Hash(const ObjectName* path, size_t depth) -> uint64_t
+    {
+        auto hash = uint64_t(14695981039346656037ull);
+        for (auto i = size_t(0); i < depth; ++i) {
+            hash = Mix(hash, path[i]);
+        }
+        return hash;
+    }
+
+    /*
+     * Indexes new objects and objects whose position changed hands. Returns
+     * the number of positions which were indexed again.
+     */
+    auto Update(Object* const* entries, size_t size) -> size_t
+    {
+        auto changes = size_t(0);
+        auto previous = this->objects.size();
+        this->objects.resize(size, nullptr);
+
+        ObjectName path[max_object_depth];
+        for (auto index = uint32_t(0); index < size; ++index) {
+            auto object = entries[index];
+            if (index < previous && object == this->objects[index]) {
+                continue;
+            }
+
+            // Slots of a replaced object stay until the next rebuild, lookups skip them
+            this->objects[index] = object;
+            ++changes;
+
+            auto depth = object ? GetPath(object, path) : 0;
+            if (!depth) {
+                continue;
+            }
+
+            if ((this->count + 1) * 2 > this->slots.size()) {
+                this->Rebuild((std::max)(size_t(1024), this->slots.size() * 2));
+            } else {
+                this->Insert(Hash(path, depth), index);
+            }
+        }
+
+        return changes;
+    }
+
+    /*
+     * Returns the object with the path whose class has the name index
+     * className, or any class if className is negative.
+     */
+    auto Find(Object* const* entries, size_t size, const ObjectName* path, size_t depth, int className = -1) const
+        -> Object*
+    {
+        if (this->slots.empty() || !depth) {
+            return nullptr;
+        }
+
+        auto hash = Hash(path, depth);
+        auto mask = this->slots.size() - 1;
+
+        ObjectName candidate[max_object_depth];
+        for (auto slot = size_t(hash) & mask;; slot = (slot + 1) & mask) {
+            const auto& entry = this->slots[slot];
+            if (!entry.index) {
+                return nullptr;
+            }
+
+            if (entry.hash != hash) {
+                continue;
+            }
+
+            // The object might be gone or replaced since the last update
+            auto index = entry.index - 1;
+            auto object = index < size ? entries[index] : nullptr;
+            if (!object || object != this->objects[index]) {
+                continue;
+            }
+
+            if (className >= 0
+                && (!object->class_object || uint32_t(object->class_object->name.index) != uint32_t(className))) {
+                continue;
+            }
+
+            if (GetPath(object, candidate) != depth) {
+                continue;
+            }
+
+            auto matches = true;
+            for (auto i = size_t(0); i < depth && matches; ++i) {
+                matches = candidate[i] == path[i];
+            }
+
+            if (matches) {
+                return object;
+            }
+        }
+    }
+
+    auto Clear() -> void
+    {
+        this->objects.clear();
+        this->slots.clear();
+        this->count = 0;
+    }
+
+    inline auto size() const -> size_t { return this->objects.size(); }
+};
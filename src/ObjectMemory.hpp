@@ -0,0 +1,195 @@
+/*
+ * Copyright (c) 2022-2023, NeKz
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+/*
+ * Estimates how much memory the objects of every class and package take.
+ *
+ * An instance takes the property size of its class plus the capacity of
+ * every dynamic array it owns, i.e. TArray and FString properties. Nested
+ * arrays are not followed because that would mean reading through pointers
+ * of objects which might be freed by now.
+ *
+ * Step walks budget slots of the object table per call and publishes the
+ * totals once a pass reaches the end, so a report costs a bounded amount of
+ * work per tick. Objects which get created or destroyed during a pass are
+ * counted if the walk sees them. Object has to provide class_object and
+ * outer_object like UObject, Class has to provide property_size like
+ * UStruct. Not thread-safe.
+ */
+template <typename Object, typename Class = std::remove_pointer_t<decltype(Object::class_object)>>
+class ObjectMemory {
+public:
+    /*
+     * Dynamic array at offset of an instance which owns max * element_size
+     * bytes, see TArray.
+     */
+    struct OwnedArray {
+        int32_t offset;
+        uint32_t element_size;
+    };
+
+    // Outer chains are short, the limit only guards against cycles. Callers which name packages stop there too.
+    static constexpr size_t max_outer_depth = 64;
+
+    struct Usage {
+        std::string name;
+        uint32_t instances;
+        uint64_t bytes; // Instances times property size
+        uint64_t heap_bytes; // Capacity of owned arrays
+    };
+
+private:
+    // Same layout as TArray
+    struct ArrayHeader {
+        const void* data;
+        uint32_t size;
+        uint32_t max;
+    };
+
+    std::unordered_map<const Class*, std::vector<OwnedArray>> arrays;
+    std::unordered_map<const void*, size_t> class_rows;
+    std::unordered_map<const void*, size_t> package_rows;
+    std::vector<Usage> classes;
+    std::vector<Usage> packages;
+    size_t cursor = 0;
+
+    std::vector<Usage> last_classes;
+    std::vector<Usage> last_packages;
+    size_t passes = 0;
+
+    template <typename Key, typename GetName>
+    static auto Account(std::unordered_map<const void*, size_t>& rows, std::vector<Usage>& usages, const Key* key,
+        GetName& get_name, uint64_t bytes, uint64_t heap_bytes) -> void
+    {
+        auto [row, inserted] = rows.try_emplace(key, usages.size());
+        if (inserted) {
+            // Named when first seen, the object might be gone by the end of the pass
+            usages.push_back({ get_name(key), 0, 0, 0 });
+        }
+
+        auto& usage = usages[row->second];
+        usage.instances += 1;
+        usage.bytes += bytes;
+        usage.heap_bytes += heap_bytes;
+    }
+
+    static auto Sorted(std::vector<Usage>& usages) -> std::vector<Usage>
+    {
+        std::stable_sort(usages.begin(), usages.end(),
+            [](const Usage& a, const Usage& b) { return a.bytes + a.heap_bytes > b.bytes + b.heap_bytes; });
+        return std::move(usages);
+    }
+
+public:
+    /*
+     * Accounts the next budget slots. get_arrays(class_object, arrays) adds
+     * the owned arrays of class_object including inherited ones, it gets
+     * called once per class and pass. get_name names a class or a package
+     * and gets called with a Class or an Object pointer. Returns true if the
+     * pass completed and a new report got published.
+     */
+    template <typename GetArrays, typename GetName>
+    auto Step(Object* const* entries, size_t size, size_t budget, GetArrays get_arrays, GetName get_name) -> bool
+    {
+        if (this->cursor == 0) {
+            this->arrays.clear();
+            this->class_rows.clear();
+            this->package_rows.clear();
+            this->classes.clear();
+            this->packages.clear();
+        }
+
+        auto end = (std::min)(size, this->cursor + budget);
+        for (; this->cursor < end; ++this->cursor) {
+            auto object = entries[this->cursor];
+            auto class_object = object ? static_cast<const Class*>(object->class_object) : nullptr;
+            if (!class_object) {
+                continue;
+            }
+
+            auto bytes = uint64_t(uint32_t(class_object->property_size));
+
+            auto [owned, inserted] = this->arrays.try_emplace(class_object);
+            if (inserted) {
+                get_arrays(class_object, owned->second);
+                std::erase_if(owned->second, [bytes](const OwnedArray& array) {
+                    return array.offset < 0 || uint64_t(array.offset) + sizeof(ArrayHeader) > bytes;
+                });
+            }
+
+            auto heap_bytes = uint64_t(0);
+            for (const auto& array : owned->second) {
+                auto header = ArrayHeader();
+                std::memcpy(&header, reinterpret_cast<const uint8_t*>(object) + array.offset, sizeof(header));
+                if (header.data) {
+                    heap_bytes += uint64_t(header.max) * array.element_size;
+                }
+            }
+
+            auto package = static_cast<const Object*>(object);
+            for (auto depth = size_t(0); package->outer_object && depth < max_outer_depth; ++depth) {
+                package = package->outer_object;
+            }
+
+            Account(this->class_rows, this->classes, class_object, get_name, bytes, heap_bytes);
+            Account(this->package_rows, this->packages, package, get_name, bytes, heap_bytes);
+        }
+
+        if (this->cursor < size) {
+            return false;
+        }
+
+        this->last_classes = Sorted(this->classes);
+        this->last_packages = Sorted(this->packages);
+        this->cursor = 0;
+        ++this->passes;
+        return true;
+    }
+
+    /*
+     * Totals of the last completed pass, largest first.
+     */
+    inline auto GetClasses() const -> const std::vector<Usage>& { return this->last_classes; }
+    inline auto GetPackages() const -> const std::vector<Usage>& { return this->last_packages; }
+    inline auto GetPassCount() const -> size_t { return this->passes; }
+    inline auto GetCursor() const -> size_t { return this->cursor; }
+
+    /*
+     * Both tables of the last pass as CSV with a kind column.
+     */
+    auto ToCsv() const -> std::string
+    {
+        auto csv = std::string("kind,name,instances,bytes,heap_bytes\n");
+        auto append = [&csv](const char* kind, const std::vector<Usage>& usages) {
+            for (const auto& usage : usages) {
+                // Object names never contain quotes or commas but keep the file valid anyway
+                auto name = usage.name;
+                for (auto quote = name.find('"'); quote != std::string::npos; quote = name.find('"', quote + 2)) {
+                    name.insert(quote, 1, '"');
+                }
+                csv.append(kind).append(",\"").append(name).append("\",");
+                csv.append(std::to_string(usage.instances)).append(",");
+                csv.append(std::to_string(usage.bytes)).append(",");
+                csv.append(std::to_string(usage.heap_bytes)).append("\n");
+            }
+        };
+        append("class", this->last_classes);
+        append("package", this->last_packages);
+        return csv;
+    }
+
+    auto Clear() -> void { *this = ObjectMemory(); }
+};
@@ -0,0 +1,245 @@
+/*
+ * Copyright (c) 2022-2023, NeKz
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "PatchSet.hpp"
+#include <algorithm>
+#include <cstring>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <cstdio>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+struct PageRun {
+    uintptr_t base;
+    size_t size;
+    uint32_t protection; // PAGE_* on Windows, PROT_* on Linux
+    uintptr_t allocation; // VirtualProtect cannot span two allocations
+};
+
+static auto writable_protection(uint32_t protection) -> uint32_t
+{
+#ifdef _WIN32
+    auto executable = protection & (PAGE_EXECUTE | PAGE_EXECUTE_READ | PAGE_EXECUTE_READWRITE | PAGE_EXECUTE_WRITECOPY);
+    return executable ? PAGE_EXECUTE_READWRITE : PAGE_READWRITE;
+#else
+    return protection | PROT_READ | PROT_WRITE;
+#endif
+}
+
+static auto set_protection(const PageRun& run, uint32_t protection) -> bool
+{
+#ifdef _WIN32
+    auto old_protection = DWORD(0);
+    return VirtualProtect(LPVOID(run.base), run.size, DWORD(protection), &old_protection);
+#else
+    return !mprotect(reinterpret_cast<void*>(run.base), run.size, int(protection));
+#endif
+}
+
+static auto flush_instruction_cache(uintptr_t start, uintptr_t end) -> void
+{
+#ifdef _WIN32
+    FlushInstructionCache(GetCurrentProcess(), LPCVOID(start), end - start);
+#else
+    __builtin___clear_cache(reinterpret_cast<char*>(start), reinterpret_cast<char*>(end));
+#endif
+}
+
+/*
+ * Looks up the current protection of every page and merges neighbouring
+ * pages with the same protection into runs. Fails if a page is not mapped.
+ */
+static auto query_runs(const std::vector<uintptr_t>& pages, size_t page_size, std::vector<PageRun>* runs) -> bool
+{
+    auto add = [&](uintptr_t page, uint32_t protection, uintptr_t allocation) {
+        auto last = runs->empty() ? nullptr : &runs->back();
+        if (last && last->base + last->size == page && last->protection == protection
+            && last->allocation == allocation) {
+            last->size += page_size;
+        } else {
+            runs->push_back({ page, page_size, protection, allocation });
+        }
+    };
+
+#ifdef _WIN32
+    for (auto page : pages) {
+        auto info = MEMORY_BASIC_INFORMATION();
+        if (VirtualQuery(LPCVOID(page), &info, sizeof(info)) != sizeof(info) || info.State != MEM_COMMIT) {
+            return false;
+        }
+
+        add(page, info.Protect, uintptr_t(info.AllocationBase));
+    }
+#else
+    struct Mapping {
+        uintptr_t start;
+        uintptr_t end;
+        uint32_t protection;
+    };
+
+    auto mappings = std::vector<Mapping>();
+
+    auto maps = std::fopen("/proc/self/maps", "r");
+    if (!maps) {
+        return false;
+    }
+
+    char line[4096 + 128];
+    while (std::fgets(line, sizeof(line), maps)) {
+        auto start = 0ull;
+        auto end = 0ull;
+        char permissions[5] = {};
+        if (std::sscanf(line, "%llx-%llx %4s", &start, &end, permissions) == 3) {
+            auto protection = uint32_t(PROT_NONE);
+            protection |= permissions[0] == 'r' ? PROT_READ : 0;
+            protection |= permissions[1] == 'w' ? PROT_WRITE : 0;
+            protection |= permissions[2] == 'x' ? PROT_EXEC : 0;
+            mappings.push_back({ uintptr_t(start), uintptr_t(end), protection });
+        }
+    }
+
+    std::fclose(maps);
+
+    // Both lists are sorted, one pass is enough
+    auto mapping = mappings.begin();
+    for (auto page : pages) {
+        while (mapping != mappings.end() && mapping->end <= page) {
+            ++mapping;
+        }
+
+        if (mapping == mappings.end() || mapping->start > page) {
+            return false;
+        }
+
+        add(page, mapping->protection, 0);
+    }
+#endif
+
+    return true;
+}
+
+auto Memory::PatchSet::GetPageSize() -> size_t
+{
+#ifdef _WIN32
+    auto info = SYSTEM_INFO();
+    GetSystemInfo(&info);
+    return size_t(info.dwPageSize);
+#else
+    return size_t(sysconf(_SC_PAGESIZE));
+#endif
+}
+
+auto Memory::PatchSet::Add(uintptr_t location, const uint8_t* bytes, size_t size) -> bool
+{
+    if (this->applied || !location || !bytes || !size) {
+        return false;
+    }
+
+    for (const auto& patch : this->patches) {
+        if (location < patch.location + patch.bytes.size() && patch.location < location + size) {
+            return false;
+        }
+    }
+
+    this->patches.push_back({ location, std::vector<uint8_t>(bytes, bytes + size), std::vector<uint8_t>(size) });
+    return true;
+}
+auto Memory::PatchSet::Apply() -> bool
+{
+    if (this->applied || !this->Write(true)) {
+        return false;
+    }
+
+    this->applied = true;
+    return true;
+}
+auto Memory::PatchSet::Restore() -> bool
+{
+    if (!this->applied || !this->Write(false)) {
+        return false;
+    }
+
+    this->applied = false;
+    return true;
+}
+auto Memory::PatchSet::Clear() -> bool
+{
+    if (this->applied) {
+        return false;
+    }
+
+    this->patches.clear();
+    this->stats = {};
+    return true;
+}
+
+auto Memory::PatchSet::Write(bool apply) -> bool
+{
+    auto page_size = Memory::PatchSet::GetPageSize();
+
+    auto pages = std::vector<uintptr_t>();
+    auto start = UINTPTR_MAX;
+    auto end = uintptr_t(0);
+
+    for (const auto& patch : this->patches) {
+        auto patch_end = patch.location + patch.bytes.size();
+        for (auto page = patch.location & ~(page_size - 1); page < patch_end; page += page_size) {
+            pages.push_back(page);
+        }
+
+        start = (std::min)(start, patch.location);
+        end = (std::max)(end, patch_end);
+    }
+
+    std::sort(pages.begin(), pages.end());
+    pages.erase(std::unique(pages.begin(), pages.end()), pages.end());
+
+    this->stats = { pages.size(), 0 };
+
+    auto runs = std::vector<PageRun>();
+    if (!query_runs(pages, page_size, &runs)) {
+        return false;
+    }
+
+    for (auto run = runs.begin(); run != runs.end(); ++run) {
+        ++this->stats.protection_changes;
+        if (!set_protection(*run, writable_protection(run->protection))) {
+            // Nothing has been written yet, undo the runs which already changed
+            while (run != runs.begin()) {
+                --run;
+                ++this->stats.protection_changes;
+                set_protection(*run, run->protection);
+            }
+            return false;
+        }
+    }
+
+    if (apply) {
+        for (auto& patch : this->patches) {
+            std::memcpy(patch.original.data(), reinterpret_cast<void*>(patch.location), patch.original.size());
+            std::memcpy(reinterpret_cast<void*>(patch.location), patch.bytes.data(), patch.bytes.size());
+        }
+    } else {
+        for (auto patch = this->patches.rbegin(); patch != this->patches.rend(); ++patch) {
+            std::memcpy(reinterpret_cast<void*>(patch->location), patch->original.data(), patch->original.size());
+        }
+    }
+
+    if (start < end) {
+        flush_instruction_cache(start, end);
+    }
+
+    for (const auto& run : runs) {
+        ++this->stats.protection_changes;
+        set_protection(run, run.protection);
+    }
+
+    return true;
+}
@@ -0,0 +1,80 @@
+/*
+ * Copyright (c) 2022-2023, NeKz
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <vector>
+
+namespace Memory {
+
+/*
+ * Collection of byte patches which get applied and restored as one unit.
+ *
+ * Patches are grouped by page. Applying makes every touched page writable
+ * with one protection change per run of pages, writes all patches, flushes
+ * the instruction cache once and puts the old protection back. If a page
+ * cannot be made writable nothing gets written and the pages which were
+ * already changed get their old protection back.
+ *
+ * Other threads are not suspended, code which is patched while it runs can
+ * still observe a partial write.
+ */
+class PatchSet {
+public:
+    struct Patch {
+        uintptr_t location;
+        std::vector<uint8_t> bytes;
+        std::vector<uint8_t> original;
+    };
+
+    struct Stats {
+        size_t pages; // Pages touched by the last Apply or Restore
+        size_t protection_changes; // Calls to VirtualProtect or mprotect
+    };
+
+private:
+    std::vector<Patch> patches;
+    bool applied = false;
+    Stats stats = {};
+
+    auto Write(bool apply) -> bool;
+
+public:
+    /*
+     * Adds a patch. Fails if the set is applied or if the patch overlaps
+     * another one.
+     */
+    auto Add(uintptr_t location, const uint8_t* bytes, size_t size) -> bool;
+    inline auto Add(uintptr_t location, std::initializer_list<uint8_t> bytes) -> bool
+    {
+        return this->Add(location, bytes.begin(), bytes.size());
+    }
+
+    /*
+     * Writes every patch or none of them.
+     */
+    auto Apply() -> bool;
+
+    /*
+     * Writes back the original bytes of every patch or none of them.
+     */
+    auto Restore() -> bool;
+
+    /*
+     * Drops all patches, the set has to be restored first.
+     */
+    auto Clear() -> bool;
+
+    inline auto IsApplied() const -> bool { return this->applied; }
+    inline auto size() const -> size_t { return this->patches.size(); }
+    inline auto at(size_t index) const -> const Patch& { return this->patches[index]; }
+    inline auto GetStats() const -> const Stats& { return this->stats; }
+
+    static auto GetPageSize() -> size_t;
+};
+}
@@ -5,6 +5,7 @@
  */
 
 #pragma once
+#include "HookStats.hpp"
 #include "lib/minhook/MinHook.h"
 
 #define DECL_DETOUR(name, firstparam, ...)                                                                             \
@@ -0,0 +1,227 @@
+/*
+ * Copyright (c) 2022-2023, NeKz
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "RegionMap.hpp"
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <shared_mutex>
+#include <vector>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <cstdio>
+#include <cstring>
+#include <sys/uio.h>
+#include <unistd.h>
+#endif
+
+struct ReadableRange {
+    uintptr_t start;
+    uintptr_t end;
+};
+
+struct CachedRange {
+    ReadableRange range;
+    uint32_t generation;
+};
+
+// Nothing gets mapped below 64 KB, catches null and small garbage pointers without a lookup
+constexpr auto min_address = uintptr_t(0x10000);
+
+static std::shared_mutex regions_mutex;
+static std::vector<ReadableRange> regions; // Sorted and merged
+static std::atomic<uint32_t> regions_generation = 1; // Changes when ranges get removed
+static thread_local auto last_range = CachedRange { { 0, 0 }, 0 };
+
+static auto find_range(const std::vector<ReadableRange>& ranges, uintptr_t address) -> const ReadableRange*
+{
+    auto next = std::upper_bound(ranges.begin(), ranges.end(), address,
+        [](uintptr_t address, const ReadableRange& range) { return address < range.start; });
+    if (next == ranges.begin()) {
+        return nullptr;
+    }
+
+    --next;
+    return address < next->end ? &*next : nullptr;
+}
+
+#ifdef _WIN32
+static auto insert_range(std::vector<ReadableRange>& ranges, ReadableRange range) -> void
+{
+    // First range which overlaps or touches the new one
+    auto first = std::lower_bound(ranges.begin(), ranges.end(), range.start,
+        [](const ReadableRange& other, uintptr_t start) { return other.end < start; });
+
+    auto last = first;
+    while (last != ranges.end() && last->start <= range.end) {
+        range.start = (std::min)(range.start, last->start);
+        range.end = (std::max)(range.end, last->end);
+        ++last;
+    }
+
+    ranges.insert(ranges.erase(first, last), range);
+}
+
+static auto is_readable(const MEMORY_BASIC_INFORMATION& info) -> bool
+{
+    auto protect = info.Protect & 0xFF;
+    return info.State == MEM_COMMIT && !(info.Protect & PAGE_GUARD) && protect != PAGE_NOACCESS
+        && protect != PAGE_EXECUTE;
+}
+#endif
+
+static auto read_regions() -> std::vector<ReadableRange>
+{
+    auto ranges = std::vector<ReadableRange>();
+
+    auto add = [&ranges](uintptr_t start, uintptr_t end) {
+        if (!ranges.empty() && ranges.back().end == start) {
+            ranges.back().end = end;
+        } else {
+            ranges.push_back({ start, end });
+        }
+    };
+
+#ifdef _WIN32
+    auto address = uintptr_t(0);
+    auto info = MEMORY_BASIC_INFORMATION();
+    while (VirtualQuery(LPCVOID(address), &info, sizeof(info)) == sizeof(info)) {
+        auto next = uintptr_t(info.BaseAddress) + info.RegionSize;
+        if (is_readable(info)) {
+            add(uintptr_t(info.BaseAddress), next);
+        }
+
+        if (next <= address) {
+            break;
+        }
+        address = next;
+    }
+#else
+    auto maps = std::fopen("/proc/self/maps", "r");
+    if (!maps) {
+        return ranges;
+    }
+
+    char line[4096 + 128];
+    while (std::fgets(line, sizeof(line), maps)) {
+        auto start = 0ull;
+        auto end = 0ull;
+        char permissions[5] = {};
+        if (std::sscanf(line, "%llx-%llx %4s", &start, &end, permissions) != 3) {
+            continue;
+        }
+
+        // Reading [vvar] can fault even though it is mapped readable
+        if (permissions[0] == 'r' && !std::strstr(line, "[vvar")) {
+            add(uintptr_t(start), uintptr_t(end));
+        }
+    }
+
+    std::fclose(maps);
+#endif
+
+    return ranges;
+}
+
+/*
+ * Slow path for addresses which are not in the map yet.
+ */
+static auto map_range(uintptr_t address, uintptr_t end) -> bool
+{
+#ifdef _WIN32
+    auto lock = std::unique_lock(regions_mutex);
+
+    // Adds one region per query until [address, end) is covered or a query fails
+    auto position = address;
+    while (true) {
+        auto range = find_range(regions, position);
+        if (range) {
+            if (end <= range->end) {
+                break;
+            }
+
+            position = range->end;
+            continue;
+        }
+
+        auto info = MEMORY_BASIC_INFORMATION();
+        if (VirtualQuery(LPCVOID(position), &info, sizeof(info)) != sizeof(info) || !is_readable(info)) {
+            return false;
+        }
+
+        insert_range(regions, { uintptr_t(info.BaseAddress), uintptr_t(info.BaseAddress) + info.RegionSize });
+    }
+#else
+    // Linux has no query for a single address, a one byte read tells if something new got mapped
+    auto position = address;
+    {
+        auto lock = std::shared_lock(regions_mutex);
+        auto range = find_range(regions, address);
+        if (range) {
+            position = range->end;
+        }
+    }
+
+    auto byte = uint8_t();
+    struct iovec local = { &byte, 1 };
+    struct iovec remote = { reinterpret_cast<void*>(position), 1 };
+    if (process_vm_readv(getpid(), &local, 1, &remote, 1, 0) != 1) {
+        return false;
+    }
+
+    auto ranges = read_regions();
+    auto lock = std::unique_lock(regions_mutex);
+    regions = std::move(ranges);
+    regions_generation.fetch_add(1, std::memory_order_release);
+#endif
+
+    auto range = find_range(regions, address);
+    if (!range || end > range->end) {
+        return false;
+    }
+
+    last_range = { *range, regions_generation.load(std::memory_order_acquire) };
+    return true;
+}
+
+auto Memory::IsReadable(uintptr_t address, size_t size) -> bool
+{
+    auto end = address + size;
+    if (address < min_address || end < address) {
+        return false;
+    }
+
+    auto generation = regions_generation.load(std::memory_order_acquire);
+    if (last_range.generation == generation && address >= last_range.range.start && end <= last_range.range.end) {
+        return true;
+    }
+
+    {
+        auto lock = std::shared_lock(regions_mutex);
+        auto range = find_range(regions, address);
+        if (range && end <= range->end) {
+            last_range = { *range, generation };
+            return true;
+        }
+    }
+
+    return map_range(address, end);
+}
+auto Memory::RefreshRegions() -> void
+{
+    auto ranges = read_regions();
+
+    auto lock = std::unique_lock(regions_mutex);
+    regions = std::move(ranges);
+    regions_generation.fetch_add(1, std::memory_order_release);
+}
+auto Memory::GetRegionCount() -> size_t
+{
+    auto lock = std::shared_lock(regions_mutex);
+    return regions.size();
+}
@@ -0,0 +1,38 @@
+/*
+ * Copyright (c) 2022-2023, NeKz
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+namespace Memory {
+
+/*
+ * Map of the readable memory of this process, used to check pointers before
+ * following them instead of catching access violations.
+ *
+ * Readable regions are merged and kept sorted, a lookup is a binary search
+ * behind a per-thread cache of the last hit. Addresses which are not in the
+ * map get probed once (VirtualQuery on Windows, process_vm_readv on Linux)
+ * and the map only grows when the probe succeeds, bad pointers never trigger
+ * a rebuild.
+ *
+ * Memory which gets freed after it was mapped still counts as readable until
+ * the next RefreshRegions call. Long traversals like the dumpers refresh once
+ * before they start.
+ */
+auto IsReadable(uintptr_t address, size_t size = sizeof(uintptr_t)) -> bool;
+template <typename T> inline auto IsReadable(const T* object) -> bool
+{
+    return IsReadable(uintptr_t(object), sizeof(T));
+}
+
+/*
+ * Rebuilds the map from VirtualQuery or /proc/self/maps.
+ */
+auto RefreshRegions() -> void;
+auto GetRegionCount() -> size_t;
+}
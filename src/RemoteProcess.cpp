@@ -0,0 +1,584 @@
+/*
+ * Copyright (c) 2022-2023, NeKz
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "RemoteProcess.hpp"
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <cstring>
+
+#ifdef _WIN32
+// Last
+#include <psapi.h>
+#else
+#include <climits>
+#include <sys/uio.h>
+#endif
+
+// Most kernels limit a single process_vm_readv call to 1024 iovecs
+constexpr size_t max_batch_pages = 1024;
+
+static auto page_of(uintptr_t address) -> uintptr_t
+{
+    return address & ~uintptr_t(Memory::RemoteProcess::page_size - 1);
+}
+
+static auto equals_ignore_case(const char* a, const char* b) -> bool
+{
+    for (; *a && *b; ++a, ++b) {
+        if (std::tolower(static_cast<unsigned char>(*a)) != std::tolower(static_cast<unsigned char>(*b))) {
+            return false;
+        }
+    }
+    return *a == *b;
+}
+
+Memory::RemoteProcess::~RemoteProcess() { this->Close(); }
+
+auto Memory::RemoteProcess::Open(int pid) -> bool
+{
+    this->Close();
+
+#ifdef _WIN32
+    this->handle = OpenProcess(PROCESS_VM_READ | PROCESS_QUERY_INFORMATION, FALSE, DWORD(pid));
+    if (!this->handle) {
+        return false;
+    }
+#endif
+
+    this->pid = pid;
+
+    // Probe access, the first readable region has to be readable
+    for (const auto& region : this->GetRegions()) {
+        auto value = uint8_t();
+        if (this->Read(region.base, &value)) {
+            return true;
+        }
+    }
+
+    this->Close();
+    return false;
+}
+auto Memory::RemoteProcess::Close() -> void
+{
+#ifdef _WIN32
+    if (this->handle) {
+        CloseHandle(this->handle);
+        this->handle = nullptr;
+    }
+#endif
+
+    this->pid = 0;
+    this->InvalidateCache();
+    this->stats = {};
+}
+auto Memory::RemoteProcess::InvalidateCache() -> void
+{
+    this->pages.clear();
+    this->unreadable.clear();
+}
+
+auto Memory::RemoteProcess::ReadPages(uintptr_t address, uint8_t* buffer, size_t count, std::vector<bool>* readable)
+    -> void
+{
+    readable->assign(count, false);
+
+    auto page = size_t(0);
+    while (page < count) {
+        auto page_address = address + page * page_size;
+        if (this->unreadable.contains(page_address)) {
+            std::memset(buffer + page * page_size, 0, page_size);
+            ++page;
+            continue;
+        }
+
+        // Pages up to the next known unreadable one
+        auto batch = size_t(1);
+        while (page + batch < count && batch < max_batch_pages
+            && !this->unreadable.contains(page_address + batch * page_size)) {
+            ++batch;
+        }
+
+        ++this->stats.system_calls;
+
+        auto read_pages = size_t(0);
+#ifdef _WIN32
+        auto bytes = SIZE_T(0);
+        auto destination = buffer + page * page_size;
+        if (ReadProcessMemory(this->handle, LPCVOID(page_address), destination, batch * page_size, &bytes)) {
+            read_pages = batch;
+        } else if (batch > 1) {
+            // Whole call fails for a single bad page, find it one page at a time
+            for (; read_pages < batch; ++read_pages) {
+                ++this->stats.system_calls;
+                if (!ReadProcessMemory(this->handle, LPCVOID(page_address + read_pages * page_size),
+                        buffer + (page + read_pages) * page_size, page_size, &bytes)) {
+                    break;
+                }
+            }
+        }
+#else
+        // One remote iovec per page, partial reads stop at the first page which fails
+        struct iovec local = { buffer + page * page_size, batch * page_size };
+        struct iovec remote[max_batch_pages];
+        for (auto i = size_t(0); i < batch; ++i) {
+            remote[i] = { reinterpret_cast<void*>(page_address + i * page_size), page_size };
+        }
+
+        auto bytes = process_vm_readv(this->pid, &local, 1, remote, batch, 0);
+        read_pages = bytes > 0 ? size_t(bytes) / page_size : 0;
+#endif
+
+        for (auto i = size_t(0); i < read_pages; ++i) {
+            (*readable)[page + i] = true;
+        }
+        page += read_pages;
+
+        if (read_pages < batch) {
+            std::memset(buffer + page * page_size, 0, page_size);
+            this->unreadable.insert(address + page * page_size);
+            ++this->stats.unreadable_pages;
+            ++page;
+        }
+    }
+}
+
+/*
+ * Fetches pages into the cache, contiguous pages share one read.
+ */
+auto Memory::RemoteProcess::FillCache(const std::vector<uintptr_t>& missing) -> void
+{
+    if (this->pages.size() + missing.size() > max_cached_pages) {
+        this->pages.clear();
+    }
+
+    auto readable = std::vector<bool>();
+    for (auto first = size_t(0); first < missing.size();) {
+        auto count = size_t(1);
+        while (first + count < missing.size() && missing[first + count] == missing[first] + count * page_size) {
+            ++count;
+        }
+
+        auto buffer = std::vector<uint8_t>(count * page_size);
+        this->ReadPages(missing[first], buffer.data(), count, &readable);
+
+        for (auto i = size_t(0); i < count; ++i) {
+            if (readable[i]) {
+                auto page = std::make_unique<uint8_t[]>(page_size);
+                std::memcpy(page.get(), buffer.data() + i * page_size, page_size);
+                this->pages[missing[first] + i * page_size] = std::move(page);
+            }
+        }
+
+        first += count;
+    }
+}
+
+auto Memory::RemoteProcess::Read(uintptr_t address, void* buffer, size_t size) -> bool
+{
+    auto request = std::vector<ReadRequest> { { address, buffer, size, false } };
+    return this->ReadBatch(request);
+}
+auto Memory::RemoteProcess::ReadBatch(std::vector<Memory::RemoteProcess::ReadRequest>& requests) -> bool
+{
+    if (!this->IsOpen()) {
+        return false;
+    }
+
+    auto missing = std::vector<uintptr_t>();
+    for (const auto& request : requests) {
+        if (!request.size || request.address + request.size < request.address) {
+            continue;
+        }
+
+        for (auto page = page_of(request.address); page < request.address + request.size; page += page_size) {
+            if (this->pages.contains(page)) {
+                ++this->stats.cache_hits;
+            } else if (!this->unreadable.contains(page)) {
+                ++this->stats.cache_misses;
+                missing.push_back(page);
+            }
+        }
+    }
+
+    std::sort(missing.begin(), missing.end());
+    missing.erase(std::unique(missing.begin(), missing.end()), missing.end());
+    this->FillCache(missing);
+
+    auto succeeded = true;
+    for (auto& request : requests) {
+        request.succeeded = request.size && request.address + request.size >= request.address;
+
+        auto copied = size_t(0);
+        while (request.succeeded && copied < request.size) {
+            auto address = request.address + copied;
+            auto page = this->pages.find(page_of(address));
+            if (page == this->pages.end()) {
+                request.succeeded = false;
+                break;
+            }
+
+            auto offset = address - page_of(address);
+            auto length = (std::min)(page_size - offset, request.size - copied);
+            std::memcpy(static_cast<uint8_t*>(request.buffer) + copied, page->second.get() + offset, length);
+            copied += length;
+        }
+
+        succeeded = succeeded && request.succeeded;
+    }
+    return succeeded;
+}
+
+auto Memory::RemoteProcess::GetRegions() -> std::vector<Memory::RemoteProcess::Region>
+{
+    auto regions = std::vector<Region>();
+
+#ifdef _WIN32
+    auto address = uintptr_t(0);
+    auto info = MEMORY_BASIC_INFORMATION();
+    while (VirtualQueryEx(this->handle, LPCVOID(address), &info, sizeof(info)) == sizeof(info)) {
+        auto protect = info.Protect & 0xFF;
+        if (info.State == MEM_COMMIT && !(info.Protect & PAGE_GUARD) && protect != PAGE_NOACCESS
+            && protect != PAGE_EXECUTE) {
+            auto flags = uint32_t(SECTION_READ);
+            if (protect & (PAGE_READWRITE | PAGE_WRITECOPY | PAGE_EXECUTE_READWRITE | PAGE_EXECUTE_WRITECOPY)) {
+                flags |= SECTION_WRITE;
+            }
+            if (protect & (PAGE_EXECUTE | PAGE_EXECUTE_READ | PAGE_EXECUTE_READWRITE | PAGE_EXECUTE_WRITECOPY)) {
+                flags |= SECTION_EXECUTE;
+            }
+            regions.push_back({ uintptr_t(info.BaseAddress), uintptr_t(info.RegionSize), flags, "" });
+        }
+
+        auto next = uintptr_t(info.BaseAddress) + info.RegionSize;
+        if (next <= address) {
+            break;
+        }
+        address = next;
+    }
+#else
+    char path[64];
+    std::snprintf(path, sizeof(path), "/proc/%d/maps", this->pid);
+
+    auto maps = std::fopen(path, "r");
+    if (!maps) {
+        return regions;
+    }
+
+    char line[MAX_PATH + 128];
+    while (std::fgets(line, sizeof(line), maps)) {
+        auto start = 0ull;
+        auto end = 0ull;
+        char permissions[5] = {};
+        auto name_offset = 0;
+        if (std::sscanf(line, "%llx-%llx %4s %*s %*s %*s %n", &start, &end, permissions, &name_offset) < 3) {
+            continue;
+        }
+
+        if (permissions[0] != 'r') {
+            continue;
+        }
+
+        auto name = std::string(name_offset ? line + name_offset : "");
+        while (!name.empty() && (name.back() == '\n' || name.back() == ' ')) {
+            name.pop_back();
+        }
+
+        auto flags = uint32_t(SECTION_READ) | (permissions[1] == 'w' ? SECTION_WRITE : 0)
+            | (permissions[2] == 'x' ? SECTION_EXECUTE : 0);
+        regions.push_back({ uintptr_t(start), uintptr_t(end - start), flags, name });
+    }
+
+    std::fclose(maps);
+#endif
+
+    return regions;
+}
+auto Memory::RemoteProcess::GetModules() -> std::vector<Memory::ModuleInfo>
+{
+    auto modules = std::vector<ModuleInfo>();
+
+#ifdef _WIN32
+    HMODULE hMods[1024];
+    DWORD cbNeeded;
+    if (!EnumProcessModulesEx(this->handle, hMods, sizeof(hMods), &cbNeeded, LIST_MODULES_ALL)) {
+        return modules;
+    }
+
+    auto count = cbNeeded / sizeof(HMODULE) < std::size(hMods) ? cbNeeded / sizeof(HMODULE) : std::size(hMods);
+    for (auto i = size_t(0); i < count; ++i) {
+        auto module = ModuleInfo();
+        auto modinfo = MODULEINFO();
+        if (!GetModuleFileNameExA(this->handle, hMods[i], module.path, sizeof(module.path))
+            || !GetModuleInformation(this->handle, hMods[i], &modinfo, sizeof(modinfo))) {
+            continue;
+        }
+
+        auto path = std::string(module.path);
+        std::snprintf(module.name, sizeof(module.name), "%s", path.substr(path.find_last_of("\\/") + 1).c_str());
+        module.base = uintptr_t(modinfo.lpBaseOfDll);
+        module.size = uintptr_t(modinfo.SizeOfImage);
+
+        uint8_t headers[page_size];
+        if (this->Read(module.base, headers, sizeof(headers))
+            && Memory::ParseSections(headers, sizeof(headers), &module.sections)) {
+            for (auto& section : module.sections) {
+                section.base += module.base;
+            }
+            Memory::ParseFingerprint(headers, sizeof(headers), &module.fingerprint);
+        }
+
+        modules.push_back(std::move(module));
+    }
+#else
+    // Every file mapping is a module, its mappings are the sections
+    for (const auto& region : this->GetRegions()) {
+        if (region.path.empty() || region.path[0] != '/') {
+            continue;
+        }
+
+        auto module = std::find_if(modules.begin(), modules.end(),
+            [&](const ModuleInfo& item) { return region.path == item.path; });
+
+        if (module == modules.end()) {
+            modules.emplace_back();
+            module = modules.end() - 1;
+            std::snprintf(module->path, sizeof(module->path), "%s", region.path.c_str());
+            std::snprintf(module->name, sizeof(module->name), "%s",
+                region.path.substr(region.path.find_last_of('/') + 1).c_str());
+            module->base = region.base;
+        }
+
+        auto section = SectionInfo();
+        std::snprintf(section.name, sizeof(section.name), "load%d", int(module->sections.size()));
+        section.base = region.base;
+        section.size = region.size;
+        section.flags = region.flags;
+        module->sections.push_back(section);
+
+        auto module_end = (std::max)(module->base + module->size, region.base + region.size);
+        module->base = (std::min)(module->base, region.base);
+        module->size = module_end - module->base;
+    }
+#endif
+
+    return modules;
+}
+auto Memory::RemoteProcess::TryGetModule(const char* moduleName, Memory::ModuleInfo* info) -> bool
+{
+    for (auto& module : this->GetModules()) {
+        if (moduleName && equals_ignore_case(module.name, moduleName)) {
+            if (info) {
+                *info = std::move(module);
+            }
+            return true;
+        }
+    }
+    return false;
+}
+
+/*
+ * Streams the readable parts of [start, end) in chunks. Chunks overlap by
+ * overlap bytes and callback(data, address, size, limit) has to ignore matches
+ * at or after limit. Returning false stops the scan.
+ */
+template <typename F>
+static auto for_each_readable(Memory::RemoteProcess* process, const std::vector<Memory::RemoteProcess::Region>& regions,
+    uintptr_t start, uintptr_t end, size_t overlap, F callback) -> void
+{
+    const auto page_size = Memory::RemoteProcess::page_size;
+
+    auto buffer = std::vector<uint8_t>(Memory::RemoteProcess::scan_chunk_size + overlap + 2 * page_size);
+    auto readable = std::vector<bool>();
+
+    for (const auto& region : regions) {
+        auto region_start = (std::max)(start, region.base);
+        auto region_end = (std::min)(end, region.base + region.size);
+
+        for (auto position = region_start; position < region_end;) {
+            auto chunk_end = (std::min)(region_end, position + Memory::RemoteProcess::scan_chunk_size);
+            auto read_end = (std::min)(region_end, chunk_end + overlap);
+
+            auto first_page = page_of(position);
+            auto page_count = (read_end - first_page + page_size - 1) / page_size;
+            process->ReadPages(first_page, buffer.data(), page_count, &readable);
+
+            // Matches must not cross unreadable pages
+            for (auto page = size_t(0); page < page_count;) {
+                if (!readable[page]) {
+                    ++page;
+                    continue;
+                }
+
+                auto run = page;
+                while (run < page_count && readable[run]) {
+                    ++run;
+                }
+
+                auto run_start = (std::max)(position, first_page + page * page_size);
+                auto run_end = (std::min)(read_end, first_page + run * page_size);
+                if (run_start < run_end
+                    && !callback(buffer.data() + (run_start - first_page), run_start, run_end - run_start, chunk_end)) {
+                    return;
+                }
+
+                page = run;
+            }
+
+            position = chunk_end;
+        }
+    }
+}
+
+auto Memory::RemoteProcess::Find(uintptr_t start, uintptr_t end, const Scanner::SignatureView& signature)
+    -> uintptr_t
+{
+    auto result = uintptr_t(0);
+    for_each_readable(this, this->GetRegions(), start, end, signature.size - 1,
+        [&](const uint8_t* data, uintptr_t address, size_t size, uintptr_t limit) {
+            auto match = Scanner::Find(data, data + size, signature);
+            if (match && address + (match - data) < limit) {
+                result = address + (match - data);
+            }
+            return !result;
+        });
+    return result;
+}
+auto Memory::RemoteProcess::FindAll(uintptr_t start, uintptr_t end, const Scanner::SignatureView& signature)
+    -> std::vector<uintptr_t>
+{
+    auto result = std::vector<uintptr_t>();
+    for_each_readable(this, this->GetRegions(), start, end, signature.size - 1,
+        [&](const uint8_t* data, uintptr_t address, size_t size, uintptr_t limit) {
+            for (auto match : Scanner::FindAll(data, data + size, signature)) {
+                if (address + (match - data) < limit) {
+                    result.push_back(address + (match - data));
+                }
+            }
+            return true;
+        });
+    return result;
+}
+
+/*
+ * Calls callback(start, end) for every range of a remote module which matches the section filter.
+ */
+template <typename F> static auto for_each_range(const Memory::ModuleInfo& info, Memory::Section filter, F callback)
+{
+    if (filter == Memory::Section::Image || info.sections.empty()) {
+        callback(info.base, info.base + info.size);
+        return;
+    }
+
+    for (const auto& section : info.sections) {
+        if (Memory::MatchesSection(section, filter) && !callback(section.base, section.base + section.size)) {
+            return;
+        }
+    }
+}
+
+auto Memory::RemoteProcess::Scan(const char* moduleName, const char* pattern, int offset, Memory::Section section)
+    -> uintptr_t
+{
+    auto signature = Scanner::Signature();
+    if (!Scanner::Parse(pattern, &signature)) {
+        return 0;
+    }
+
+    return this->Scan(moduleName, signature.view(), offset, section);
+}
+auto Memory::RemoteProcess::Scan(const char* moduleName, const Scanner::SignatureView& signature, int offset,
+    Memory::Section section) -> uintptr_t
+{
+    auto result = uintptr_t(0);
+
+    auto info = ModuleInfo();
+    if (this->TryGetModule(moduleName, &info)) {
+        for_each_range(info, section, [&](uintptr_t start, uintptr_t end) {
+            result = this->Find(start, end, signature);
+            return !result;
+        });
+    }
+    return result ? result + offset : 0;
+}
+auto Memory::RemoteProcess::MultiScan(const char* moduleName, const char* pattern, int offset,
+    Memory::Section section) -> std::vector<uintptr_t>
+{
+    auto result = std::vector<uintptr_t>();
+
+    auto signature = Scanner::Signature();
+    auto info = ModuleInfo();
+    if (Scanner::Parse(pattern, &signature) && this->TryGetModule(moduleName, &info)) {
+        for_each_range(info, section, [&](uintptr_t start, uintptr_t end) {
+            for (auto match : this->FindAll(start, end, signature.view())) {
+                result.push_back(match + offset);
+            }
+            return true;
+        });
+    }
+    return result;
+}
+auto Memory::RemoteProcess::Scan(const char* moduleName, const Memory::Pattern* pattern, Memory::Section section)
+    -> std::vector<uintptr_t>
+{
+    auto result = std::vector<uintptr_t>();
+
+    auto address = this->Scan(moduleName, pattern->binary, 0, section);
+    if (address) {
+        for (auto const& offset : pattern->offsets) {
+            result.push_back(address + offset);
+        }
+    }
+    return result;
+}
+auto Memory::RemoteProcess::MultiScan(const char* moduleName, const Memory::Patterns* patterns,
+    Memory::Section section) -> std::vector<std::vector<uintptr_t>>
+{
+    auto results = std::vector<std::vector<uintptr_t>>();
+
+    auto info = ModuleInfo();
+    if (!this->TryGetModule(moduleName, &info)) {
+        return results;
+    }
+
+    auto signatures = std::vector<Scanner::SignatureView>();
+    for (const auto& pattern : *patterns) {
+        signatures.push_back(pattern->binary);
+    }
+
+    // One streamed pass over the target for all patterns
+    auto set = Scanner::SignatureSet(signatures);
+    auto matches = std::vector<std::vector<uintptr_t>>(patterns->size());
+    auto regions = this->GetRegions();
+    auto overlap = set.max_signature_size() ? set.max_signature_size() - 1 : 0;
+
+    for_each_range(info, section, [&](uintptr_t start, uintptr_t end) {
+        for_each_readable(this, regions, start, end, overlap,
+            [&](const uint8_t* data, uintptr_t address, size_t size, uintptr_t limit) {
+                auto found = set.FindAll(data, data + size);
+                for (auto i = size_t(0); i < found.size(); ++i) {
+                    for (auto match : found[i]) {
+                        if (address + (match - data) < limit) {
+                            matches[i].push_back(address + (match - data));
+                        }
+                    }
+                }
+                return true;
+            });
+        return true;
+    });
+
+    for (auto i = size_t(0); i < patterns->size(); ++i) {
+        for (auto const& match : matches[i]) {
+            auto result = std::vector<uintptr_t>();
+            for (const auto& offset : patterns->at(i)->offsets) {
+                result.push_back(match + offset);
+            }
+            results.push_back(result);
+        }
+    }
+    return results;
+}
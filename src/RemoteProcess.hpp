@@ -0,0 +1,130 @@
+/*
+ * Copyright (c) 2022-2023, NeKz
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+#include "Memory.hpp"
+#include "Scanner.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace Memory {
+
+/*
+ * Read-only access to another process, e.g. to scan or dump the game from an
+ * external tool without injecting tem.
+ *
+ * Small reads go through a page-granular cache which gets filled with batched
+ * reads: one process_vm_readv call with a scatter list on Linux, one
+ * ReadProcessMemory call per contiguous run on Windows. Scans stream the
+ * target in large chunks past the cache. Pages which cannot be read are
+ * remembered and skipped.
+ *
+ * Not thread-safe, use one instance per thread.
+ */
+class RemoteProcess {
+public:
+    static constexpr size_t page_size = 0x1000;
+    static constexpr size_t max_cached_pages = 4096;
+    static constexpr size_t scan_chunk_size = 1024 * 1024;
+
+    struct Region {
+        uintptr_t base;
+        uintptr_t size;
+        uint32_t flags; // SECTION_READ, SECTION_WRITE and SECTION_EXECUTE
+        std::string path;
+    };
+
+    struct ReadRequest {
+        uintptr_t address;
+        void* buffer;
+        size_t size;
+        bool succeeded;
+    };
+
+    struct Stats {
+        size_t system_calls;
+        size_t cache_hits;
+        size_t cache_misses;
+        size_t unreadable_pages;
+    };
+
+private:
+#ifdef _WIN32
+    HANDLE handle = nullptr;
+#endif
+    int pid = 0;
+    std::unordered_map<uintptr_t, std::unique_ptr<uint8_t[]>> pages;
+    std::unordered_set<uintptr_t> unreadable;
+    Stats stats = {};
+
+    auto FillCache(const std::vector<uintptr_t>& missing) -> void;
+
+public:
+    RemoteProcess() = default;
+    RemoteProcess(const RemoteProcess&) = delete;
+    auto operator=(const RemoteProcess&) -> RemoteProcess& = delete;
+    ~RemoteProcess();
+
+    auto Open(int pid) -> bool;
+    auto Close() -> void;
+    inline auto IsOpen() const -> bool { return this->pid != 0; }
+    inline auto GetPid() const -> int { return this->pid; }
+    inline auto GetStats() const -> const Stats& { return this->stats; }
+
+    /*
+     * Drops cached pages, e.g. after the target changed its memory.
+     */
+    auto InvalidateCache() -> void;
+
+    /*
+     * Reads through the page cache. Fails if any byte is unreadable.
+     */
+    auto Read(uintptr_t address, void* buffer, size_t size) -> bool;
+    template <typename T> inline auto Read(uintptr_t address, T* value) -> bool
+    {
+        return this->Read(address, value, sizeof(T));
+    }
+
+    /*
+     * Reads many small ranges at once. All missing pages are fetched with one
+     * batched read. Returns true if every request succeeded.
+     */
+    auto ReadBatch(std::vector<ReadRequest>& requests) -> bool;
+
+    /*
+     * Reads count whole pages starting at a page aligned address past the
+     * cache. Pages which fail are zeroed and remembered as unreadable.
+     */
+    auto ReadPages(uintptr_t address, uint8_t* buffer, size_t count, std::vector<bool>* readable) -> void;
+
+    auto GetRegions() -> std::vector<Region>;
+    auto GetModules() -> std::vector<ModuleInfo>;
+    auto TryGetModule(const char* moduleName, ModuleInfo* info) -> bool;
+
+    /*
+     * Scans the readable parts of [start, end) in the target. Results are
+     * addresses in the target.
+     */
+    auto Find(uintptr_t start, uintptr_t end, const Scanner::SignatureView& signature) -> uintptr_t;
+    auto FindAll(uintptr_t start, uintptr_t end, const Scanner::SignatureView& signature) -> std::vector<uintptr_t>;
+
+    auto Scan(const char* moduleName, const char* pattern, int offset = 0, Section section = Section::Image)
+        -> uintptr_t;
+    auto Scan(const char* moduleName, const Scanner::SignatureView& signature, int offset = 0,
+        Section section = Section::Image) -> uintptr_t;
+    auto MultiScan(const char* moduleName, const char* pattern, int offset = 0, Section section = Section::Image)
+        -> std::vector<uintptr_t>;
+    auto Scan(const char* moduleName, const Pattern* pattern, Section section = Section::Image)
+        -> std::vector<uintptr_t>;
+    auto MultiScan(const char* moduleName, const Patterns* patterns, Section section = Section::Image)
+        -> std::vector<std::vector<uintptr_t>>;
+};
+}
@@ -5,6 +5,7 @@
  */
 
 #include "SDK.hpp"
+#include "Unicode.hpp"
 #include <windows.h>
 
 FString::FString()
@@ -28,18 +29,17 @@ FString::FString(const std::wstring& text)
 }
 auto FString::str() -> std::string { return wchar_to_utf8(this->data); }
 auto FString::str() const -> std::string { return wchar_to_utf8(this->data); }
+auto FString::str(char* buffer, size_t capacity) const -> size_t
+{
+    auto size = this->data ? std::wcslen(this->data) : 0;
+    return Unicode::ToUtf8(reinterpret_cast<const char16_t*>(this->data), size, buffer, capacity);
+}
 auto wchar_to_utf8(const wchar_t* data) -> std::string
 {
-    auto size = data && *data ? std::wcslen(data) + 1 : 0;
-    if (!size) {
-        return "";
-    }
+    static_assert(sizeof(wchar_t) == sizeof(char16_t), "engine strings are UTF-16");
 
-    auto string_size = WideCharToMultiByte(CP_UTF8, 0, &data[0], size, NULL, 0, NULL, NULL);
-    auto string = std::string(string_size, 0);
-    WideCharToMultiByte(CP_UTF8, 0, &data[0], size, &string[0], string_size, NULL, NULL);
-    string.erase(std::find(string.begin(), string.end(), '\0'), string.end());
-    return string;
+    auto size = data ? std::wcslen(data) : 0;
+    return Unicode::ToUtf8(reinterpret_cast<const char16_t*>(data), size);
 }
 
 auto UEngine::get_level_name() -> const wchar_t*
@@ -73,6 +73,11 @@ struct FString : TArray<wchar_t> {
     inline auto wstr() const -> std::wstring { return std::wstring(this->data); }
     auto str() -> std::string;
     auto str() const -> std::string;
+
+    /*
+     * Converts into buffer without allocating, see Unicode::ToUtf8.
+     */
+    auto str(char* buffer, size_t capacity) const -> size_t;
 };
 
 auto wchar_to_utf8(const wchar_t* data) -> std::string;
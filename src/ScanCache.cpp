@@ -0,0 +1,168 @@
+/*
+ * Copyright (c) 2022-2023, NeKz
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "ScanCache.hpp"
+#include <cinttypes>
+#include <cstdio>
+#include <mutex>
+#include <unordered_map>
+
+#define SCAN_CACHE_HEADER "# tem scan cache v1"
+
+struct CacheKey {
+    std::string module;
+    ScanCache::Fingerprint fingerprint;
+    uint64_t hash;
+
+    inline auto operator==(const CacheKey& other) const -> bool
+    {
+        return this->hash == other.hash && this->fingerprint == other.fingerprint && this->module == other.module;
+    }
+};
+
+struct CacheKeyHash {
+    inline auto operator()(const CacheKey& key) const -> size_t
+    {
+        return size_t(key.hash ^ std::hash<std::string>()(key.module) ^ (uint64_t(key.fingerprint.timestamp) << 32)
+            ^ key.fingerprint.size ^ key.fingerprint.checksum);
+    }
+};
+
+static std::mutex cache_mutex;
+static std::unordered_map<CacheKey, uintptr_t, CacheKeyHash> cache_entries;
+static auto cache_stats = ScanCache::Stats();
+static auto cache_enabled = true;
+
+auto ScanCache::HashSignature(const Scanner::SignatureView& signature, uint32_t salt) -> uint64_t
+{
+    auto hash = uint64_t(0xCBF29CE484222325);
+    auto mix = [&hash](uint8_t byte) {
+        hash ^= byte;
+        hash *= 0x100000001B3;
+    };
+
+    for (auto i = 0; i < 4; ++i) {
+        mix(uint8_t(salt >> (i * 8)));
+    }
+    for (auto i = size_t(0); i < signature.size; ++i) {
+        mix(signature.bytes[i] & signature.mask[i]);
+        mix(signature.mask[i]);
+    }
+    return hash;
+}
+
+auto ScanCache::Load(const std::string& path) -> bool
+{
+    auto file = std::fopen(path.c_str(), "r");
+    if (!file) {
+        return false;
+    }
+
+    auto lock = std::scoped_lock(cache_mutex);
+    cache_entries.clear();
+
+    char line[512];
+    while (std::fgets(line, sizeof(line), file)) {
+        if (line[0] == '#') {
+            continue;
+        }
+
+        char module[260] = {};
+        auto key = CacheKey();
+        auto rva = uint64_t();
+
+        auto fields = std::sscanf(line, "%259[^\t]\t%" SCNx32 "\t%" SCNx32 "\t%" SCNx32 "\t%" SCNx64 "\t%" SCNx64,
+            module, &key.fingerprint.timestamp, &key.fingerprint.size, &key.fingerprint.checksum, &key.hash, &rva);
+
+        if (fields == 6) {
+            key.module = module;
+            cache_entries[key] = uintptr_t(rva);
+        }
+    }
+
+    cache_stats.entries = cache_entries.size();
+
+    std::fclose(file);
+    return true;
+}
+auto ScanCache::Save(const std::string& path) -> bool
+{
+    auto file = std::fopen(path.c_str(), "w");
+    if (!file) {
+        return false;
+    }
+
+    auto lock = std::scoped_lock(cache_mutex);
+
+    std::fprintf(file, "%s\n", SCAN_CACHE_HEADER);
+    for (const auto& [key, rva] : cache_entries) {
+        std::fprintf(file, "%s\t%08" PRIx32 "\t%08" PRIx32 "\t%08" PRIx32 "\t%016" PRIx64 "\t%" PRIx64 "\n",
+            key.module.c_str(), key.fingerprint.timestamp, key.fingerprint.size, key.fingerprint.checksum, key.hash,
+            uint64_t(rva));
+    }
+
+    return std::fclose(file) == 0;
+}
+auto ScanCache::Clear() -> void
+{
+    auto lock = std::scoped_lock(cache_mutex);
+    cache_entries.clear();
+    cache_stats.entries = 0;
+}
+
+auto ScanCache::Lookup(const char* moduleName, const Fingerprint& fingerprint, uint64_t hash, uintptr_t* rva) -> bool
+{
+    auto lock = std::scoped_lock(cache_mutex);
+
+    if (!cache_enabled) {
+        return false;
+    }
+
+    auto entry = cache_entries.find(CacheKey { moduleName, fingerprint, hash });
+    if (entry == cache_entries.end()) {
+        ++cache_stats.misses;
+        return false;
+    }
+
+    ++cache_stats.hits;
+    *rva = entry->second;
+    return true;
+}
+auto ScanCache::Store(const char* moduleName, const Fingerprint& fingerprint, uint64_t hash, uintptr_t rva) -> void
+{
+    auto lock = std::scoped_lock(cache_mutex);
+
+    if (!cache_enabled) {
+        return;
+    }
+
+    cache_entries[CacheKey { moduleName, fingerprint, hash }] = rva;
+    cache_stats.entries = cache_entries.size();
+    ++cache_stats.stores;
+}
+
+auto ScanCache::SetEnabled(bool enabled) -> void
+{
+    auto lock = std::scoped_lock(cache_mutex);
+    cache_enabled = enabled;
+}
+auto ScanCache::IsEnabled() -> bool
+{
+    auto lock = std::scoped_lock(cache_mutex);
+    return cache_enabled;
+}
+auto ScanCache::GetStats() -> ScanCache::Stats
+{
+    auto lock = std::scoped_lock(cache_mutex);
+    return cache_stats;
+}
+auto ScanCache::ResetStats() -> void
+{
+    auto lock = std::scoped_lock(cache_mutex);
+    cache_stats.hits = 0;
+    cache_stats.misses = 0;
+    cache_stats.stores = 0;
+}
@@ -0,0 +1,63 @@
+/*
+ * Copyright (c) 2022-2023, NeKz
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+#include "Scanner.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/*
+ * Persistent cache of resolved signature addresses.
+ *
+ * Entries map a module name, the module fingerprint and a hash of the
+ * signature to the RVA of the match. A module with a different fingerprint,
+ * e.g. after a game update, never hits the cache and falls back to a full
+ * scan. The cache file is a plain text file with one entry per line.
+ */
+namespace ScanCache {
+
+struct Fingerprint {
+    uint32_t timestamp; // IMAGE_FILE_HEADER::TimeDateStamp, file modification time on Linux
+    uint32_t size; // IMAGE_OPTIONAL_HEADER::SizeOfImage, file size on Linux
+    uint32_t checksum; // IMAGE_OPTIONAL_HEADER::CheckSum
+
+    inline auto operator==(const Fingerprint& other) const -> bool
+    {
+        return this->timestamp == other.timestamp && this->size == other.size && this->checksum == other.checksum;
+    }
+};
+
+struct Stats {
+    size_t hits;
+    size_t misses;
+    size_t stores;
+    size_t entries;
+};
+
+/*
+ * FNV-1a over bytes, mask and a caller defined salt, e.g. the section filter.
+ */
+auto HashSignature(const Scanner::SignatureView& signature, uint32_t salt = 0) -> uint64_t;
+
+/*
+ * Replaces all entries with the ones of the file. Malformed lines are skipped.
+ */
+auto Load(const std::string& path) -> bool;
+auto Save(const std::string& path) -> bool;
+auto Clear() -> void;
+
+/*
+ * Lookups count as hit or miss, a disabled cache neither hits nor stores.
+ */
+auto Lookup(const char* moduleName, const Fingerprint& fingerprint, uint64_t hash, uintptr_t* rva) -> bool;
+auto Store(const char* moduleName, const Fingerprint& fingerprint, uint64_t hash, uintptr_t rva) -> void;
+
+auto SetEnabled(bool enabled) -> void;
+auto IsEnabled() -> bool;
+auto GetStats() -> Stats;
+auto ResetStats() -> void;
+}
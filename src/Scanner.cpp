@@ -0,0 +1,637 @@
+/*
+ * Copyright (c) 2022-2023, NeKz
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "Scanner.hpp"
+#include "Simd.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <thread>
+
+auto Scanner::Parse(const char* text, Scanner::Signature* signature) -> bool
+{
+    auto capacity = text ? std::strlen(text) / 2 + 1 : 0;
+    signature->bytes.resize(capacity);
+    signature->mask.resize(capacity);
+
+    auto size = size_t(0);
+    auto result = Scanner::Decode(text, signature->bytes.data(), signature->mask.data(), capacity, &size);
+
+    signature->bytes.resize(size);
+    signature->mask.resize(size);
+
+    return result
+        && Scanner::SelectAnchors(signature->bytes.data(), signature->mask.data(), signature->bytes.size(),
+            &signature->anchor, &signature->guard);
+}
+
+auto Scanner::Verify(const uint8_t* position, const Scanner::SignatureView& signature) -> bool
+{
+    for (auto i = size_t(0); i < signature.size; ++i) {
+        if ((position[i] & signature.mask[i]) != signature.bytes[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static auto find_scalar(const uint8_t* start, const uint8_t* end, const Scanner::SignatureView& signature)
+    -> const uint8_t*
+{
+    if (size_t(end - start) < signature.size) {
+        return nullptr;
+    }
+
+    auto anchor = signature.bytes[signature.anchor];
+    auto last = end - signature.size;
+    auto position = start;
+
+    while (position <= last) {
+        auto hit = static_cast<const uint8_t*>(
+            std::memchr(position + signature.anchor, anchor, size_t(last - position) + 1));
+        if (!hit) {
+            break;
+        }
+
+        auto candidate = hit - signature.anchor;
+        if (Scanner::Verify(candidate, signature)) {
+            return candidate;
+        }
+
+        position = candidate + 1;
+    }
+
+    return nullptr;
+}
+
+#if SIMD_X86
+TARGET_SSE2 static auto find_sse2(const uint8_t* start, const uint8_t* end, const Scanner::SignatureView& signature)
+    -> const uint8_t*
+{
+    auto length = size_t(end - start);
+    if (length < signature.size) {
+        return nullptr;
+    }
+
+    auto anchor = _mm_set1_epi8(char(signature.bytes[signature.anchor]));
+    auto guard = _mm_set1_epi8(char(signature.bytes[signature.guard]));
+
+    // Last candidate which still fits the whole signature.
+    auto last = length - signature.size;
+    auto position = size_t(0);
+
+    for (; position + 15 <= last; position += 16) {
+        auto block = start + position;
+        auto a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(block + signature.anchor));
+        auto g = _mm_loadu_si128(reinterpret_cast<const __m128i*>(block + signature.guard));
+
+        auto matches = uint32_t(_mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(a, anchor), _mm_cmpeq_epi8(g, guard))));
+        while (matches) {
+            auto candidate = block + count_trailing_zeros(matches);
+            if (Scanner::Verify(candidate, signature)) {
+                return candidate;
+            }
+            matches &= matches - 1;
+        }
+    }
+
+    return find_scalar(start + position, end, signature);
+}
+
+TARGET_AVX2 static auto find_avx2(const uint8_t* start, const uint8_t* end, const Scanner::SignatureView& signature)
+    -> const uint8_t*
+{
+    auto length = size_t(end - start);
+    if (length < signature.size) {
+        return nullptr;
+    }
+
+    auto anchor = _mm256_set1_epi8(char(signature.bytes[signature.anchor]));
+    auto guard = _mm256_set1_epi8(char(signature.bytes[signature.guard]));
+
+    auto last = length - signature.size;
+    auto position = size_t(0);
+
+    for (; position + 31 <= last; position += 32) {
+        auto block = start + position;
+        auto a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(block + signature.anchor));
+        auto g = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(block + signature.guard));
+
+        auto matches = uint32_t(
+            _mm256_movemask_epi8(_mm256_and_si256(_mm256_cmpeq_epi8(a, anchor), _mm256_cmpeq_epi8(g, guard))));
+        while (matches) {
+            auto candidate = block + count_trailing_zeros(matches);
+            if (Scanner::Verify(candidate, signature)) {
+                return candidate;
+            }
+            matches &= matches - 1;
+        }
+    }
+
+    return find_sse2(start + position, end, signature);
+}
+#endif
+
+auto Scanner::IsSupported(Scanner::Backend backend) -> bool
+{
+    switch (backend) {
+    case Backend::Scalar:
+        return true;
+#if SIMD_X86
+#ifdef _MSC_VER
+    case Backend::SSE2: {
+        int info[4] = {};
+        __cpuid(info, 1);
+        return (info[3] & (1 << 26)) != 0;
+    }
+    case Backend::AVX2: {
+        int info[4] = {};
+        __cpuid(info, 0);
+        if (info[0] < 7) {
+            return false;
+        }
+
+        // AVX has to be enabled by the OS as well
+        __cpuid(info, 1);
+        auto osxsave = (info[2] & (1 << 27)) != 0;
+        auto avx = (info[2] & (1 << 28)) != 0;
+        if (!osxsave || !avx || (_xgetbv(0) & 0x6) != 0x6) {
+            return false;
+        }
+
+        __cpuidex(info, 7, 0);
+        return (info[1] & (1 << 5)) != 0;
+    }
+#else
+    case Backend::SSE2:
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("sse2");
+    case Backend::AVX2:
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("avx2");
+#endif
+#endif
+    default:
+        return false;
+    }
+}
+
+auto Scanner::DetectBackend() -> Scanner::Backend
+{
+    if (Scanner::IsSupported(Backend::AVX2)) {
+        return Backend::AVX2;
+    }
+    if (Scanner::IsSupported(Backend::SSE2)) {
+        return Backend::SSE2;
+    }
+    return Backend::Scalar;
+}
+
+static auto active_backend() -> std::atomic<Scanner::Backend>&
+{
+    static std::atomic<Scanner::Backend> backend = Scanner::DetectBackend();
+    return backend;
+}
+
+auto Scanner::GetBackend() -> Scanner::Backend { return active_backend(); }
+auto Scanner::SetBackend(Scanner::Backend backend) -> bool
+{
+    if (!Scanner::IsSupported(backend)) {
+        return false;
+    }
+
+    active_backend() = backend;
+    return true;
+}
+auto Scanner::GetBackendName(Scanner::Backend backend) -> const char*
+{
+    switch (backend) {
+    case Backend::Scalar:
+        return "scalar";
+    case Backend::SSE2:
+        return "sse2";
+    case Backend::AVX2:
+        return "avx2";
+    default:
+        return "unknown";
+    }
+}
+
+auto Scanner::Find(const uint8_t* start, const uint8_t* end, const Scanner::SignatureView& signature,
+    Scanner::Backend backend) -> const uint8_t*
+{
+    if (!start || end <= start || !signature.size) {
+        return nullptr;
+    }
+
+    switch (backend) {
+#if SIMD_X86
+    case Backend::AVX2:
+        return find_avx2(start, end, signature);
+    case Backend::SSE2:
+        return find_sse2(start, end, signature);
+#endif
+    default:
+        return find_scalar(start, end, signature);
+    }
+}
+static auto thread_count() -> std::atomic<size_t>&
+{
+    static std::atomic<size_t> count = 1;
+    return count;
+}
+
+static auto resolve_thread_count(size_t threads) -> size_t
+{
+    if (!threads) {
+        threads = std::thread::hardware_concurrency();
+    }
+    return threads ? threads : 1;
+}
+
+auto Scanner::SetThreadCount(size_t count) -> void { thread_count() = count; }
+auto Scanner::GetThreadCount() -> size_t { return thread_count(); }
+
+static auto pack_range(uint64_t front, uint64_t back) -> uint64_t { return front | back << 32; }
+
+auto Scanner::ForEachChunk(const uint8_t* start, const uint8_t* end, size_t overlap, size_t threads,
+    const std::function<void(size_t chunk, const uint8_t* chunk_start, const uint8_t* chunk_end)>& callback) -> void
+{
+    if (!start || end <= start) {
+        return;
+    }
+
+    auto length = size_t(end - start);
+    auto chunks = (length + chunk_size - 1) / chunk_size;
+
+    auto run = [&](size_t chunk) {
+        auto chunk_start = start + chunk * chunk_size;
+        auto chunk_end = size_t(end - chunk_start) > chunk_size + overlap ? chunk_start + chunk_size + overlap : end;
+        callback(chunk, chunk_start, chunk_end);
+    };
+
+    threads = std::min(resolve_thread_count(threads), chunks);
+    if (threads <= 1) {
+        for (auto chunk = size_t(0); chunk < chunks; ++chunk) {
+            run(chunk);
+        }
+        return;
+    }
+
+    // Every worker owns a range of chunks [front, back) packed into a single atomic.
+    // Workers take chunks from the front of their own range and steal from the back
+    // of other ranges once their own range is empty.
+    auto ranges = std::vector<std::atomic<uint64_t>>(threads);
+    for (auto i = size_t(0); i < threads; ++i) {
+        ranges[i] = pack_range(chunks * i / threads, chunks * (i + 1) / threads);
+    }
+
+    auto take = [&](size_t owner, bool steal, size_t* chunk) -> bool {
+        auto& range = ranges[owner];
+        auto current = range.load();
+        while (true) {
+            auto front = current & 0xFFFFFFFF;
+            auto back = current >> 32;
+            if (front >= back) {
+                return false;
+            }
+
+            auto next = steal ? pack_range(front, back - 1) : pack_range(front + 1, back);
+            if (range.compare_exchange_weak(current, next)) {
+                *chunk = size_t(steal ? back - 1 : front);
+                return true;
+            }
+        }
+    };
+
+    auto worker = [&](size_t self) {
+        auto chunk = size_t(0);
+        while (true) {
+            if (take(self, false, &chunk)) {
+                run(chunk);
+                continue;
+            }
+
+            auto stolen = false;
+            for (auto i = size_t(1); i < threads && !stolen; ++i) {
+                stolen = take((self + i) % threads, true, &chunk);
+            }
+
+            if (!stolen) {
+                return;
+            }
+
+            run(chunk);
+        }
+    };
+
+    auto pool = std::vector<std::thread>();
+    for (auto i = size_t(1); i < threads; ++i) {
+        pool.emplace_back(worker, i);
+    }
+
+    worker(0);
+
+    for (auto& thread : pool) {
+        thread.join();
+    }
+}
+
+// Visits every match in [start, end) which starts before limit.
+static auto visit_all_until(const uint8_t* start, const uint8_t* end, const uint8_t* limit,
+    const Scanner::SignatureView& signature, Scanner::Backend backend, size_t index, Scanner::MatchVisitor& visitor)
+    -> bool
+{
+    while (auto match = Scanner::Find(start, end, signature, backend)) {
+        if (match >= limit) {
+            break;
+        }
+
+        if (!visitor.Visit(index, match)) {
+            return false;
+        }
+        start = match + 1;
+    }
+    return true;
+}
+
+// Appends every match in [start, end) which starts before limit.
+static auto find_all_until(const uint8_t* start, const uint8_t* end, const uint8_t* limit,
+    const Scanner::SignatureView& signature, Scanner::Backend backend, std::vector<const uint8_t*>& results) -> void
+{
+    auto append = [&results](size_t, const uint8_t* match) {
+        results.push_back(match);
+        return true;
+    };
+    auto visitor = Scanner::MatchCallback(append);
+    visit_all_until(start, end, limit, signature, backend, 0, visitor);
+}
+
+auto Scanner::Find(const uint8_t* start, const uint8_t* end, const Scanner::SignatureView& signature,
+    Scanner::Backend backend, size_t threads) -> const uint8_t*
+{
+    if (resolve_thread_count(threads) <= 1 || !start || size_t(end - start) <= chunk_size || !signature.size) {
+        return Scanner::Find(start, end, signature, backend);
+    }
+
+    auto chunks = (size_t(end - start) + chunk_size - 1) / chunk_size;
+    auto results = std::vector<const uint8_t*>(chunks);
+    auto first = std::atomic<size_t>(chunks);
+
+    Scanner::ForEachChunk(start, end, signature.size - 1, threads,
+        [&](size_t chunk, const uint8_t* chunk_start, const uint8_t* chunk_end) {
+            // Nothing to do when an earlier chunk already has a match
+            if (chunk > first) {
+                return;
+            }
+
+            auto match = Scanner::Find(chunk_start, chunk_end, signature, backend);
+            if (!match || match >= chunk_start + chunk_size) {
+                return;
+            }
+
+            results[chunk] = match;
+
+            auto current = first.load();
+            while (chunk < current && !first.compare_exchange_weak(current, chunk)) { }
+        });
+
+    return first < chunks ? results[first] : nullptr;
+}
+auto Scanner::Find(const uint8_t* start, const uint8_t* end, const Scanner::SignatureView& signature)
+    -> const uint8_t*
+{
+    return Scanner::Find(start, end, signature, Scanner::GetBackend(), Scanner::GetThreadCount());
+}
+auto Scanner::FindAll(const uint8_t* start, const uint8_t* end, const Scanner::SignatureView& signature,
+    size_t threads) -> std::vector<const uint8_t*>
+{
+    auto result = std::vector<const uint8_t*>();
+    auto backend = Scanner::GetBackend();
+
+    if (!start || end <= start || !signature.size) {
+        return result;
+    }
+
+    if (resolve_thread_count(threads) <= 1 || size_t(end - start) <= chunk_size) {
+        find_all_until(start, end, end, signature, backend, result);
+        return result;
+    }
+
+    auto chunks = (size_t(end - start) + chunk_size - 1) / chunk_size;
+    auto results = std::vector<std::vector<const uint8_t*>>(chunks);
+
+    Scanner::ForEachChunk(start, end, signature.size - 1, threads,
+        [&](size_t chunk, const uint8_t* chunk_start, const uint8_t* chunk_end) {
+            find_all_until(chunk_start, chunk_end, chunk_start + chunk_size, signature, backend, results[chunk]);
+        });
+
+    for (auto& matches : results) {
+        result.insert(result.end(), matches.begin(), matches.end());
+    }
+
+    return result;
+}
+auto Scanner::FindAll(const uint8_t* start, const uint8_t* end, const Scanner::SignatureView& signature)
+    -> std::vector<const uint8_t*>
+{
+    return Scanner::FindAll(start, end, signature, Scanner::GetThreadCount());
+}
+auto Scanner::ForEachMatch(const uint8_t* start, const uint8_t* end, const Scanner::SignatureView& signature,
+    Scanner::MatchVisitor& visitor) -> bool
+{
+    if (!start || end <= start || !signature.size) {
+        return true;
+    }
+
+    return visit_all_until(start, end, end, signature, Scanner::GetBackend(), 0, visitor);
+}
+
+static auto select_pair_anchor(const Scanner::SignatureView& signature, size_t* anchor) -> bool
+{
+    auto best = signature.size;
+    auto best_score = 0;
+
+    for (auto i = size_t(0); i + 1 < signature.size; ++i) {
+        if (!signature.mask[i] || !signature.mask[i + 1]) {
+            continue;
+        }
+
+        auto score = Scanner::ByteFrequency(signature.bytes[i]) + Scanner::ByteFrequency(signature.bytes[i + 1]);
+        if (best == signature.size || score < best_score) {
+            best = i;
+            best_score = score;
+        }
+    }
+
+    *anchor = best;
+    return best != signature.size;
+}
+
+static auto build_buckets(std::vector<Scanner::SignatureSet::Entry>& entries, uint32_t* buckets, size_t keys) -> void
+{
+    std::sort(entries.begin(), entries.end(), [](const auto& a, const auto& b) {
+        return a.key < b.key || (a.key == b.key && a.index < b.index);
+    });
+
+    auto entry = size_t(0);
+    for (auto key = size_t(0); key <= keys; ++key) {
+        while (entry < entries.size() && entries[entry].key < key) {
+            ++entry;
+        }
+        buckets[key] = uint32_t(entry);
+    }
+}
+
+Scanner::SignatureSet::SignatureSet(const std::vector<Scanner::SignatureView>& signatures)
+    : signatures(signatures)
+    , pair_buckets(65536 + 1)
+    , pair_filter(65536)
+{
+    for (auto i = uint32_t(0); i < signatures.size(); ++i) {
+        auto& signature = signatures[i];
+        if (!signature.size) {
+            continue;
+        }
+
+        this->max_size = std::max(this->max_size, signature.size);
+
+        auto anchor = size_t(0);
+        if (select_pair_anchor(signature, &anchor)) {
+            auto key = uint32_t(signature.bytes[anchor] | signature.bytes[anchor + 1] << 8);
+            this->pairs.push_back({ key, i, anchor });
+            this->pair_filter[key] = 1;
+        } else {
+            auto key = uint32_t(signature.bytes[signature.anchor]);
+            this->singles.push_back({ key, i, signature.anchor });
+            this->single_filter[key] = 1;
+        }
+    }
+
+    build_buckets(this->pairs, this->pair_buckets.data(), 65536);
+    build_buckets(this->singles, this->single_buckets, 256);
+}
+
+// Groups matches by the index of the signature.
+class MatchCollector final : public Scanner::MatchVisitor {
+private:
+    std::vector<std::vector<const uint8_t*>>& results;
+
+public:
+    MatchCollector(std::vector<std::vector<const uint8_t*>>& results)
+        : results(results)
+    {
+    }
+
+    auto Visit(size_t index, const uint8_t* match) -> bool override
+    {
+        this->results[index].push_back(match);
+        return true;
+    }
+};
+
+auto Scanner::SignatureSet::Sweep(const uint8_t* start, const uint8_t* end, const uint8_t* limit,
+    Scanner::MatchVisitor& visitor) const -> bool
+{
+    if (this->signatures.size() < SignatureSet::min_batch_size) {
+        auto backend = Scanner::GetBackend();
+        for (auto i = size_t(0); i < this->signatures.size(); ++i) {
+            if (!visit_all_until(start, end, limit, this->signatures[i], backend, i, visitor)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    auto verify = [&](const Scanner::SignatureSet::Entry& entry, const uint8_t* position) {
+        auto& signature = this->signatures[entry.index];
+        if (position < start + entry.anchor) {
+            return true;
+        }
+
+        auto candidate = position - entry.anchor;
+        if (candidate < limit && size_t(end - candidate) >= signature.size && Scanner::Verify(candidate, signature)) {
+            return visitor.Visit(entry.index, candidate);
+        }
+        return true;
+    };
+
+    if (!this->singles.empty()) {
+        for (auto position = start; position < end; ++position) {
+            auto key = uint32_t(position[0]);
+            if (this->single_filter[key]) {
+                for (auto i = this->single_buckets[key]; i < this->single_buckets[key + 1]; ++i) {
+                    if (!verify(this->singles[i], position)) {
+                        return false;
+                    }
+                }
+            }
+        }
+    }
+
+    if (!this->pairs.empty()) {
+        auto filter = this->pair_filter.data();
+        for (auto position = start; position + 1 < end; ++position) {
+            auto key = uint32_t(position[0] | position[1] << 8);
+            if (filter[key]) {
+                for (auto i = this->pair_buckets[key]; i < this->pair_buckets[key + 1]; ++i) {
+                    if (!verify(this->pairs[i], position)) {
+                        return false;
+                    }
+                }
+            }
+        }
+    }
+
+    return true;
+}
+auto Scanner::SignatureSet::FindAll(const uint8_t* start, const uint8_t* end, size_t threads) const
+    -> std::vector<std::vector<const uint8_t*>>
+{
+    auto results = std::vector<std::vector<const uint8_t*>>(this->signatures.size());
+    if (!start || end <= start || !this->max_size) {
+        return results;
+    }
+
+    if (resolve_thread_count(threads) <= 1 || size_t(end - start) <= chunk_size) {
+        auto visitor = MatchCollector(results);
+        this->Sweep(start, end, end, visitor);
+        return results;
+    }
+
+    auto chunks = (size_t(end - start) + chunk_size - 1) / chunk_size;
+    auto chunk_results = std::vector<std::vector<std::vector<const uint8_t*>>>(chunks);
+
+    Scanner::ForEachChunk(start, end, this->max_size - 1, threads,
+        [&](size_t chunk, const uint8_t* chunk_start, const uint8_t* chunk_end) {
+            chunk_results[chunk].resize(this->signatures.size());
+            auto visitor = MatchCollector(chunk_results[chunk]);
+            this->Sweep(chunk_start, chunk_end, chunk_start + chunk_size, visitor);
+        });
+
+    for (auto& chunk : chunk_results) {
+        for (auto i = size_t(0); i < results.size(); ++i) {
+            results[i].insert(results[i].end(), chunk[i].begin(), chunk[i].end());
+        }
+    }
+
+    return results;
+}
+auto Scanner::SignatureSet::FindAll(const uint8_t* start, const uint8_t* end) const
+    -> std::vector<std::vector<const uint8_t*>>
+{
+    return this->FindAll(start, end, Scanner::GetThreadCount());
+}
+auto Scanner::SignatureSet::ForEachMatch(const uint8_t* start, const uint8_t* end, Scanner::MatchVisitor& visitor) const
+    -> bool
+{
+    if (!start || end <= start || !this->max_size) {
+        return true;
+    }
+
+    return this->Sweep(start, end, end, visitor);
+}
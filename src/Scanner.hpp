@@ -0,0 +1,337 @@
+/*
+ * Copyright (c) 2022-2023, NeKz
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+/*
+ * Signature scanning engine used by Memory::FindAddress and friends.
+ *
+ * A signature is matched by filtering candidate positions with two of its
+ * non-wildcard bytes (the anchor and the guard) and then verifying the full
+ * pattern. The filter compares 16 (SSE2) or 32 (AVX2) positions per step,
+ * the backend is picked once by runtime CPU detection.
+ */
+namespace Scanner {
+
+enum class Backend {
+    Scalar,
+    SSE2,
+    AVX2,
+};
+
+struct SignatureView {
+    const uint8_t* bytes; // Wildcard bytes are stored as zero
+    const uint8_t* mask; // 0xFF for a fixed byte, 0x00 for a wildcard
+    size_t size;
+    size_t anchor; // Rarest fixed byte
+    size_t guard; // Second fixed byte, equal to anchor for single byte signatures
+};
+
+struct Signature {
+    std::vector<uint8_t> bytes;
+    std::vector<uint8_t> mask;
+    size_t anchor = 0;
+    size_t guard = 0;
+
+    inline auto view() const -> SignatureView
+    {
+        return { this->bytes.data(), this->mask.data(), this->bytes.size(), this->anchor, this->guard };
+    }
+};
+
+/*
+ * Most common bytes in x86 code, most frequent first.
+ */
+constexpr uint8_t common_bytes[] = {
+    0x00, 0xFF, 0x8B, 0x89, 0x24, 0x44, 0x48, 0x4C, 0x0F, 0x85, 0x74, 0x75, 0xE8, 0x83, 0x45, 0xCC,
+    0x01, 0x04, 0x08, 0x10, 0xC3, 0x50, 0x55, 0x8D, 0x90, 0x33, 0xC0, 0x6A, 0x68, 0xEB, 0xE9, 0xC7,
+};
+
+constexpr auto ByteFrequency(uint8_t byte) -> int
+{
+    for (auto i = size_t(0); i < sizeof(common_bytes); ++i) {
+        if (common_bytes[i] == byte) {
+            return int(sizeof(common_bytes) - i);
+        }
+    }
+    return 0;
+}
+
+constexpr auto HexValue(char c) -> int
+{
+    if (c >= '0' && c <= '9') {
+        return c - '0';
+    }
+    if (c >= 'a' && c <= 'f') {
+        return c - 'a' + 0xA;
+    }
+    if (c >= 'A' && c <= 'F') {
+        return c - 'A' + 0xA;
+    }
+    return -1;
+}
+
+/*
+ * Picks anchor and guard for a signature. Rare bytes make a better filter
+ * than common x86 opcodes like 00, FF, CC or 8B.
+ */
+constexpr auto SelectAnchors(const uint8_t* bytes, const uint8_t* mask, size_t size, size_t* anchor, size_t* guard)
+    -> bool
+{
+    auto best = size;
+    auto second = size;
+
+    for (auto i = size_t(0); i < size; ++i) {
+        if (!mask[i]) {
+            continue;
+        }
+
+        if (best == size || ByteFrequency(bytes[i]) < ByteFrequency(bytes[best])) {
+            second = best;
+            best = i;
+        } else if (second == size || ByteFrequency(bytes[i]) < ByteFrequency(bytes[second])) {
+            second = i;
+        }
+    }
+
+    if (best == size) {
+        return false;
+    }
+
+    *anchor = best;
+    *guard = second != size ? second : best;
+    return true;
+}
+
+/*
+ * Decodes "E8 ? ? ? ? 8B" into bytes and mask. Wildcards can be written as
+ * "?" or "??". Returns false for malformed input, signatures without a single
+ * fixed byte or if the buffers are too small.
+ */
+constexpr auto Decode(const char* text, uint8_t* bytes, uint8_t* mask, size_t capacity, size_t* size) -> bool
+{
+    *size = 0;
+
+    if (!text) {
+        return false;
+    }
+
+    auto fixed = false;
+    auto position = text;
+    while (*position) {
+        if (*position == ' ') {
+            ++position;
+            continue;
+        }
+
+        if (*size == capacity) {
+            return false;
+        }
+
+        if (position[0] == '?') {
+            position += position[1] == '?' ? 2 : 1;
+            bytes[*size] = 0x00;
+            mask[*size] = 0x00;
+        } else {
+            auto high = HexValue(position[0]);
+            auto low = high != -1 ? HexValue(position[1]) : -1;
+            if (low == -1) {
+                return false;
+            }
+
+            position += 2;
+            bytes[*size] = uint8_t(high << 4 | low);
+            mask[*size] = 0xFF;
+            fixed = true;
+        }
+
+        ++*size;
+
+        if (*position && *position != ' ') {
+            return false;
+        }
+    }
+
+    return fixed;
+}
+
+/*
+ * Signature which gets decoded at compile time. A malformed signature
+ * fails the build:
+ *
+ *     constexpr auto signature = Scanner::StaticSignature("E8 ? ? ? ? 8B");
+ */
+template <size_t Length> struct StaticSignature {
+    uint8_t bytes[Length / 2 + 1] = {};
+    uint8_t mask[Length / 2 + 1] = {};
+    size_t size = 0;
+    size_t anchor = 0;
+    size_t guard = 0;
+
+    consteval StaticSignature(const char (&text)[Length])
+    {
+        if (!Decode(text, this->bytes, this->mask, sizeof(this->bytes), &this->size)) {
+            throw "Malformed signature";
+        }
+
+        SelectAnchors(this->bytes, this->mask, this->size, &this->anchor, &this->guard);
+    }
+
+    constexpr auto view() const -> SignatureView
+    {
+        return { this->bytes, this->mask, this->size, this->anchor, this->guard };
+    }
+};
+
+/*
+ * Runtime version of StaticSignature for signatures which are not known at
+ * compile time.
+ */
+auto Parse(const char* text, Signature* signature) -> bool;
+
+auto Verify(const uint8_t* position, const SignatureView& signature) -> bool;
+
+/*
+ * Scans can optionally be split into chunks which get scanned by a small
+ * work-stealing pool. Chunks overlap by the signature size - 1 bytes so that
+ * no match gets lost and results are merged in address order.
+ *
+ * Thread count 1 scans on the calling thread (default), 0 uses one thread
+ * per hardware thread.
+ */
+constexpr size_t chunk_size = 256 * 1024;
+
+auto SetThreadCount(size_t count) -> void;
+auto GetThreadCount() -> size_t;
+
+/*
+ * Calls callback(chunk_start, chunk_end) for every chunk of [start, end).
+ * Chunks are extended by overlap bytes if possible, callback has to ignore
+ * matches which start at or after chunk_start + chunk_size.
+ */
+auto ForEachChunk(const uint8_t* start, const uint8_t* end, size_t overlap, size_t threads,
+    const std::function<void(size_t chunk, const uint8_t* chunk_start, const uint8_t* chunk_end)>& callback) -> void;
+
+/*
+ * Returns the first match in [start, end) or nullptr.
+ */
+auto Find(const uint8_t* start, const uint8_t* end, const SignatureView& signature) -> const uint8_t*;
+auto Find(const uint8_t* start, const uint8_t* end, const SignatureView& signature, Backend backend)
+    -> const uint8_t*;
+
+auto Find(const uint8_t* start, const uint8_t* end, const SignatureView& signature, Backend backend, size_t threads)
+    -> const uint8_t*;
+
+/*
+ * Returns every match in [start, end), overlapping matches included.
+ */
+auto FindAll(const uint8_t* start, const uint8_t* end, const SignatureView& signature) -> std::vector<const uint8_t*>;
+auto FindAll(const uint8_t* start, const uint8_t* end, const SignatureView& signature, size_t threads)
+    -> std::vector<const uint8_t*>;
+
+/*
+ * Receives the matches of a scan one at a time, returning false stops the
+ * scan. Index is the index of the signature in a SignatureSet and 0 for
+ * single signature scans.
+ */
+class MatchVisitor {
+public:
+    virtual auto Visit(size_t index, const uint8_t* match) -> bool = 0;
+
+protected:
+    ~MatchVisitor() = default;
+};
+
+/*
+ * Adapts a callable to MatchVisitor without allocating. The callable has to
+ * outlive the adapter.
+ */
+template <typename F> class MatchCallback final : public MatchVisitor {
+private:
+    F& callback;
+
+public:
+    MatchCallback(F& callback)
+        : callback(callback)
+    {
+    }
+
+    auto Visit(size_t index, const uint8_t* match) -> bool override { return this->callback(index, match); }
+};
+
+/*
+ * Calls the visitor for every match in [start, end) in address order. Scans
+ * on the calling thread and never allocates. Returns false if the visitor
+ * stopped the scan.
+ */
+auto ForEachMatch(const uint8_t* start, const uint8_t* end, const SignatureView& signature, MatchVisitor& visitor)
+    -> bool;
+
+/*
+ * Set of signatures which gets matched in a single sweep.
+ *
+ * Every signature is bucketed by a pair of adjacent fixed bytes. The sweep
+ * tests each 16-bit window against a 64K filter table and only verifies the
+ * signatures of a bucket when its entry is set. Signatures without two
+ * adjacent fixed bytes fall back to a single byte bucket. The cost of a sweep
+ * barely depends on the number of signatures. Small sets are faster with one
+ * SIMD pass per signature which is used below SignatureSet::min_batch_size.
+ */
+class SignatureSet {
+public:
+    struct Entry {
+        uint32_t key;
+        uint32_t index;
+        size_t anchor;
+    };
+
+private:
+    std::vector<SignatureView> signatures;
+    std::vector<Entry> pairs; // Sorted by key
+    std::vector<Entry> singles; // Sorted by key
+    std::vector<uint32_t> pair_buckets; // Start of each key in pairs, 64K + 1 entries
+    std::vector<uint8_t> pair_filter; // 64K entries
+    uint32_t single_buckets[257] = {};
+    uint8_t single_filter[256] = {};
+    size_t max_size = 0;
+
+    auto Sweep(const uint8_t* start, const uint8_t* end, const uint8_t* limit, MatchVisitor& visitor) const -> bool;
+
+public:
+    static constexpr size_t min_batch_size = 8;
+
+    SignatureSet() = default;
+    SignatureSet(const std::vector<SignatureView>& signatures);
+
+    inline auto size() const -> size_t { return this->signatures.size(); }
+    inline auto at(size_t index) const -> const SignatureView& { return this->signatures[index]; }
+    inline auto max_signature_size() const -> size_t { return this->max_size; }
+
+    /*
+     * Returns every match in [start, end), grouped by the index of the signature.
+     */
+    auto FindAll(const uint8_t* start, const uint8_t* end) const -> std::vector<std::vector<const uint8_t*>>;
+    auto FindAll(const uint8_t* start, const uint8_t* end, size_t threads) const
+        -> std::vector<std::vector<const uint8_t*>>;
+
+    /*
+     * Calls the visitor for every match in [start, end) on the calling thread
+     * without allocating. Matches of one signature arrive in address order,
+     * matches of different signatures are interleaved.
+     */
+    auto ForEachMatch(const uint8_t* start, const uint8_t* end, MatchVisitor& visitor) const -> bool;
+};
+
+auto IsSupported(Backend backend) -> bool;
+auto DetectBackend() -> Backend;
+auto GetBackend() -> Backend;
+auto SetBackend(Backend backend) -> bool;
+auto GetBackendName(Backend backend) -> const char*;
+}
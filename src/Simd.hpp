@@ -0,0 +1,49 @@
+/*
+ * Copyright (c) 2022-2023, NeKz
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+#include <cstdint>
+
+/*
+ * Shared by the vectorized loops of Scanner, Xrefs and Unicode.
+ *
+ * SIMD_X86 tells if the intrinsics are available at all. TARGET_SSE2 and
+ * TARGET_AVX2 let GCC and Clang compile a single function for a higher
+ * instruction set than the rest of the file, MSVC does not need them. The
+ * caller still has to check the CPU before calling such a function.
+ */
+#if defined(_M_IX86) || defined(_M_X64) || defined(__i386__) || defined(__x86_64__)
+#define SIMD_X86 1
+#include <immintrin.h>
+#else
+#define SIMD_X86 0
+#endif
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+#if SIMD_X86 && defined(__GNUC__)
+#define TARGET_SSE2 __attribute__((target("sse2")))
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define TARGET_SSE2
+#define TARGET_AVX2
+#endif
+
+/*
+ * Index of the lowest set bit, value must not be zero.
+ */
+inline auto count_trailing_zeros(uint32_t value) -> int
+{
+#ifdef _MSC_VER
+    unsigned long index = 0;
+    _BitScanForward(&index, value);
+    return int(index);
+#else
+    return __builtin_ctz(value);
+#endif
+}
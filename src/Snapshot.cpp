@@ -0,0 +1,402 @@
+/*
+ * Copyright (c) 2022-2023, NeKz
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "Snapshot.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+static_assert(sizeof(Snapshot::Header) == 16);
+static_assert(sizeof(Snapshot::SectionRecord) == 16);
+static_assert(sizeof(Snapshot::NameRecord) == 8);
+static_assert(sizeof(Snapshot::ObjectRecord) == 40);
+static_assert(sizeof(Snapshot::PropertyRecord) == 40);
+static_assert(sizeof(Snapshot::EnumRecord) == 16);
+static_assert(sizeof(Snapshot::ConstRecord) == 16);
+
+static const struct {
+    const char* name;
+    Snapshot::PropertyKind kind;
+} property_kinds[] = {
+    { "UnknownProperty", Snapshot::PropertyKind::Unknown },
+    { "ByteProperty", Snapshot::PropertyKind::Byte },
+    { "IntProperty", Snapshot::PropertyKind::Int },
+    { "FloatProperty", Snapshot::PropertyKind::Float },
+    { "BoolProperty", Snapshot::PropertyKind::Bool },
+    { "StrProperty", Snapshot::PropertyKind::Str },
+    { "NameProperty", Snapshot::PropertyKind::Name },
+    { "DelegateProperty", Snapshot::PropertyKind::Delegate },
+    { "ObjectProperty", Snapshot::PropertyKind::Object },
+    { "ClassProperty", Snapshot::PropertyKind::Class },
+    { "InterfaceProperty", Snapshot::PropertyKind::Interface },
+    { "StructProperty", Snapshot::PropertyKind::Struct },
+    { "ArrayProperty", Snapshot::PropertyKind::Array },
+    { "MapProperty", Snapshot::PropertyKind::Map },
+    { "ComponentProperty", Snapshot::PropertyKind::Component },
+};
+
+auto Snapshot::GetPropertyKind(std::string_view className) -> Snapshot::PropertyKind
+{
+    for (const auto& entry : property_kinds) {
+        if (className == entry.name) {
+            return entry.kind;
+        }
+    }
+    return PropertyKind::Unknown;
+}
+auto Snapshot::GetPropertyKindName(Snapshot::PropertyKind kind) -> const char*
+{
+    for (const auto& entry : property_kinds) {
+        if (entry.kind == kind) {
+            return entry.name;
+        }
+    }
+    return property_kinds[0].name;
+}
+
+auto Snapshot::Writer::AddString(std::string_view text, uint32_t* offset, uint32_t* length) -> void
+{
+    *offset = uint32_t(this->strings.size());
+    *length = uint32_t(text.size());
+
+    // Terminated so that readers can hand out C strings as well
+    this->strings.insert(this->strings.end(), text.begin(), text.end());
+    this->strings.push_back('\0');
+}
+auto Snapshot::Writer::SetName(uint32_t index, std::string_view name) -> void
+{
+    if (index >= this->names.size()) {
+        this->names.resize(index + 1, NameRecord { none, 0 });
+    }
+
+    this->AddString(name, &this->names[index].offset, &this->names[index].length);
+}
+auto Snapshot::Writer::SetObject(uint32_t index, const ObjectRecord& object) -> void
+{
+    if (index >= this->objects.size()) {
+        this->objects.resize(index + 1, ObjectRecord { 0, 0, 0, none, none, none, none, none, 0 });
+    }
+
+    this->objects[index] = object;
+}
+auto Snapshot::Writer::AddProperty(const PropertyRecord& property) -> void { this->properties.push_back(property); }
+auto Snapshot::Writer::AddEnum(uint32_t object, const std::vector<uint32_t>& names) -> void
+{
+    this->enums.push_back({ object, uint32_t(this->enum_names.size()), uint32_t(names.size()), 0 });
+    this->enum_names.insert(this->enum_names.end(), names.begin(), names.end());
+}
+auto Snapshot::Writer::AddConst(uint32_t object, std::string_view value) -> void
+{
+    auto record = ConstRecord { object, 0, 0, 0 };
+    this->AddString(value, &record.offset, &record.length);
+    this->consts.push_back(record);
+}
+
+template <typename T> static auto sorted_by_object(std::vector<T> records) -> std::vector<T>
+{
+    std::stable_sort(records.begin(), records.end(), [](const T& a, const T& b) { return a.object < b.object; });
+    return records;
+}
+
+auto Snapshot::Writer::Serialize() const -> std::vector<uint8_t>
+{
+    auto properties = sorted_by_object(this->properties);
+    auto enums = sorted_by_object(this->enums);
+    auto consts = sorted_by_object(this->consts);
+
+    struct Section {
+        SectionId id;
+        const void* data;
+        size_t count;
+        size_t size;
+    };
+
+    const Section sections[] = {
+        { SectionId::Names, this->names.data(), this->names.size(), sizeof(NameRecord) },
+        { SectionId::Strings, this->strings.data(), this->strings.size(), sizeof(char) },
+        { SectionId::Objects, this->objects.data(), this->objects.size(), sizeof(ObjectRecord) },
+        { SectionId::Properties, properties.data(), properties.size(), sizeof(PropertyRecord) },
+        { SectionId::Enums, enums.data(), enums.size(), sizeof(EnumRecord) },
+        { SectionId::EnumNames, this->enum_names.data(), this->enum_names.size(), sizeof(uint32_t) },
+        { SectionId::Consts, consts.data(), consts.size(), sizeof(ConstRecord) },
+    };
+
+    constexpr auto section_count = sizeof(sections) / sizeof(sections[0]);
+    auto align = [](size_t offset) -> size_t { return (offset + 7) & ~size_t(7); };
+
+    auto offset = sizeof(Header) + section_count * sizeof(SectionRecord);
+    SectionRecord records[section_count] = {};
+    for (auto i = size_t(0); i < section_count; ++i) {
+        offset = align(offset);
+        records[i] = { sections[i].id, uint32_t(sections[i].count), offset };
+        offset += sections[i].count * sections[i].size;
+    }
+
+    auto result = std::vector<uint8_t>(align(offset), 0);
+    auto header = Header { magic, version, uint32_t(section_count), 0 };
+    std::memcpy(result.data(), &header, sizeof(header));
+    std::memcpy(result.data() + sizeof(header), records, sizeof(records));
+
+    for (auto i = size_t(0); i < section_count; ++i) {
+        if (sections[i].count) {
+            std::memcpy(result.data() + records[i].offset, sections[i].data, sections[i].count * sections[i].size);
+        }
+    }
+
+    return result;
+}
+auto Snapshot::Writer::Save(const char* path) const -> bool
+{
+    auto data = this->Serialize();
+
+    auto file = std::fopen(path, "wb");
+    if (!file) {
+        return false;
+    }
+
+    auto written = std::fwrite(data.data(), 1, data.size(), file);
+    return std::fclose(file) == 0 && written == data.size();
+}
+
+Snapshot::Reader::~Reader() { this->Close(); }
+
+auto Snapshot::Reader::Open(const char* path) -> bool
+{
+    this->Close();
+
+#ifdef _WIN32
+    this->file
+        = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (this->file == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+
+    auto file_size = LARGE_INTEGER();
+    if (!GetFileSizeEx(this->file, &file_size) || !file_size.QuadPart || file_size.QuadPart > SIZE_MAX) {
+        this->Close();
+        return false;
+    }
+
+    this->mapping = CreateFileMappingA(this->file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!this->mapping) {
+        this->Close();
+        return false;
+    }
+
+    this->data = static_cast<const uint8_t*>(MapViewOfFile(this->mapping, FILE_MAP_READ, 0, 0, 0));
+    this->size = size_t(file_size.QuadPart);
+    this->mapped = true;
+#else
+    this->file = open(path, O_RDONLY | O_CLOEXEC);
+    if (this->file == -1) {
+        return false;
+    }
+
+    struct stat file_stat = {};
+    if (fstat(this->file, &file_stat) || file_stat.st_size <= 0) {
+        this->Close();
+        return false;
+    }
+
+    auto view = mmap(nullptr, size_t(file_stat.st_size), PROT_READ, MAP_PRIVATE, this->file, 0);
+    this->data = view != MAP_FAILED ? static_cast<const uint8_t*>(view) : nullptr;
+    this->size = size_t(file_stat.st_size);
+    this->mapped = true;
+#endif
+
+    if (!this->data || !this->Parse()) {
+        this->Close();
+        return false;
+    }
+
+    return true;
+}
+auto Snapshot::Reader::Open(const uint8_t* data, size_t size) -> bool
+{
+    this->Close();
+
+    this->data = data;
+    this->size = size;
+
+    if (!this->data || !this->Parse()) {
+        this->Close();
+        return false;
+    }
+
+    return true;
+}
+auto Snapshot::Reader::Close() -> void
+{
+    // Buffers of the caller are not ours to unmap
+#ifdef _WIN32
+    if (this->mapped && this->data) {
+        UnmapViewOfFile(this->data);
+    }
+    if (this->mapping) {
+        CloseHandle(this->mapping);
+    }
+    if (this->file != INVALID_HANDLE_VALUE) {
+        CloseHandle(this->file);
+    }
+    this->mapping = nullptr;
+    this->file = INVALID_HANDLE_VALUE;
+#else
+    if (this->mapped && this->data) {
+        munmap(const_cast<uint8_t*>(this->data), this->size);
+    }
+    if (this->file != -1) {
+        close(this->file);
+    }
+    this->file = -1;
+#endif
+
+    this->data = nullptr;
+    this->size = 0;
+    this->mapped = false;
+    this->names = {};
+    this->strings = {};
+    this->objects = {};
+    this->properties = {};
+    this->enums = {};
+    this->enum_names = {};
+    this->consts = {};
+}
+
+auto Snapshot::Reader::Parse() -> bool
+{
+    if (uintptr_t(this->data) % 8 || this->size < sizeof(Header)) {
+        return false;
+    }
+
+    auto header = reinterpret_cast<const Header*>(this->data);
+    if (header->magic != magic || header->version != version
+        || header->section_count > (this->size - sizeof(Header)) / sizeof(SectionRecord)) {
+        return false;
+    }
+
+    auto sections = reinterpret_cast<const SectionRecord*>(this->data + sizeof(Header));
+    for (auto i = uint32_t(0); i < header->section_count; ++i) {
+        const auto& section = sections[i];
+
+        auto assign = [&]<typename T>(std::span<const T>& target) -> bool {
+            if (section.offset % alignof(T) || section.offset > this->size
+                || section.count > (this->size - section.offset) / sizeof(T)) {
+                return false;
+            }
+            target = std::span<const T>(reinterpret_cast<const T*>(this->data + section.offset), section.count);
+            return true;
+        };
+
+        auto valid = true;
+        switch (section.id) {
+        case SectionId::Names:
+            valid = assign(this->names);
+            break;
+        case SectionId::Strings:
+            valid = assign(this->strings);
+            break;
+        case SectionId::Objects:
+            valid = assign(this->objects);
+            break;
+        case SectionId::Properties:
+            valid = assign(this->properties);
+            break;
+        case SectionId::Enums:
+            valid = assign(this->enums);
+            break;
+        case SectionId::EnumNames:
+            valid = assign(this->enum_names);
+            break;
+        case SectionId::Consts:
+            valid = assign(this->consts);
+            break;
+        default:
+            break;
+        }
+
+        if (!valid) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+auto Snapshot::Reader::GetString(uint32_t offset, uint32_t length) const -> std::string_view
+{
+    if (offset > this->strings.size() || length > this->strings.size() - offset) {
+        return "";
+    }
+    return std::string_view(this->strings.data() + offset, length);
+}
+auto Snapshot::Reader::GetName(uint32_t index) const -> std::string_view
+{
+    return index < this->names.size() ? this->GetString(this->names[index].offset, this->names[index].length) : "";
+}
+auto Snapshot::Reader::GetObjectName(uint32_t object) const -> std::string_view
+{
+    auto record = this->FindObject(object);
+    return record ? this->GetName(record->name) : "";
+}
+auto Snapshot::Reader::GetPath(uint32_t object) const -> std::string
+{
+    // Outer chains are short, the depth limit only guards against cycles
+    uint32_t chain[64];
+    auto depth = size_t(0);
+    for (auto record = this->FindObject(object); record && depth < std::size(chain);
+         record = this->FindObject(record->outer)) {
+        chain[depth++] = object;
+        object = record->outer;
+    }
+
+    auto result = std::string();
+    while (depth--) {
+        auto record = this->FindObject(chain[depth]);
+        result.append(this->GetName(record->name));
+        if (record->number) {
+            result.append("_").append(std::to_string(record->number - 1));
+        }
+        if (depth) {
+            result.append(".");
+        }
+    }
+    return result;
+}
+
+auto Snapshot::Reader::FindObject(uint32_t object) const -> const Snapshot::ObjectRecord*
+{
+    return object < this->objects.size() && this->objects[object].address ? &this->objects[object] : nullptr;
+}
+auto Snapshot::Reader::FindProperty(uint32_t object) const -> const Snapshot::PropertyRecord*
+{
+    auto entry = std::lower_bound(this->properties.begin(), this->properties.end(), object,
+        [](const PropertyRecord& record, uint32_t object) { return record.object < object; });
+    return entry != this->properties.end() && entry->object == object ? &*entry : nullptr;
+}
+auto Snapshot::Reader::FindEnum(uint32_t object) const -> std::span<const uint32_t>
+{
+    auto entry = std::lower_bound(this->enums.begin(), this->enums.end(), object,
+        [](const EnumRecord& record, uint32_t object) { return record.object < object; });
+    if (entry == this->enums.end() || entry->object != object || entry->first > this->enum_names.size()
+        || entry->count > this->enum_names.size() - entry->first) {
+        return {};
+    }
+    return this->enum_names.subspan(entry->first, entry->count);
+}
+auto Snapshot::Reader::FindConst(uint32_t object) const -> std::string_view
+{
+    auto entry = std::lower_bound(this->consts.begin(), this->consts.end(), object,
+        [](const ConstRecord& record, uint32_t object) { return record.object < object; });
+    return entry != this->consts.end() && entry->object == object ? this->GetString(entry->offset, entry->length)
+                                                                  : "";
+}
@@ -0,0 +1,231 @@
+/*
+ * Copyright (c) 2022-2023, NeKz
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#ifdef _WIN32
+#include <Windows.h>
+#endif
+
+/*
+ * Binary snapshot of the reflection data of the engine, i.e. the name
+ * table, the object table and everything the dumpers read from fields.
+ *
+ * The file starts with a header and a table of sections. Every section is an
+ * array of fixed size little-endian records aligned to eight bytes, readers
+ * use the file in place without parsing it. Objects are stored at their
+ * index in g_Objects and reference each other by index. Sections which a
+ * reader does not know get skipped, a layout change of a known section bumps
+ * the version.
+ *
+ *     auto snapshot = Snapshot::Reader();
+ *     if (snapshot.Open("tron_evolution.snapshot")) {
+ *         for (auto index = uint32_t(0); index < snapshot.GetObjects().size(); ++index) {
+ *             println("{}", snapshot.GetPath(index));
+ *         }
+ *     }
+ */
+namespace Snapshot {
+
+constexpr uint32_t magic = 0x534D4554; // "TEMS"
+constexpr uint32_t version = 1;
+constexpr uint32_t none = 0xFFFFFFFF; // Object index of a null pointer
+
+enum class SectionId : uint32_t {
+    Names = 1, // NameRecord for every name index
+    Strings = 2, // Characters of names and constants
+    Objects = 3, // ObjectRecord for every object index
+    Properties = 4, // PropertyRecord sorted by object
+    Enums = 5, // EnumRecord sorted by object
+    EnumNames = 6, // Name indices of the enums
+    Consts = 7, // ConstRecord sorted by object
+};
+
+struct Header {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t section_count;
+    uint32_t reserved;
+};
+
+struct SectionRecord {
+    SectionId id;
+    uint32_t count; // Number of records
+    uint64_t offset; // From the start of the file
+};
+
+struct NameRecord {
+    uint32_t offset; // Into the strings, none if the entry is not valid
+    uint32_t length;
+};
+
+struct ObjectRecord {
+    uint64_t address; // Zero for an empty slot
+    uint32_t name;
+    uint32_t number;
+    uint32_t outer;
+    uint32_t class_object;
+    uint32_t super_field; // Fields only
+    uint32_t next; // Fields only, next field of the children chain
+    uint32_t children; // Structs only, first field of the children chain
+    uint32_t property_size; // Structs only
+};
+
+/*
+ * Type of a property, the snapshot stores it so readers do not have to
+ * compare class names.
+ */
+enum class PropertyKind : uint32_t {
+    Unknown,
+    Byte,
+    Int,
+    Float,
+    Bool,
+    Str,
+    Name,
+    Delegate,
+    Object,
+    Class,
+    Interface,
+    Struct,
+    Array,
+    Map,
+    Component,
+};
+
+struct PropertyRecord {
+    uint32_t object;
+    PropertyKind kind;
+    int32_t offset;
+    uint32_t element_size;
+    uint32_t array_dim;
+    uint32_t flags;
+    uint32_t bit_mask; // Bool only
+    uint32_t inner; // Enum, class, struct, array inner or map key
+    uint32_t value; // Map value
+    uint32_t reserved;
+};
+
+struct EnumRecord {
+    uint32_t object;
+    uint32_t first; // Into the enum names
+    uint32_t count;
+    uint32_t reserved;
+};
+
+struct ConstRecord {
+    uint32_t object;
+    uint32_t offset; // Into the strings
+    uint32_t length;
+    uint32_t reserved;
+};
+
+/*
+ * Maps the class name of a property object, e.g. "StructProperty".
+ */
+auto GetPropertyKind(std::string_view className) -> PropertyKind;
+auto GetPropertyKindName(PropertyKind kind) -> const char*;
+
+/*
+ * Collects the records and lays them out as a snapshot file.
+ */
+class Writer {
+private:
+    std::vector<NameRecord> names;
+    std::vector<char> strings;
+    std::vector<ObjectRecord> objects;
+    std::vector<PropertyRecord> properties;
+    std::vector<EnumRecord> enums;
+    std::vector<uint32_t> enum_names;
+    std::vector<ConstRecord> consts;
+
+    auto AddString(std::string_view text, uint32_t* offset, uint32_t* length) -> void;
+
+public:
+    auto SetName(uint32_t index, std::string_view name) -> void;
+    auto SetObject(uint32_t index, const ObjectRecord& object) -> void;
+    auto AddProperty(const PropertyRecord& property) -> void;
+    auto AddEnum(uint32_t object, const std::vector<uint32_t>& names) -> void;
+    auto AddConst(uint32_t object, std::string_view value) -> void;
+
+    auto Serialize() const -> std::vector<uint8_t>;
+    auto Save(const char* path) const -> bool;
+};
+
+/*
+ * Read-only view of a snapshot, either a mapped file or a buffer of the
+ * caller which has to outlive the reader and be aligned to eight bytes.
+ * Lookups by object use binary searches over the sorted sections.
+ */
+class Reader {
+private:
+    const uint8_t* data = nullptr;
+    size_t size = 0;
+    bool mapped = false;
+#ifdef _WIN32
+    HANDLE file = INVALID_HANDLE_VALUE;
+    HANDLE mapping = nullptr;
+#else
+    int file = -1;
+#endif
+
+    std::span<const NameRecord> names = {};
+    std::span<const char> strings = {};
+    std::span<const ObjectRecord> objects = {};
+    std::span<const PropertyRecord> properties = {};
+    std::span<const EnumRecord> enums = {};
+    std::span<const uint32_t> enum_names = {};
+    std::span<const ConstRecord> consts = {};
+
+    auto Parse() -> bool;
+    auto GetString(uint32_t offset, uint32_t length) const -> std::string_view;
+
+public:
+    Reader() = default;
+    Reader(const Reader&) = delete;
+    auto operator=(const Reader&) -> Reader& = delete;
+    ~Reader();
+
+    /*
+     * Fails if the data is not a snapshot of this version or a section does
+     * not fit into it.
+     */
+    auto Open(const char* path) -> bool;
+    auto Open(const uint8_t* data, size_t size) -> bool;
+    auto Close() -> void;
+
+    inline auto IsOpen() const -> bool { return this->data != nullptr; }
+    inline auto GetObjects() const -> std::span<const ObjectRecord> { return this->objects; }
+    inline auto GetProperties() const -> std::span<const PropertyRecord> { return this->properties; }
+    inline auto GetNameCount() const -> size_t { return this->names.size(); }
+
+    /*
+     * Empty for unknown or invalid names.
+     */
+    auto GetName(uint32_t index) const -> std::string_view;
+    auto GetObjectName(uint32_t object) const -> std::string_view;
+
+    /*
+     * Names of the outer chain and the object joined by dots like
+     * "Engine.Pawn.Tick", a number gets appended as suffix.
+     */
+    auto GetPath(uint32_t object) const -> std::string;
+
+    /*
+     * Null if the object is out of range, an empty slot or not of that kind.
+     */
+    auto FindObject(uint32_t object) const -> const ObjectRecord*;
+    auto FindProperty(uint32_t object) const -> const PropertyRecord*;
+    auto FindEnum(uint32_t object) const -> std::span<const uint32_t>;
+    auto FindConst(uint32_t object) const -> std::string_view;
+};
+}
@@ -0,0 +1,244 @@
+/*
+ * Copyright (c) 2022-2023, NeKz
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "SnapshotDiff.hpp"
+#include <algorithm>
+#include <unordered_map>
+
+// Outer chains are short, the limit only guards against cycles
+constexpr size_t max_outer_depth = 64;
+
+static auto hash_name(std::string_view name) -> uint64_t
+{
+    auto hash = uint64_t(0xCBF29CE484222325);
+    for (auto c : name) {
+        hash = (hash ^ uint8_t(c)) * 0x100000001B3;
+    }
+    return hash;
+}
+
+static auto combine(uint64_t hash, uint64_t value) -> uint64_t
+{
+    hash = (hash ^ value) * 0x9E3779B97F4A7C15;
+    hash ^= hash >> 29;
+    hash *= 0xBF58476D1CE4E5B9;
+    hash ^= hash >> 32;
+    return hash ? hash : 1;
+}
+
+auto Snapshot::GetPathHashes(const Reader& snapshot) -> std::vector<uint64_t>
+{
+    auto objects = snapshot.GetObjects();
+
+    auto name_hashes = std::vector<uint64_t>(snapshot.GetNameCount());
+    for (auto i = uint32_t(0); i < name_hashes.size(); ++i) {
+        name_hashes[i] = hash_name(snapshot.GetName(i));
+    }
+
+    auto hashes = std::vector<uint64_t>(objects.size());
+    auto chain = std::vector<uint32_t>();
+
+    for (auto i = uint32_t(0); i < objects.size(); ++i) {
+        if (hashes[i] || !objects[i].address) {
+            continue;
+        }
+
+        // Walk up to the first outer with a known hash, then hash back down
+        chain.clear();
+        auto outer = i;
+        while (snapshot.FindObject(outer) && !hashes[outer] && chain.size() < max_outer_depth) {
+            chain.push_back(outer);
+            outer = objects[outer].outer;
+        }
+
+        auto hash = snapshot.FindObject(outer) ? hashes[outer] : 0;
+        for (auto object = chain.rbegin(); object != chain.rend(); ++object) {
+            const auto& record = objects[*object];
+            auto name = record.name < name_hashes.size() ? name_hashes[record.name] : 0;
+            hash = combine(combine(hash, name), record.number);
+            hashes[*object] = hash;
+        }
+    }
+
+    return hashes;
+}
+
+namespace {
+struct Side {
+    const Snapshot::Reader& snapshot;
+    std::vector<uint64_t> hashes;
+
+    auto GetClass(uint32_t object) const -> uint32_t { return this->snapshot.GetObjects()[object].class_object; }
+    auto GetHash(uint32_t object) const -> uint64_t
+    {
+        return this->snapshot.FindObject(object) ? this->hashes[object] : 0;
+    }
+    auto GetSize(uint32_t object) const -> uint64_t
+    {
+        auto class_object = this->snapshot.FindObject(this->GetClass(object));
+        return class_object ? class_object->property_size : 0;
+    }
+    auto GetPackage(uint32_t object) const -> uint32_t
+    {
+        for (auto depth = size_t(0); depth < max_outer_depth; ++depth) {
+            auto outer = this->snapshot.GetObjects()[object].outer;
+            if (!this->snapshot.FindObject(outer)) {
+                break;
+            }
+            object = outer;
+        }
+        return object;
+    }
+
+    // Sorted (path hash, index) pairs of all objects
+    auto GetSortedObjects() const -> std::vector<std::pair<uint64_t, uint32_t>>
+    {
+        auto result = std::vector<std::pair<uint64_t, uint32_t>>();
+        result.reserve(this->hashes.size());
+        for (auto i = uint32_t(0); i < this->hashes.size(); ++i) {
+            if (this->hashes[i]) {
+                result.emplace_back(this->hashes[i], i);
+            }
+        }
+        std::sort(result.begin(), result.end());
+        return result;
+    }
+};
+
+class Summaries {
+private:
+    std::unordered_map<uint64_t, size_t> groups = {};
+
+public:
+    std::vector<Snapshot::ChangeSummary> summaries = {};
+
+    auto Get(uint64_t key) -> Snapshot::ChangeSummary&
+    {
+        auto [group, inserted] = this->groups.try_emplace(key, this->summaries.size());
+        if (inserted) {
+            this->summaries.push_back({ Snapshot::none, Snapshot::none, 0, 0, 0, 0, 0 });
+        }
+        return this->summaries[group->second];
+    }
+
+    auto Sorted() -> std::vector<Snapshot::ChangeSummary>
+    {
+        std::stable_sort(this->summaries.begin(), this->summaries.end(), [](const auto& a, const auto& b) {
+            auto a_changes = uint64_t(a.created) + a.destroyed + a.reclassified;
+            auto b_changes = uint64_t(b.created) + b.destroyed + b.reclassified;
+            if (a_changes != b_changes) {
+                return a_changes > b_changes;
+            }
+            return a.created_bytes + a.destroyed_bytes > b.created_bytes + b.destroyed_bytes;
+        });
+        return std::move(this->summaries);
+    }
+};
+}
+
+auto Snapshot::Diff(const Reader& before, const Reader& after) -> DiffResult
+{
+    auto old_side = Side { before, GetPathHashes(before) };
+    auto new_side = Side { after, GetPathHashes(after) };
+
+    auto old_objects = old_side.GetSortedObjects();
+    auto new_objects = new_side.GetSortedObjects();
+
+    auto result = DiffResult { {}, {}, {}, 0 };
+    auto classes = Summaries();
+    auto packages = Summaries();
+
+    auto add_created = [&](uint32_t object) {
+        auto class_object = new_side.GetClass(object);
+        auto package = new_side.GetPackage(object);
+        auto size = new_side.GetSize(object);
+
+        auto& by_class = classes.Get(new_side.GetHash(class_object));
+        by_class.after = class_object;
+        by_class.created += 1;
+        by_class.created_bytes += size;
+
+        auto& by_package = packages.Get(new_side.GetHash(package));
+        by_package.after = package;
+        by_package.created += 1;
+        by_package.created_bytes += size;
+
+        result.changes.push_back({ ChangeKind::Created, none, object });
+    };
+
+    auto add_destroyed = [&](uint32_t object) {
+        auto class_object = old_side.GetClass(object);
+        auto package = old_side.GetPackage(object);
+        auto size = old_side.GetSize(object);
+
+        auto& by_class = classes.Get(old_side.GetHash(class_object));
+        by_class.before = class_object;
+        by_class.destroyed += 1;
+        by_class.destroyed_bytes += size;
+
+        auto& by_package = packages.Get(old_side.GetHash(package));
+        by_package.before = package;
+        by_package.destroyed += 1;
+        by_package.destroyed_bytes += size;
+
+        result.changes.push_back({ ChangeKind::Destroyed, object, none });
+    };
+
+    auto add_reclassified = [&](uint32_t old_object, uint32_t new_object) {
+        auto class_object = new_side.GetClass(new_object);
+        auto old_package = old_side.GetPackage(old_object);
+        auto new_package = new_side.GetPackage(new_object);
+        auto old_size = old_side.GetSize(old_object);
+        auto new_size = new_side.GetSize(new_object);
+
+        auto& by_class = classes.Get(new_side.GetHash(class_object));
+        by_class.after = class_object;
+        by_class.reclassified += 1;
+        by_class.created_bytes += new_size;
+        by_class.destroyed_bytes += old_size;
+
+        // Equal paths have equal packages
+        auto& by_package = packages.Get(new_side.GetHash(new_package));
+        by_package.before = old_package;
+        by_package.after = new_package;
+        by_package.reclassified += 1;
+        by_package.created_bytes += new_size;
+        by_package.destroyed_bytes += old_size;
+
+        result.changes.push_back({ ChangeKind::Reclassified, old_object, new_object });
+    };
+
+    // Merge join on the path hash, duplicated paths get paired in index order
+    auto old_entry = old_objects.begin();
+    auto new_entry = new_objects.begin();
+    while (old_entry != old_objects.end() && new_entry != new_objects.end()) {
+        if (old_entry->first < new_entry->first) {
+            add_destroyed((old_entry++)->second);
+        } else if (new_entry->first < old_entry->first) {
+            add_created((new_entry++)->second);
+        } else {
+            auto old_class = old_side.GetHash(old_side.GetClass(old_entry->second));
+            auto new_class = new_side.GetHash(new_side.GetClass(new_entry->second));
+            if (old_class != new_class) {
+                add_reclassified(old_entry->second, new_entry->second);
+            } else {
+                result.unchanged += 1;
+            }
+            ++old_entry;
+            ++new_entry;
+        }
+    }
+    for (; old_entry != old_objects.end(); ++old_entry) {
+        add_destroyed(old_entry->second);
+    }
+    for (; new_entry != new_objects.end(); ++new_entry) {
+        add_created(new_entry->second);
+    }
+
+    result.classes = classes.Sorted();
+    result.packages = packages.Sorted();
+    return result;
+}
@@ -0,0 +1,70 @@
+/*
+ * Copyright (c) 2022-2023, NeKz
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+#include "Snapshot.hpp"
+#include <cstdint>
+#include <vector>
+
+/*
+ * Compares the objects of two snapshots, e.g. before and after a level
+ * transition. Both snapshots can come from files or from in-memory captures
+ * of the same or different sessions.
+ *
+ * Objects are matched by a hash of their path which is built from the name
+ * strings and numbers of the outer chain. Both sides get sorted by that hash
+ * and joined in one pass, names are never compared as strings.
+ *
+ *     auto diff = Snapshot::Diff(before, after);
+ *     for (const auto& summary : diff.classes) {
+ *         println("{} +{} -{}", after.GetPath(summary.after), summary.created, summary.destroyed);
+ *     }
+ */
+namespace Snapshot {
+
+enum class ChangeKind : uint32_t {
+    Created, // Only in the second snapshot
+    Destroyed, // Only in the first snapshot
+    Reclassified, // In both snapshots with a different class
+};
+
+struct Change {
+    ChangeKind kind;
+    uint32_t before; // Object index in the first snapshot, none if created
+    uint32_t after; // Object index in the second snapshot, none if destroyed
+};
+
+/*
+ * Changes of one class or package. Reclassified objects count towards their
+ * new class, their new size is added to the created bytes and their old size
+ * to the destroyed bytes. Sizes are estimated from the property size of the
+ * class.
+ */
+struct ChangeSummary {
+    uint32_t before; // Class or package in the first snapshot, none if it only exists in the second one
+    uint32_t after; // Class or package in the second snapshot, none if it only exists in the first one
+    uint32_t created;
+    uint32_t destroyed;
+    uint32_t reclassified;
+    uint64_t created_bytes;
+    uint64_t destroyed_bytes;
+};
+
+struct DiffResult {
+    std::vector<Change> changes; // Ordered by path hash
+    std::vector<ChangeSummary> classes; // Most changes first
+    std::vector<ChangeSummary> packages; // Most changes first
+    size_t unchanged;
+};
+
+/*
+ * Path hash of every object slot, zero for empty slots. Equal paths have
+ * equal hashes across snapshots.
+ */
+auto GetPathHashes(const Reader& snapshot) -> std::vector<uint64_t>;
+
+auto Diff(const Reader& before, const Reader& after) -> DiffResult;
+}
@@ -7,6 +7,7 @@
 #include "TEM.hpp"
 #include "Console.hpp"
 #include "Dumper.hpp"
+#include "Events.hpp"
 #include "GFWL.hpp"
 #include "Memory.hpp"
 #include "Offsets.hpp"
@@ -14,6 +15,7 @@
 #include "SDK.hpp"
 #include "SpotChecks.hpp"
 #include "UI.hpp"
+#include "Unicode.hpp"
 #include <intrin.h>
 
 TEM tem = {};
@@ -24,6 +26,8 @@ DECL_DETOUR_T(void, ProcessEvent, UObject* object, UFunction* func, void* params
 DECL_DETOUR_T(Color*, GetTeamColor, PgTeamInfo* team, Color* color, int team_color_index);
 DECL_DETOUR_T(FString*, ConsoleCommand, UGameViewportClient* client, const FString& output, const FString& command);
 
+static auto register_event_handlers() -> void;
+
 /*
  * This gets called once the module loads.
  * Here we immediately patch GFWL and all spot checks.
@@ -36,9 +40,12 @@ auto tem_attach(HMODULE module) -> int
 
     tem.is_attached = true;
     tem.module_handle = module;
+    tem.attach_time = std::chrono::steady_clock::now();
 
     println("[tem] Initializing...");
 
+    Memory::WatchModules(true);
+
     Hooks::initialize();
 
     patch_gfwl();
@@ -50,7 +57,7 @@ auto tem_attach(HMODULE module) -> int
 
     // Actual intialization happens in a hooked GFWL function.
     // This check here is only for DLL injection.
-    if (tem.engine()) {
+    if (tem.refresh_context().engine) {
         tem_init();
     } else {
         Hooks::apply_queued();
@@ -78,17 +85,20 @@ auto tem_detach() -> void
     println("[tem] Shutdown module {}", uintptr_t(tem.module_handle));
 
     Hooks::uninitialize();
+    Events::Clear();
 
     ui_shutdown();
     patch_forced_window_minimize(false);
 
-    auto controller = tem.player_controller();
+    auto controller = tem.refresh_context().controller;
     if (tem.is_super_user && controller) {
         controller->set_god_mode(false);
     }
 
     unpatch_gfwl();
 
+    Memory::WatchModules(false);
+
     println("Cya :^)");
 }
 
@@ -103,13 +113,15 @@ auto tem_init() -> void
         return;
     }
 
-    auto engine = tem.engine();
+    auto engine = tem.refresh_context().engine;
     println("[tem] g_Engine: 0x{:x}", uintptr_t(engine));
 
     if (!engine) {
         return println("[tem] Unable to get engine :(");
     }
 
+    register_event_handlers();
+
     auto processEvent = Memory::VMT(engine, Offsets::ProcessEvent);
 
     Hooks::queue("UEngine::ProcessEvent", &ProcessEvent, ProcessEvent_Hook, processEvent);
@@ -126,6 +138,9 @@ auto tem_init() -> void
     Hooks::apply_queued();
 
     tem.is_hooked = true;
+
+    auto elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - tem.attach_time);
+    println("[tem] Initialized in {:.2f} ms", elapsed.count());
 }
 
 /*
@@ -163,13 +178,11 @@ auto patch_forced_window_minimize(bool enable) -> void
 auto TEM::find_name(FName name) -> std::string_view
 {
     auto g_Names = reinterpret_cast<TArray<FNameEntry*>*>(Offsets::g_Names);
-    auto names = g_Names->data;
 
-    for (auto i = 0u; i < g_Names->size; ++i) {
-        auto item = names[i];
-        if (item && item->index == i << 1 && item->index == name.index << 1 && item->name) {
-            return item->name;
-        }
+    // Entries store their own index shifted by one, anything else is not a valid entry
+    auto item = g_Names->at(name.index);
+    if (item && item->index == name.index << 1) {
+        return item->name;
     }
 
     return "";
@@ -177,33 +190,77 @@ auto TEM::find_name(FName name) -> std::string_view
 auto TEM::find_name_index(const char* name) -> int
 {
     auto g_Names = reinterpret_cast<TArray<FNameEntry*>*>(Offsets::g_Names);
-    auto names = g_Names->data;
 
-    for (auto i = 0u; i < g_Names->size; ++i) {
-        auto item = names[i];
-        if (item && item->index == i << 1 && item->name && strcmp(item->name, name) == 0) {
-            return item->index >> 1;
-        }
+    auto lock = std::unique_lock(this->index_mutex);
+    if (g_Names->data && g_Names->size != this->name_index.size()) {
+        this->name_index.Update(g_Names->data, g_Names->size);
     }
 
-    return -1;
+    return this->name_index.FindIndex(name);
 }
-inline auto TEM::engine() -> UEngine* { return Memory::Deref<UEngine*>(Offsets::g_Engine); }
-inline auto TEM::player_controller() -> PgPlayerController*
+auto TEM::find_object(const char* path, const char* class_name) -> UObject*
 {
-    if (!this->engine() || !this->engine()->get_local_player()) {
+    auto g_Names = reinterpret_cast<TArray<FNameEntry*>*>(Offsets::g_Names);
+    auto g_Objects = reinterpret_cast<TArray<UObject*>*>(Offsets::g_Objects);
+
+    auto lock = std::unique_lock(this->index_mutex);
+    if (!g_Objects->data) {
         return nullptr;
     }
 
-    return this->engine()->get_local_player()->actor;
+    if (g_Names->data && g_Names->size != this->name_index.size()) {
+        this->name_index.Update(g_Names->data, g_Names->size);
+    }
+
+    ObjectName components[max_object_depth];
+    auto depth = ParseObjectPath(path, this->name_index, components);
+    if (!depth) {
+        return nullptr;
+    }
+
+    auto class_index = class_name ? this->name_index.FindIndex(class_name) : -1;
+    if (class_name && class_index < 0) {
+        return nullptr;
+    }
+
+    if (g_Objects->size != this->object_index.size()) {
+        this->object_index.Update(g_Objects->data, g_Objects->size);
+    }
+
+    auto object = this->object_index.Find(g_Objects->data, g_Objects->size, components, depth, class_index);
+
+    // Slots get reused without the table changing its size, a miss rescans them once
+    if (!object && this->object_index.Update(g_Objects->data, g_Objects->size)) {
+        object = this->object_index.Find(g_Objects->data, g_Objects->size, components, depth, class_index);
+    }
+
+    return object;
 }
-inline auto TEM::pawn() -> PgPawn*
+auto TEM::refresh_context(const void* destroyed) -> TEMContext
 {
-    if (!player_controller()) {
-        return nullptr;
+    auto next = TEMContext();
+
+    next.engine = Memory::Deref<UEngine*>(Offsets::g_Engine);
+    next.local_player = next.engine ? next.engine->get_local_player() : nullptr;
+    next.controller = next.local_player ? next.local_player->actor : nullptr;
+
+    if (next.controller && next.controller != destroyed) {
+        next.pawn = next.controller->pawn != destroyed ? next.controller->pawn : nullptr;
+        next.world_info = next.controller->world_info;
+        next.hud = next.controller->hud;
+    } else {
+        next.controller = nullptr;
     }
 
-    return player_controller()->pawn;
+    // Readers retry while the sequence is odd or changed during their copy
+    auto lock = std::unique_lock(this->context_mutex);
+    auto sequence = this->context_sequence.load(std::memory_order_relaxed);
+    this->context_sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    this->current_context = next;
+    this->context_sequence.store(sequence + 2, std::memory_order_release);
+
+    return next;
 }
 auto TEM::console_command(std::wstring command) -> void
 {
@@ -222,105 +279,276 @@ auto TEM::console_command(std::wstring command) -> void
     ConsoleCommand(viewport_client, output, input);
 }
 
-DETOUR_T(void, ProcessEvent, UObject* object, UFunction* func, void* params, int result)
+/*
+ * ProcessEvent handlers, see register_event_handlers.
+ */
+static auto on_pawn_post_init_anim_tree(UObject* object, UFunction* func, void* params) -> bool
 {
-#if 0
-    auto log_event = [&]() {
-        println("{}::{} this = 0x{:04x} func = 0x{:04x} params = 0x{:04x}", tem.find_name(object->name),
-            tem.find_name(func->name), uintptr_t(object), uintptr_t(func), uintptr_t(params));
-    };
+    if (!tem.pawn()) {
+        println("PAWN SPAWNED 0x{:04x}", uintptr_t(object));
 
-    if ((GetAsyncKeyState(VK_NUMPAD1) < 0) && ui.game_window_is_focused() && tem.engine() && !tem.engine()->is_paused()) {
-        log_event();
+        auto controller = tem.player_controller();
+        if (tem.is_super_user && controller) {
+            controller->set_god_mode(true);
+        }
     }
-#endif
 
-    //// TODO: Find a way to explore multiplayer maps in single player
-    //if (object->is(PG_PLAYER_CONTROLLER) && func->is(SET_CAMERA_TARGET_TIMER)) {
-    //    println("Ignoring: PgPlayerController::SetCameraTargetTimer");
-    //    return;
-    //}
+    tem.refresh_context();
+    return true;
+}
+static auto on_pawn_destroyed(UObject* object, UFunction* func, void* params) -> bool
+{
+    if (object->as<PgPawn>()->equals(tem.pawn())) {
+        println("PAWN DESTROYED 0x{:04x}", uintptr_t(object));
+        tem.refresh_context(object);
+    }
+    return true;
+}
+static auto on_player_controller_destroyed(UObject* object, UFunction* func, void* params) -> bool
+{
+    if (object == static_cast<const void*>(tem.player_controller())) {
+        tem.refresh_context(object);
+    }
+    return true;
+}
+static auto update_class_registry() -> void
+{
+    // Bounds the sweep over existing slots per tick, new slots are always checked
+    const auto sweep_budget = size_t(4096);
+
+    auto g_Objects = reinterpret_cast<TArray<UObject*>*>(Offsets::g_Objects);
+
+    auto lock = std::unique_lock(tem.index_mutex);
+    if (g_Objects->data) {
+        tem.class_registry.Update(g_Objects->data, g_Objects->size, sweep_budget);
+    }
+}
+static auto get_object_path(const UObject* object) -> std::string
+{
+    // Innermost first and joined once, outers past the limit get left out
+    std::string_view names[ObjectMemory<UObject>::max_outer_depth];
+    auto depth = size_t(0);
+    auto size = size_t(0);
+    for (auto item = object; item && depth < std::size(names); item = item->outer_object) {
+        names[depth] = tem.find_name(item->name);
+        size += names[depth].size() + 1;
+        ++depth;
+    }
+
+    auto path = std::string();
+    path.reserve(size);
+    while (depth) {
+        path.append(names[--depth]);
+        if (depth) {
+            path.push_back('.');
+        }
+    }
+    return path;
+}
+static auto get_owned_arrays(const UClass* class_object, std::vector<ObjectMemory<UObject>::OwnedArray>& arrays)
+    -> void
+{
+    // This runs on the game thread every tick, a broken chain must neither fault nor loop
+    const auto max_depth = 256;
+
+    // Inherited properties live in the children of the super classes
+    auto field = static_cast<const UField*>(class_object);
+    for (auto depth = 0; depth < max_depth && Memory::IsReadable(reinterpret_cast<const UStruct*>(field)); ++depth) {
+        auto child = reinterpret_cast<const UStruct*>(field)->children;
+        for (auto count = 0; count < max_depth && Memory::IsReadable(child); ++count, child = child->next) {
+            if (!Memory::IsReadable(child->class_object)) {
+                continue;
+            }
+
+            auto type_name = tem.find_name(child->class_object->name);
+            auto property = reinterpret_cast<const UProperty*>(child);
+
+            auto element_size = 0u;
+            if (type_name == "StrProperty" && Memory::IsReadable(property)) {
+                element_size = sizeof(wchar_t);
+            } else if (type_name == "ArrayProperty"
+                && Memory::IsReadable(reinterpret_cast<const UArrayProperty*>(property))) {
+                auto inner = reinterpret_cast<const UArrayProperty*>(property)->inner;
+                if (!Memory::IsReadable(inner)) {
+                    continue;
+                }
+                element_size = inner->element_size;
+            } else {
+                continue;
+            }
+
+            for (auto i = 0; i < property->array_dim; ++i) {
+                arrays.push_back({ property->offset + i * property->element_size, element_size });
+            }
+        }
+
+        field = field->super_field;
+    }
+}
+static auto update_object_memory() -> void
+{
+    // Below a millisecond per tick, a pass over the object table of a level takes a few dozen ticks
+    const auto budget = size_t(4096);
+
+    auto g_Objects = reinterpret_cast<TArray<UObject*>*>(Offsets::g_Objects);
+
+    auto lock = std::unique_lock(tem.object_memory_mutex);
+    if (g_Objects->data) {
+        tem.object_memory.Step(g_Objects->data, g_Objects->size, budget, get_owned_arrays, get_object_path);
+    }
+}
+static auto weaken_enemies(PgPawn* pawn) -> void
+{
+    // Every pawn class derives from PgPawn, look it up through the class chain of our own pawn
+    auto pawn_class = static_cast<UField*>(reinterpret_cast<UObject*>(pawn)->class_object);
+    while (pawn_class && pawn_class->name.index != PG_PAWN) {
+        pawn_class = pawn_class->super_field;
+    }
+
+    if (!pawn_class) {
+        return;
+    }
+
+    // Class objects never move, the lookup only has to succeed once
+    static auto level_class = static_cast<UClass*>(nullptr);
+    if (!level_class) {
+        level_class = tem.find_object<UClass>("Engine.Level");
+        if (!level_class) {
+            return;
+        }
+    }
+
+    auto player_pawn = pawn->get_outer_pawn();
+    auto team = player_pawn->replication_info ? player_pawn->replication_info->team : nullptr;
 
-    if (object->is(PG_PAWN)) {
-        if (func->is(POST_INIT_ANIM_TREE) && !tem.pawn()) {
-            println("PAWN SPAWNED 0x{:04x}", uintptr_t(object));
+    auto get_name = [](const UObject* object) { return tem.find_name(object->name); };
+
+    tem.for_each_instance<PgPawn>(static_cast<UClass*>(pawn_class), [&](PgPawn* other) {
+        // Default objects and archetypes have no team either, new pawns would spawn with them
+        auto object = reinterpret_cast<const UObject*>(other);
+        if (!ClassRegistry<UObject>::IsWorldInstance(object, level_class, get_name)) {
+            return;
+        }
+
+        if (other->get_outer_pawn() == player_pawn || (team && other->is_in_team(team))) {
+            return;
+        }
 
-            auto controller = tem.player_controller();
-            if (tem.is_super_user && controller) {
+        if (other->health > 1) {
+            other->health = 1;
+        }
+    });
+}
+static auto on_console_tick(UObject* object, UFunction* func, void* params) -> bool
+{
+    auto delta = GetTickCount64() - tem.last_tick;
+    tem.tickrate = delta != 0 ? 1.0f / (delta / 1'0000.0f) : 0.0f;
+    tem.last_tick = GetTickCount64();
+
+    auto context = tem.refresh_context();
+    auto pawn = context.pawn;
+    auto controller = context.controller;
+
+    if (pawn) {
+        if (tem.is_super_user) {
+            pawn->health = pawn->max_health;
+
+            if (pawn->is_vehicle()) {
+                auto player_pawn = pawn->get_outer_pawn();
+                player_pawn->energy = player_pawn->max_energy;
+                player_pawn->powerup_attacking_damage_scaling = 999.0f;
+            } else {
+                pawn->energy = pawn->max_energy;
+                pawn->powerup_attacking_damage_scaling = 999.0f;
+            }
+
+            if (controller) {
                 controller->set_god_mode(true);
             }
-        } else if (func->is(DESTROYED) && object->as<PgPawn>()->equals(tem.pawn())) {
-            println("PAWN DESTROYED 0x{:04x}", uintptr_t(object));
         }
+
+        //if (GetAsyncKeyState('N') & 1) {
+        //    tem.is_noclipping = !tem.is_noclipping;
+        //}
+
 #if 0
-        if (GetAsyncKeyState(VK_NUMPAD2) < 0) {
-            log_event();
+        const auto noclip_units = 10;
+
+        if (GetAsyncKeyState(VK_NUMPAD7) < 0) {
+            player->position.x += noclip_units;
+        }
+        if (GetAsyncKeyState(VK_NUMPAD4) < 0) {
+            player->position.x -= noclip_units;
+        }
+        if (GetAsyncKeyState(VK_NUMPAD8) < 0) {
+            player->position.y += noclip_units;
+        }
+        if (GetAsyncKeyState(VK_NUMPAD5) < 0) {
+            player->position.y -= noclip_units;
+        }
+        if (GetAsyncKeyState(VK_NUMPAD9) < 0) {
+            player->position.z += noclip_units;
+        }
+        if (GetAsyncKeyState(VK_NUMPAD6) < 0) {
+            player->position.z -= noclip_units;
         }
 #endif
-    } else if (object->is(CONSOLE) && func->is(TICK)) {
-        auto delta = GetTickCount64() - tem.last_tick;
-        tem.tickrate = delta != 0 ? 1.0f / (delta / 1'0000.0f) : 0.0f;
-        tem.last_tick = GetTickCount64();
+    }
 
-        auto pawn = tem.pawn();
-        auto controller = tem.player_controller();
+    update_class_registry();
 
-        if (pawn) {
-            if (tem.is_super_user) {
-                pawn->health = pawn->max_health;
-
-                if (pawn->is_vehicle()) {
-                    auto player_pawn = pawn->get_outer_pawn();
-                    player_pawn->energy = player_pawn->max_energy;
-                    player_pawn->powerup_attacking_damage_scaling = 999.0f;
-                } else {
-                    pawn->energy = pawn->max_energy;
-                    pawn->powerup_attacking_damage_scaling = 999.0f;
-                }
+    if (ui.show_object_memory) {
+        update_object_memory();
+    }
 
-                if (controller) {
-                    controller->set_god_mode(true);
-                }
-            }
+    if (tem.want_weak_enemies && pawn) {
+        weaken_enemies(pawn);
+    }
+
+    return true;
+}
+
+/*
+ * Handlers get looked up by the name index of object and function, see Events::Dispatch.
+ */
+static auto register_event_handlers() -> void
+{
+    Events::Register(PG_PAWN, POST_INIT_ANIM_TREE, on_pawn_post_init_anim_tree);
+    Events::Register(PG_PAWN, DESTROYED, on_pawn_destroyed);
+    Events::Register(PG_PLAYER_CONTROLLER, DESTROYED, on_player_controller_destroyed);
+    Events::Register(CONSOLE, TICK, on_console_tick);
+}
 
-            //if (GetAsyncKeyState('N') & 1) {
-            //    tem.is_noclipping = !tem.is_noclipping;
-            //}
+DETOUR_T(void, ProcessEvent, UObject* object, UFunction* func, void* params, int result)
+{
+    HOOK_STATS("UEngine::ProcessEvent");
 
 #if 0
-            const auto noclip_units = 10;
+    auto log_event = [&]() {
+        println("{}::{} this = 0x{:04x} func = 0x{:04x} params = 0x{:04x}", tem.find_name(object->name),
+            tem.find_name(func->name), uintptr_t(object), uintptr_t(func), uintptr_t(params));
+    };
 
-            if (GetAsyncKeyState(VK_NUMPAD7) < 0) {
-                player->position.x += noclip_units;
-            }
-            if (GetAsyncKeyState(VK_NUMPAD4) < 0) {
-                player->position.x -= noclip_units;
-            }
-            if (GetAsyncKeyState(VK_NUMPAD8) < 0) {
-                player->position.y += noclip_units;
-            }
-            if (GetAsyncKeyState(VK_NUMPAD5) < 0) {
-                player->position.y -= noclip_units;
-            }
-            if (GetAsyncKeyState(VK_NUMPAD9) < 0) {
-                player->position.z += noclip_units;
-            }
-            if (GetAsyncKeyState(VK_NUMPAD6) < 0) {
-                player->position.z -= noclip_units;
-            }
+    if ((GetAsyncKeyState(VK_NUMPAD1) < 0) && ui.game_window_is_focused() && tem.engine() && !tem.engine()->is_paused()) {
+        log_event();
+    }
 #endif
-        }
 
-        if (tem.want_weak_enemies && controller && controller->enemy) {
-            controller->enemy->health = 1;
-        }
+    //// TODO: Find a way to explore multiplayer maps in single player
+    //// A handler for PG_PLAYER_CONTROLLER::SET_CAMERA_TARGET_TIMER which returns false skips the event.
+
+    if (!Events::Dispatch(object->name.index, func->name.index, object, func, params)) {
+        return;
     }
 
+    hook_stats.Pause();
     ProcessEvent(object, func, params, result);
 }
 
 DETOUR_T(Color*, GetTeamColor, PgTeamInfo* team, Color* color, int team_color_index)
 {
+    HOOK_STATS("PgTeamInfo::GetTeamColor");
+
     if (tem.want_rgb_suit && team_color_index == -1) {
         auto pawn = tem.pawn();
 
@@ -336,12 +564,23 @@ DETOUR_T(Color*, GetTeamColor, PgTeamInfo* team, Color* color, int team_color_in
         }
     }
 
+    hook_stats.Pause();
     return GetTeamColor(team, color, team_color_index);
 }
 
 DETOUR_T(FString*, ConsoleCommand, UGameViewportClient* client, const FString& output, const FString& command)
 {
-    println("[command] [{:x}] {}", uintptr_t(_ReturnAddress()), command.str().c_str());
+    HOOK_STATS("UGameViewportClient::ConsoleCommand");
+
+    // Most commands fit on the stack, only long ones allocate
+    char text[512];
+    if (Unicode::MaxUtf8Size(command.size) > sizeof(text)) {
+        println("[command] [{:x}] {}", uintptr_t(_ReturnAddress()), command.str());
+    } else {
+        auto size = command.str(text, sizeof(text));
+        println("[command] [{:x}] {}", uintptr_t(_ReturnAddress()), std::string_view(text, size));
+    }
 
+    hook_stats.Pause();
     return ConsoleCommand(client, output, command);
 }
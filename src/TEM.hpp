@@ -5,9 +5,18 @@
  */
 
 #pragma once
+#include "ClassRegistry.hpp"
 #include "Memory.hpp"
+#include "NameIndex.hpp"
+#include "ObjectIndex.hpp"
+#include "ObjectMemory.hpp"
+#include "Offsets.hpp"
 #include "SDK.hpp"
+#include <atomic>
+#include <chrono>
 #include <map>
+#include <mutex>
+#include <type_traits>
 
 #define TEM_WELCOME "Tron Evolution Mod by NeKz :^)"
 #define TEM_VERSION "Version 0.1.0 (" __TIMESTAMP__  ")"
@@ -28,8 +37,23 @@
 #define MV_SWITCH_TO_STASIS_DISC (1 << 16)
 #define MV_SWITCH_TO_CORRUPTION_DISC (1 << 17)
 
+/*
+ * Pointers which every hook needs. They get resolved once per console tick
+ * instead of on every access, destroying the pawn or the controller
+ * refreshes them right away.
+ */
+struct TEMContext {
+    UEngine* engine = nullptr;
+    ULocalPlayer* local_player = nullptr;
+    PgPlayerController* controller = nullptr;
+    PgPawn* pawn = nullptr;
+    AWorldInfo* world_info = nullptr;
+    PgHud* hud = nullptr;
+};
+
 struct TEM {
     HMODULE module_handle = 0;
+    std::chrono::steady_clock::time_point attach_time = {};
 
     std::atomic_bool is_attached = false;
     std::atomic_bool is_hooked = false;
@@ -48,12 +72,91 @@ struct TEM {
     float rgb_last_update = 0.0f;
     const float rgb_update_interval = 0.5f;
 
+    NameIndex name_index = {};
+    ObjectIndex<UObject> object_index = {};
+    ClassRegistry<UObject> class_registry = {};
+    std::mutex index_mutex = {}; // Guards name_index, object_index and class_registry
+
+    // Walked by the console tick while the overlay shows it
+    ObjectMemory<UObject> object_memory = {};
+    std::mutex object_memory_mutex = {};
+
     auto find_name(FName name) -> std::string_view;
     auto find_name_index(const char* name) -> int;
+    auto find_object(const char* path, const char* class_name = nullptr) -> UObject*;
+
+    /*
+     * Finds an object by its full path like "Engine.Pawn". Class types only
+     * match objects of that class, any other type matches every class.
+     */
+    template <typename T = UObject> inline auto find_object(const char* path) -> T*
+    {
+        if constexpr (std::is_same_v<T, UClass>) {
+            return reinterpret_cast<T*>(this->find_object(path, "Class"));
+        } else if constexpr (std::is_same_v<T, UFunction>) {
+            return reinterpret_cast<T*>(this->find_object(path, "Function"));
+        } else if constexpr (std::is_same_v<T, UState>) {
+            return reinterpret_cast<T*>(this->find_object(path, "State"));
+        } else if constexpr (std::is_same_v<T, UScriptStruct>) {
+            return reinterpret_cast<T*>(this->find_object(path, "ScriptStruct"));
+        } else if constexpr (std::is_same_v<T, UEnum>) {
+            return reinterpret_cast<T*>(this->find_object(path, "Enum"));
+        } else if constexpr (std::is_same_v<T, UConst>) {
+            return reinterpret_cast<T*>(this->find_object(path, "Const"));
+        } else {
+            return reinterpret_cast<T*>(this->find_object(path, nullptr));
+        }
+    }
+
+    /*
+     * Calls callback with every live instance of class_object and of its
+     * subclasses. The registry gets updated by the console tick, objects
+     * which were created since then are not visited yet.
+     */
+    template <typename T = UObject, typename Callback>
+    inline auto for_each_instance(UClass* class_object, Callback callback) -> size_t
+    {
+        auto g_Objects = reinterpret_cast<TArray<UObject*>*>(Offsets::g_Objects);
+
+        auto lock = std::unique_lock(this->index_mutex);
+        return this->class_registry.ForEach(g_Objects->data, g_Objects->size, class_object,
+            [&callback](UObject* object) { callback(reinterpret_cast<T*>(object)); });
+    }
+
+    // Seqlock, the sequence is odd while a refresh writes the context
+    TEMContext current_context = {};
+    std::atomic<uint32_t> context_sequence = 0;
+    std::mutex context_mutex = {}; // Serializes refreshes
+
+    /*
+     * Resolves every pointer of the context again. Pointers to the object
+     * which is being destroyed are dropped. Only the game thread refreshes
+     * besides attach and detach.
+     */
+    auto refresh_context(const void* destroyed = nullptr) -> TEMContext;
+
+    /*
+     * Copy of the context which no refresh wrote to in the meantime.
+     */
+    inline auto context() const -> TEMContext
+    {
+        while (true) {
+            auto sequence = this->context_sequence.load(std::memory_order_acquire);
+            if (sequence & 1) {
+                continue;
+            }
+
+            auto result = this->current_context;
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (this->context_sequence.load(std::memory_order_relaxed) == sequence) {
+                return result;
+            }
+        }
+    }
 
-    inline auto engine() -> UEngine*;
-    inline auto player_controller() -> PgPlayerController*;
-    inline auto pawn() -> PgPawn*;
+    inline auto engine() -> UEngine* { return this->context().engine; }
+    inline auto player_controller() -> PgPlayerController* { return this->context().controller; }
+    inline auto pawn() -> PgPawn* { return this->context().pawn; }
     auto console_command(std::wstring command) -> void;
 
     std::map<std::string, std::pair<int, std::vector<int>>> command_to_key_move = {
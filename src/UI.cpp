@@ -8,6 +8,7 @@
 #include "Console.hpp"
 #include "Dumper.hpp"
 #include "GFWL.hpp"
+#include "HookStats.hpp"
 #include "Memory.hpp"
 #include "Offsets.hpp"
 #include "Platform.hpp"
@@ -110,9 +111,12 @@ auto ui_shutdown() -> void
 
 DETOUR_STD(HRESULT, Reset, IDirect3DDevice9* device, D3DPRESENT_PARAMETERS* pPresentationParameters)
 {
+    HOOK_STATS("IDirect3DDevice9::Reset");
+
     ImGui_ImplDX9_InvalidateDeviceObjects();
     ImGui_ImplDX9_CreateDeviceObjects();
 
+    hook_stats.Pause();
     return Reset(device, pPresentationParameters);
 }
 
@@ -136,9 +140,160 @@ auto create_hover_tooltip(const char* help_text) -> void
     }
 }
 
+/*
+ * Shows what every hook costs per frame. Self time leaves out the original function.
+ */
+auto draw_hook_stats() -> void
+{
+    static auto previous = HookStats::Snapshot();
+    static auto snapshot = HookStats::Snapshot();
+    static auto frames = 1;
+    static auto last_frame = ImGui::GetFrameCount();
+    static auto last_update = std::chrono::steady_clock::time_point();
+
+    // Summing up the counters of every thread each frame would show up in the numbers. Rates come from the
+    // difference of two snapshots so that the counters keep accumulating for the export.
+    auto now = std::chrono::steady_clock::now();
+    if (now - last_update > std::chrono::milliseconds(500)) {
+        auto current = HookStats::GetSnapshot();
+        snapshot = HookStats::GetDifference(current, previous);
+        previous = std::move(current);
+        frames = (std::max)(1, ImGui::GetFrameCount() - last_frame);
+        last_frame = ImGui::GetFrameCount();
+        last_update = now;
+    }
+
+    ImGui::SetNextWindowSize(ImVec2(640.0f, 320.0f), ImGuiCond_FirstUseEver);
+    if (!ImGui::Begin("Hook Stats", &ui.show_hook_stats)) {
+        return ImGui::End();
+    }
+
+    if (ImGui::Button("Export JSON")) {
+        auto saved = HookStats::SaveJson("hook_stats.json");
+        println("[ui] {} hook_stats.json", saved ? "Saved" : "Unable to save");
+    }
+    create_hover_tooltip("Write every call since the last reset to hook_stats.json.");
+
+    ImGui::SameLine();
+    if (ImGui::Button("Reset")) {
+        HookStats::Reset();
+        previous = HookStats::Snapshot();
+    }
+
+    auto flags = ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg;
+    if (ImGui::BeginTable("hooks", 6, flags)) {
+        ImGui::TableSetupColumn("Hook");
+        ImGui::TableSetupColumn("Calls/frame");
+        ImGui::TableSetupColumn("Self us/frame");
+        ImGui::TableSetupColumn("Mean us");
+        ImGui::TableSetupColumn("p99 us");
+        ImGui::TableSetupColumn("Max us (total)");
+        ImGui::TableHeadersRow();
+
+        for (const auto& hook : snapshot.hooks) {
+            ImGui::TableNextRow();
+            ImGui::TableNextColumn();
+            ImGui::TextUnformatted(hook.name.c_str());
+            ImGui::TableNextColumn();
+            ImGui::Text("%.1f", double(hook.calls) / frames);
+            ImGui::TableNextColumn();
+            ImGui::Text("%.2f", hook.self_us / frames);
+            ImGui::TableNextColumn();
+            ImGui::Text("%.2f", hook.mean_us);
+            ImGui::TableNextColumn();
+            ImGui::Text("%.2f", hook.p99_us);
+            ImGui::TableNextColumn();
+            ImGui::Text("%.2f", hook.max_us);
+        }
+
+        ImGui::EndTable();
+    }
+
+    ImGui::End();
+}
+
+/*
+ * Shows which classes and packages take the most memory. The console tick
+ * walks the object table while the window is open.
+ */
+auto draw_object_memory() -> void
+{
+    const auto max_rows = size_t(20);
+
+    using Usage = ObjectMemory<UObject>::Usage;
+    auto classes = std::vector<Usage>();
+    auto packages = std::vector<Usage>();
+    auto passes = size_t(0);
+    auto csv = std::string();
+
+    ImGui::SetNextWindowSize(ImVec2(640.0f, 480.0f), ImGuiCond_FirstUseEver);
+    if (!ImGui::Begin("Object Memory", &ui.show_object_memory)) {
+        return ImGui::End();
+    }
+
+    auto export_csv = ImGui::Button("Export CSV");
+
+    // Copy the top rows only, the game thread keeps stepping in the meantime
+    {
+        auto lock = std::unique_lock(tem.object_memory_mutex);
+        const auto& all_classes = tem.object_memory.GetClasses();
+        const auto& all_packages = tem.object_memory.GetPackages();
+        classes.assign(all_classes.begin(), all_classes.begin() + (std::min)(max_rows, all_classes.size()));
+        packages.assign(all_packages.begin(), all_packages.begin() + (std::min)(max_rows, all_packages.size()));
+        passes = tem.object_memory.GetPassCount();
+        if (export_csv) {
+            csv = tem.object_memory.ToCsv();
+        }
+    }
+
+    if (export_csv) {
+        auto saved = bool(std::ofstream("tron_evolution_memory.csv") << csv);
+        println("[ui] {} tron_evolution_memory.csv", saved ? "Saved" : "Unable to save");
+    }
+
+    ImGui::SameLine();
+    if (passes) {
+        ImGui::Text("Pass %zu", passes);
+    } else {
+        ImGui::TextUnformatted("Walking objects...");
+    }
+
+    auto draw_table = [](const char* id, const char* title, const std::vector<Usage>& usages) {
+        auto flags = ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg;
+        if (ImGui::BeginTable(id, 4, flags)) {
+            ImGui::TableSetupColumn(title);
+            ImGui::TableSetupColumn("Instances");
+            ImGui::TableSetupColumn("Size KB");
+            ImGui::TableSetupColumn("Heap KB");
+            ImGui::TableHeadersRow();
+
+            for (const auto& usage : usages) {
+                ImGui::TableNextRow();
+                ImGui::TableNextColumn();
+                ImGui::TextUnformatted(usage.name.c_str());
+                ImGui::TableNextColumn();
+                ImGui::Text("%u", usage.instances);
+                ImGui::TableNextColumn();
+                ImGui::Text("%.1f", usage.bytes / 1024.0);
+                ImGui::TableNextColumn();
+                ImGui::Text("%.1f", usage.heap_bytes / 1024.0);
+            }
+
+            ImGui::EndTable();
+        }
+    };
+
+    draw_table("classes", "Class", classes);
+    draw_table("packages", "Package", packages);
+
+    ImGui::End();
+}
+
 DETOUR_STD(HRESULT, Present, IDirect3DDevice9* device, RECT* pSourceRect, RECT* pDestRect, HWND hDestWindowOverride,
     RGNDATA* pDirtyRegion)
 {
+    HOOK_STATS("IDirect3DDevice9::Present");
+
     if (!ui.initialized && !ui.is_shutdown) {
         if (ui.window_handle != NULL) {
             ui.window_proc = WNDPROC(SetWindowLongPtr(ui.window_handle, GWLP_WNDPROC, LONG_PTR(wnd_proc_handler)));
@@ -177,7 +332,11 @@ DETOUR_STD(HRESULT, Present, IDirect3DDevice9* device, RECT* pSourceRect, RECT*
             ImGui::End();
         }
 
-        auto player = tem.pawn();
+        // Same pointers for the whole frame even if the game thread refreshes them meanwhile
+        auto context = tem.context();
+        auto controller = context.controller;
+
+        auto player = context.pawn;
         if (player) {
             if (ui.show_timer) {
                 char timer[16] = {};
@@ -243,8 +402,8 @@ DETOUR_STD(HRESULT, Present, IDirect3DDevice9* device, RECT* pSourceRect, RECT*
                 ImGui::SetNextWindowPos(ImVec2(x, y));
                 ImGui::SetNextWindowSize(ImVec2(265, 30));
                 ImGui::Begin("enemy_health", nullptr, flags);
-                if (tem.player_controller() && tem.player_controller()->enemy) {
-                    ImGui::Text("enemy hp: %i", tem.player_controller()->enemy->health);
+                if (controller && controller->enemy) {
+                    ImGui::Text("enemy hp: %i", controller->enemy->health);
                 } else {
                     ImGui::Text("enemy hp: -");
                 }
@@ -367,8 +526,7 @@ DETOUR_STD(HRESULT, Present, IDirect3DDevice9* device, RECT* pSourceRect, RECT*
             }
         }
 
-        if (ui.show_inputs && tem.player_controller() && tem.player_controller()->player_input
-            && !tem.engine()->is_paused()) {
+        if (ui.show_inputs && controller && controller->player_input && !context.engine->is_paused()) {
             typedef uint8_t mode;
             typedef uint8_t row;
             typedef uint8_t col;
@@ -405,7 +563,7 @@ DETOUR_STD(HRESULT, Present, IDirect3DDevice9* device, RECT* pSourceRect, RECT*
             ctx.y_offset
                 = ImGui::GetIO().DisplaySize.y - (ctx.max_rows * ctx.size) - ((ctx.max_rows - 1) * ctx.padding);
 
-            auto player_input = tem.player_controller()->player_input;
+            auto player_input = controller->player_input;
 
             foreach_item(key_name, player_input->pressed_keys)
             {
@@ -498,13 +656,20 @@ DETOUR_STD(HRESULT, Present, IDirect3DDevice9* device, RECT* pSourceRect, RECT*
             ImGui::End();
         }
 
+        if (ui.show_hook_stats) {
+            draw_hook_stats();
+        }
+
+        if (ui.show_object_memory) {
+            draw_object_memory();
+        }
+
         if (ui.menu && ImGui::BeginMainMenuBar()) {
             if (ImGui::BeginMenu("TEM")) {
                 if (ImGui::MenuItem("Superuser", nullptr, tem.is_super_user)) {
                     tem.is_super_user = !tem.is_super_user;
 
                     if (!tem.is_super_user) {
-                        auto controller = tem.player_controller();
                         if (controller) {
                             controller->set_god_mode(false);
                         }
@@ -568,11 +733,20 @@ DETOUR_STD(HRESULT, Present, IDirect3DDevice9* device, RECT* pSourceRect, RECT*
                 if (ImGui::MenuItem("Flags", nullptr, ui.show_flags)) {
                     ui.show_flags = !ui.show_flags;
                 }
+                if (ImGui::MenuItem("Hook Stats", nullptr, ui.show_hook_stats)) {
+                    ui.show_hook_stats = !ui.show_hook_stats;
+                }
+                create_hover_tooltip("Measure the time spent in hooks. Costs a few cycles per hooked call.");
+                if (ImGui::MenuItem("Object Memory", nullptr, ui.show_object_memory)) {
+                    ui.show_object_memory = !ui.show_object_memory;
+                }
+                create_hover_tooltip("Estimate the memory of every class and package. Walks all objects over a "
+                                     "few frames while shown.");
                 if (ImGui::MenuItem("Inputs", nullptr, ui.show_inputs)) {
                     ui.show_inputs = !ui.show_inputs;
 
                     // TODO: This should be called when the settings change
-                    auto player_input = tem.player_controller() ? tem.player_controller()->player_input : nullptr;
+                    auto player_input = controller ? controller->player_input : nullptr;
                     if (player_input) {
                         for (auto& [key, value] : tem.command_to_key_move) {
                             auto& keys = value.second;
@@ -595,8 +769,8 @@ DETOUR_STD(HRESULT, Present, IDirect3DDevice9* device, RECT* pSourceRect, RECT*
                 }
                 ImGui::EndMenu();
             }
-            if (ImGui::BeginMenu("Level") && tem.engine()) {
-                auto current_level = tem.engine()->get_level_name();
+            if (ImGui::BeginMenu("Level") && context.engine) {
+                auto current_level = context.engine->get_level_name();
 
                 for (auto& [level_name, display_name] : game_levels) {
                     if (display_name == "Main Menu") {
@@ -633,17 +807,16 @@ DETOUR_STD(HRESULT, Present, IDirect3DDevice9* device, RECT* pSourceRect, RECT*
                 }
                 create_hover_tooltip("Enemies in range will be super weak.");
 
-                if (tem.engine() && tem.engine()->get_local_player() && tem.engine()->get_local_player()->actor
-                    && tem.engine()->get_local_player()->actor->cheat_manager) {
+                if (controller && controller->cheat_manager) {
                     if (ImGui::MenuItem("PgCheatManager::OnScreenWarnings()")) {
-                        auto cheat_manager = tem.engine()->get_local_player()->actor->cheat_manager;
+                        auto cheat_manager = controller->cheat_manager;
                         Memory::VMT<int(__stdcall*)()>(cheat_manager, 71)();
                         println("Called PgCheatManager::OnScreenWarnings()");
                     }
                     create_hover_tooltip("Show Kismet debug warnings.");
 
                     if (ImGui::MenuItem("PgCheatManager::DoApplyXP(69420)")) {
-                        auto cheat_manager = tem.engine()->get_local_player()->actor->cheat_manager;
+                        auto cheat_manager = controller->cheat_manager;
                         Memory::VMT<int(__stdcall*)(int xp)>(cheat_manager, 82)(69'420);
                         println("Called PgCheatManager::DoApplyXP(69420)");
                     }
@@ -657,6 +830,23 @@ DETOUR_STD(HRESULT, Present, IDirect3DDevice9* device, RECT* pSourceRect, RECT*
                     }
                     create_hover_tooltip("Dump engine names and objects. Game will freeze for a few seconds.");
 
+                    if (ImGui::MenuItem("Dump Engine Snapshot")) {
+                        dump_engine_to_snapshot();
+                    }
+                    create_hover_tooltip("Write names, objects and properties to tron_evolution.snapshot for "
+                                         "offline analysis.");
+
+                    if (ImGui::MenuItem("Capture Object Baseline")) {
+                        capture_engine_snapshot_baseline();
+                    }
+                    create_hover_tooltip("Remember all objects to compare them later, e.g. before a level transition.");
+
+                    if (ImGui::MenuItem("Diff Objects Against Baseline")) {
+                        dump_engine_snapshot_diff();
+                    }
+                    create_hover_tooltip("Write created, destroyed and reclassified objects since the baseline to "
+                                         "tron_evolution_diff.md.");
+
                     // PgUnlockSystem::SetPlayerSkin
                     //if (ImGui::MenuItem("PgUnlockSystem::SetPlayerSkin")) {
                     //    struct PgUnlockItemPlayerSkin {};
@@ -685,5 +875,9 @@ DETOUR_STD(HRESULT, Present, IDirect3DDevice9* device, RECT* pSourceRect, RECT*
         ImGui_ImplDX9_RenderDrawData(ImGui::GetDrawData());
     }
 
+    // Recording stays on while the window is open, the original waits for vsync and is left out
+    HookStats::SetEnabled(ui.show_hook_stats && !ui.is_shutdown);
+    hook_stats.Pause();
+
     return Present(device, pSourceRect, pDestRect, hDestWindowOverride, pDirtyRegion);
 }
@@ -23,6 +23,8 @@ struct UI {
     bool show_enemy_health = false;
     bool show_flags = false;
     bool show_inputs = false;
+    bool show_hook_stats = false;
+    bool show_object_memory = false;
     std::atomic<bool> is_shutdown = false;
 
     inline auto game_window_is_focused() -> bool { return GetForegroundWindow() == this->window_handle; }
@@ -0,0 +1,136 @@
+/*
+ * Copyright (c) 2022-2023, NeKz
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "Unicode.hpp"
+#include "Simd.hpp"
+
+#if defined(_M_X64) || defined(__x86_64__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2) || defined(__SSE2__)
+#define UNICODE_SSE2 1
+#include <emmintrin.h>
+#else
+#define UNICODE_SSE2 0
+#endif
+
+/*
+ * Reads the code point at position, returns the number of units it takes.
+ */
+static inline auto decode(const char16_t* data, size_t size, size_t position, char32_t* code_point) -> size_t
+{
+    auto unit = data[position];
+    if (unit < 0xD800 || unit > 0xDFFF) {
+        *code_point = unit;
+        return 1;
+    }
+
+    if (unit <= 0xDBFF && position + 1 < size && data[position + 1] >= 0xDC00 && data[position + 1] <= 0xDFFF) {
+        *code_point = 0x10000 + ((char32_t(unit) - 0xD800) << 10) + (char32_t(data[position + 1]) - 0xDC00);
+        return 2;
+    }
+
+    *code_point = 0xFFFD;
+    return 1;
+}
+
+static inline auto encoded_size(char32_t code_point) -> size_t
+{
+    return code_point < 0x80 ? 1 : code_point < 0x800 ? 2 : code_point < 0x10000 ? 3 : 4;
+}
+
+static inline auto encode(char32_t code_point, char* output) -> size_t
+{
+    if (code_point < 0x80) {
+        output[0] = char(code_point);
+        return 1;
+    }
+    if (code_point < 0x800) {
+        output[0] = char(0xC0 | (code_point >> 6));
+        output[1] = char(0x80 | (code_point & 0x3F));
+        return 2;
+    }
+    if (code_point < 0x10000) {
+        output[0] = char(0xE0 | (code_point >> 12));
+        output[1] = char(0x80 | ((code_point >> 6) & 0x3F));
+        output[2] = char(0x80 | (code_point & 0x3F));
+        return 3;
+    }
+    output[0] = char(0xF0 | (code_point >> 18));
+    output[1] = char(0x80 | ((code_point >> 12) & 0x3F));
+    output[2] = char(0x80 | ((code_point >> 6) & 0x3F));
+    output[3] = char(0x80 | (code_point & 0x3F));
+    return 4;
+}
+
+auto Unicode::Utf8Size(const char16_t* data, size_t size) -> size_t
+{
+    auto result = size_t(0);
+    for (auto position = size_t(0); position < size;) {
+        char32_t code_point = 0;
+        position += decode(data, size, position, &code_point);
+        result += encoded_size(code_point);
+    }
+    return result;
+}
+
+auto Unicode::ToUtf8(const char16_t* data, size_t size, char* buffer, size_t capacity) -> size_t
+{
+    auto position = size_t(0);
+    auto written = size_t(0);
+
+    while (position < size) {
+        auto vectorized = false;
+
+#if UNICODE_SSE2
+        if (size - position >= 16 && capacity - written >= 16) {
+            auto low = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + position));
+            auto high = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + position + 8));
+
+            // Packing treats units as signed, the ASCII check has to happen before it
+            auto mask = _mm_set1_epi16(short(0xFF80));
+            auto zero = _mm_setzero_si128();
+            auto ascii = _mm_packs_epi16(_mm_cmpeq_epi16(_mm_and_si128(low, mask), zero),
+                _mm_cmpeq_epi16(_mm_and_si128(high, mask), zero));
+            auto non_ascii = ~uint32_t(_mm_movemask_epi8(ascii)) & 0xFFFF;
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(buffer + written), _mm_packus_epi16(low, high));
+
+            if (!non_ascii) {
+                position += 16;
+                written += 16;
+                continue;
+            }
+
+            // Keep the ASCII prefix, the scalar encoder takes over until the next ASCII unit
+            auto prefix = size_t(count_trailing_zeros(non_ascii));
+            position += prefix;
+            written += prefix;
+            vectorized = true;
+        }
+#endif
+
+        while (position < size) {
+            char32_t code_point = 0;
+            auto units = decode(data, size, position, &code_point);
+            if (written + encoded_size(code_point) > capacity) {
+                return written;
+            }
+
+            written += encode(code_point, buffer + written);
+            position += units;
+
+            if (vectorized && code_point < 0x80) {
+                break;
+            }
+        }
+    }
+
+    return written;
+}
+
+auto Unicode::ToUtf8(const char16_t* data, size_t size) -> std::string
+{
+    auto result = std::string(Unicode::MaxUtf8Size(size), '\0');
+    result.resize(Unicode::ToUtf8(data, size, result.data(), result.size()));
+    return result;
+}
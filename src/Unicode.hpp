@@ -0,0 +1,36 @@
+/*
+ * Copyright (c) 2022-2023, NeKz
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/*
+ * UTF-16LE to UTF-8 transcoding for engine strings.
+ *
+ * Runs of ASCII get narrowed 16 units per step with SSE2, everything else
+ * goes through the scalar encoder. Unpaired surrogates become U+FFFD like
+ * WideCharToMultiByte does without WC_ERR_INVALID_CHARS.
+ */
+namespace Unicode {
+
+/*
+ * Upper bound of the UTF-8 size of size UTF-16 units, a surrogate pair
+ * takes four bytes and every other unit at most three.
+ */
+constexpr auto MaxUtf8Size(size_t size) -> size_t { return size * 3; }
+
+auto Utf8Size(const char16_t* data, size_t size) -> size_t;
+
+/*
+ * Writes at most capacity bytes without a terminating NUL and never splits a
+ * code point. Returns the number of written bytes.
+ */
+auto ToUtf8(const char16_t* data, size_t size, char* buffer, size_t capacity) -> size_t;
+auto ToUtf8(const char16_t* data, size_t size) -> std::string;
+
+}
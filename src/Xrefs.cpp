@@ -0,0 +1,286 @@
+/*
+ * Copyright (c) 2022-2023, NeKz
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "Xrefs.hpp"
+#include "Scanner.hpp"
+#include "Simd.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+/*
+ * Targets of a pass. Absolute values can only reach targets below 4 GB.
+ */
+struct Targets {
+    const std::vector<uintptr_t>* sorted;
+    uintptr_t min;
+    uintptr_t max;
+    uint32_t absolute_min;
+    uint32_t absolute_max;
+    bool has_absolute;
+};
+
+static auto is_target(const Targets& targets, uintptr_t address) -> bool
+{
+    return address >= targets.min && address <= targets.max
+        && std::binary_search(targets.sorted->begin(), targets.sorted->end(), address);
+}
+
+/*
+ * Checks the call/jmp at position, the caller guarantees 5 readable bytes.
+ */
+static auto check_branch(const uint8_t* start, size_t position, uintptr_t base, const Targets& targets,
+    uint32_t kinds, std::vector<Xrefs::Reference>* references) -> void
+{
+    auto kind = start[position] == 0xE8 ? XREF_CALL : XREF_JUMP;
+    if (!(kinds & kind)) {
+        return;
+    }
+
+    auto relative = int32_t();
+    std::memcpy(&relative, start + position + 1, sizeof(relative));
+
+    auto from = base + position;
+    auto to = uintptr_t(from + 5 + intptr_t(relative));
+
+    if (is_target(targets, to)) {
+        references->push_back({ from, to, uint32_t(kind) });
+    }
+}
+
+/*
+ * Checks the 32-bit value at position, the caller guarantees 4 readable bytes.
+ */
+static auto check_pointer(const uint8_t* start, size_t position, uintptr_t base, const Targets& targets,
+    std::vector<Xrefs::Reference>* references) -> void
+{
+    auto value = uint32_t();
+    std::memcpy(&value, start + position, sizeof(value));
+
+    if (is_target(targets, uintptr_t(value))) {
+        references->push_back({ base + position, uintptr_t(value), XREF_ABSOLUTE });
+    }
+}
+
+static auto scan_scalar(const uint8_t* start, size_t length, size_t position, uintptr_t base, const Targets& targets,
+    uint32_t kinds, std::vector<Xrefs::Reference>* references) -> void
+{
+    for (; position + 4 <= length; ++position) {
+        if ((kinds & (XREF_CALL | XREF_JUMP)) && position + 5 <= length
+            && (start[position] == 0xE8 || start[position] == 0xE9)) {
+            check_branch(start, position, base, targets, kinds, references);
+        }
+        if (targets.has_absolute && (kinds & XREF_ABSOLUTE)) {
+            auto value = uint32_t();
+            std::memcpy(&value, start + position, sizeof(value));
+            if (value >= targets.absolute_min && value <= targets.absolute_max) {
+                check_pointer(start, position, base, targets, references);
+            }
+        }
+    }
+}
+
+#if SIMD_X86
+/*
+ * Every step tests the opcode of 16 positions and the 32-bit values which
+ * start at them. Values come from four loads shifted by one byte each, lane
+ * i of load k holds the value at position k + 4 * i.
+ */
+TARGET_SSE2 static auto scan_sse2(const uint8_t* start, size_t length, uintptr_t base, const Targets& targets,
+    uint32_t kinds, std::vector<Xrefs::Reference>* references) -> size_t
+{
+    auto branches_wanted = (kinds & (XREF_CALL | XREF_JUMP)) != 0;
+    auto pointers_wanted = targets.has_absolute && (kinds & XREF_ABSOLUTE);
+
+    auto call = _mm_set1_epi8(char(0xE8));
+    auto jump = _mm_set1_epi8(char(0xE9));
+    auto sign = _mm_set1_epi32(INT32_MIN);
+    auto low = _mm_set1_epi32(int(targets.absolute_min));
+    auto span = _mm_set1_epi32(int((targets.absolute_max - targets.absolute_min) ^ 0x80000000u));
+
+    auto position = size_t(0);
+    for (; position + 16 + 4 <= length; position += 16) {
+        auto block = start + position;
+
+        auto branches = uint32_t(0);
+        if (branches_wanted) {
+            auto bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(block));
+            branches
+                = uint32_t(_mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(bytes, call), _mm_cmpeq_epi8(bytes, jump))));
+        }
+
+        auto pointers = uint32_t(0);
+        if (pointers_wanted) {
+            for (auto k = 0; k < 4; ++k) {
+                auto values = _mm_loadu_si128(reinterpret_cast<const __m128i*>(block + k));
+                auto outside = _mm_cmpgt_epi32(_mm_xor_si128(_mm_sub_epi32(values, low), sign), span);
+                auto inside = uint32_t(_mm_movemask_ps(_mm_castsi128_ps(outside))) ^ 0xF;
+                while (inside) {
+                    pointers |= 1u << (k + 4 * count_trailing_zeros(inside));
+                    inside &= inside - 1;
+                }
+            }
+        }
+
+        while (branches) {
+            check_branch(start, position + count_trailing_zeros(branches), base, targets, kinds, references);
+            branches &= branches - 1;
+        }
+        while (pointers) {
+            check_pointer(start, position + count_trailing_zeros(pointers), base, targets, references);
+            pointers &= pointers - 1;
+        }
+    }
+
+    return position;
+}
+
+TARGET_AVX2 static auto scan_avx2(const uint8_t* start, size_t length, uintptr_t base, const Targets& targets,
+    uint32_t kinds, std::vector<Xrefs::Reference>* references) -> size_t
+{
+    auto branches_wanted = (kinds & (XREF_CALL | XREF_JUMP)) != 0;
+    auto pointers_wanted = targets.has_absolute && (kinds & XREF_ABSOLUTE);
+
+    auto call = _mm256_set1_epi8(char(0xE8));
+    auto jump = _mm256_set1_epi8(char(0xE9));
+    auto sign = _mm256_set1_epi32(INT32_MIN);
+    auto low = _mm256_set1_epi32(int(targets.absolute_min));
+    auto span = _mm256_set1_epi32(int((targets.absolute_max - targets.absolute_min) ^ 0x80000000u));
+
+    auto position = size_t(0);
+    for (; position + 32 + 4 <= length; position += 32) {
+        auto block = start + position;
+
+        auto branches = uint32_t(0);
+        if (branches_wanted) {
+            auto bytes = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(block));
+            branches = uint32_t(
+                _mm256_movemask_epi8(_mm256_or_si256(_mm256_cmpeq_epi8(bytes, call), _mm256_cmpeq_epi8(bytes, jump))));
+        }
+
+        auto pointers = uint32_t(0);
+        if (pointers_wanted) {
+            for (auto k = 0; k < 4; ++k) {
+                auto values = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(block + k));
+                auto outside = _mm256_cmpgt_epi32(_mm256_xor_si256(_mm256_sub_epi32(values, low), sign), span);
+                auto inside = uint32_t(_mm256_movemask_ps(_mm256_castsi256_ps(outside))) ^ 0xFF;
+                while (inside) {
+                    pointers |= 1u << (k + 4 * count_trailing_zeros(inside));
+                    inside &= inside - 1;
+                }
+            }
+        }
+
+        while (branches) {
+            check_branch(start, position + count_trailing_zeros(branches), base, targets, kinds, references);
+            branches &= branches - 1;
+        }
+        while (pointers) {
+            check_pointer(start, position + count_trailing_zeros(pointers), base, targets, references);
+            pointers &= pointers - 1;
+        }
+    }
+
+    return position;
+}
+#endif
+
+Xrefs::Index::Index(std::vector<uintptr_t> targets)
+    : targets(std::move(targets))
+{
+    std::sort(this->targets.begin(), this->targets.end());
+    this->targets.erase(std::unique(this->targets.begin(), this->targets.end()), this->targets.end());
+}
+
+auto Xrefs::Index::Scan(const uint8_t* start, const uint8_t* end, uintptr_t base, uint32_t kinds) -> void
+{
+    if (this->targets.empty() || end <= start) {
+        return;
+    }
+
+    auto state = Targets { &this->targets, this->targets.front(), this->targets.back(), 0, 0, false };
+    for (auto target : this->targets) {
+        if (uint64_t(target) <= UINT32_MAX) {
+            state.absolute_min = state.has_absolute ? state.absolute_min : uint32_t(target);
+            state.absolute_max = uint32_t(target);
+            state.has_absolute = true;
+        }
+    }
+
+    auto found = std::vector<Reference>();
+    auto length = size_t(end - start);
+    auto position = size_t(0);
+
+#if SIMD_X86
+    switch (Scanner::GetBackend()) {
+    case Scanner::Backend::AVX2:
+        position = scan_avx2(start, length, base, state, kinds, &found);
+        break;
+    case Scanner::Backend::SSE2:
+        position = scan_sse2(start, length, base, state, kinds, &found);
+        break;
+    default:
+        break;
+    }
+#endif
+
+    scan_scalar(start, length, position, base, state, kinds, &found);
+
+    // Branch and pointer hits of a block are found out of order
+    auto compare = [](const Reference& a, const Reference& b) {
+        return a.to != b.to ? a.to < b.to : a.from != b.from ? a.from < b.from : a.kind < b.kind;
+    };
+    std::sort(found.begin(), found.end(), compare);
+
+    auto middle = this->references.insert(this->references.end(), found.begin(), found.end());
+    std::inplace_merge(this->references.begin(), middle, this->references.end(), compare);
+}
+auto Xrefs::Index::ScanModule(const char* moduleName, Memory::Section section, uint32_t kinds) -> bool
+{
+    auto info = Memory::ModuleInfo();
+    if (!Memory::TryGetModule(moduleName, &info)) {
+        return false;
+    }
+
+    if (section == Memory::Section::Image || info.sections.empty()) {
+        auto start = reinterpret_cast<const uint8_t*>(info.base);
+        this->Scan(start, start + info.size, info.base, kinds);
+        return true;
+    }
+
+    for (const auto& item : info.sections) {
+        if (Memory::MatchesSection(item, section)) {
+            auto start = reinterpret_cast<const uint8_t*>(item.base);
+            this->Scan(start, start + item.size, item.base, kinds);
+        }
+    }
+    return true;
+}
+auto Xrefs::Index::ScanImage(const Memory::ImageFile& image, Memory::Section section, uint32_t kinds) -> void
+{
+    for (const auto& range : image.GetRanges(section)) {
+        this->Scan(range.start, range.end, uintptr_t(image.GetImageBase() + range.rva), kinds);
+    }
+}
+
+auto Xrefs::Index::Find(uintptr_t target) const -> std::span<const Xrefs::Reference>
+{
+    auto first = std::lower_bound(this->references.begin(), this->references.end(), target,
+        [](const Reference& reference, uintptr_t value) { return reference.to < value; });
+    auto last = std::upper_bound(first, this->references.end(), target,
+        [](uintptr_t value, const Reference& reference) { return value < reference.to; });
+    return { first, last };
+}
+auto Xrefs::Index::Find(uintptr_t target, uint32_t kinds) const -> std::vector<Xrefs::Reference>
+{
+    auto result = std::vector<Reference>();
+    for (const auto& reference : this->Find(target)) {
+        if (reference.kind & kinds) {
+            result.push_back(reference);
+        }
+    }
+    return result;
+}
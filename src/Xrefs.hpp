@@ -0,0 +1,73 @@
+/*
+ * Copyright (c) 2022-2023, NeKz
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+#include "ImageFile.hpp"
+#include "Memory.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#define XREF_CALL (1 << 0) // E8 rel32
+#define XREF_JUMP (1 << 1) // E9 rel32
+#define XREF_ABSOLUTE (1 << 2) // 32-bit pointer, e.g. mov eax, [g_Engine]
+#define XREF_ALL (XREF_CALL | XREF_JUMP | XREF_ABSOLUTE)
+
+/*
+ * Cross-reference finder for a set of target addresses.
+ *
+ * A single pass over the code finds every rel32 call/jmp and every absolute
+ * 32-bit value which resolves to one of the targets. The pass compares 16
+ * (SSE2) or 32 (AVX2) positions per step against the opcodes and the address
+ * range of all targets, only candidates in range get looked up. The backend
+ * is the one of Scanner.
+ *
+ * Addresses are in the address space of the scanned code: the live process
+ * for modules and the preferred image base for image files, which makes the
+ * targets directly comparable to Offsets.hpp:
+ *
+ *     auto index = Xrefs::Index({ Offsets::g_Engine, Offsets::g_Objects });
+ *     index.ScanModule("GridGame.exe");
+ *     for (auto& reference : index.Find(Offsets::g_Engine)) { ... }
+ */
+namespace Xrefs {
+
+struct Reference {
+    uintptr_t from; // Address of the instruction or the pointer
+    uintptr_t to;
+    uint32_t kind;
+};
+
+class Index {
+    std::vector<uintptr_t> targets; // Sorted
+    std::vector<Reference> references; // Sorted by target, then by address
+
+public:
+    Index() = default;
+    Index(std::vector<uintptr_t> targets);
+
+    /*
+     * Adds the references in [start, end). base is the address of start in the
+     * address space of the code.
+     */
+    auto Scan(const uint8_t* start, const uint8_t* end, uintptr_t base, uint32_t kinds = XREF_ALL) -> void;
+    auto ScanModule(const char* moduleName, Memory::Section section = Memory::Section::Code,
+        uint32_t kinds = XREF_ALL) -> bool;
+    auto ScanImage(const Memory::ImageFile& image, Memory::Section section = Memory::Section::Code,
+        uint32_t kinds = XREF_ALL) -> void;
+
+    /*
+     * Returns the references to a target in address order.
+     */
+    auto Find(uintptr_t target) const -> std::span<const Reference>;
+    auto Find(uintptr_t target, uint32_t kinds) const -> std::vector<Reference>;
+
+    inline auto GetTargets() const -> const std::vector<uintptr_t>& { return this->targets; }
+    inline auto GetReferences() const -> const std::vector<Reference>& { return this->references; }
+    inline auto size() const -> size_t { return this->references.size(); }
+};
+}
@@ -0,0 +1,165 @@
+/*
+ * Copyright (c) 2022-2023, NeKz
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "../src/ClassRegistry.hpp"
+#include "Tests.hpp"
+#include <algorithm>
+
+namespace {
+struct TestClass {
+    TestClass* super_field;
+};
+
+struct TestInstance {
+    TestClass* class_object;
+};
+
+struct TestActor {
+    TestClass* class_object;
+    TestActor* outer_object;
+    const char* name;
+};
+}
+
+static auto collect(ClassRegistry<TestInstance>& registry, const std::vector<TestInstance*>& objects,
+    const TestClass* class_object) -> std::vector<TestInstance*>
+{
+    auto result = std::vector<TestInstance*>();
+    registry.ForEach(objects.data(), objects.size(), class_object, [&](TestInstance* object) {
+        result.push_back(object);
+    });
+    std::sort(result.begin(), result.end());
+    return result;
+}
+
+static auto sorted(std::vector<TestInstance*> objects) -> std::vector<TestInstance*>
+{
+    std::sort(objects.begin(), objects.end());
+    return objects;
+}
+
+TEST(class_registry, instances_of_class_and_subclasses)
+{
+    auto actor = TestClass { nullptr };
+    auto pawn = TestClass { &actor };
+    auto player_pawn = TestClass { &pawn };
+    auto enemy_pawn = TestClass { &pawn };
+    auto light = TestClass { &actor };
+
+    auto a = TestInstance { &pawn };
+    auto b = TestInstance { &player_pawn };
+    auto c = TestInstance { &enemy_pawn };
+    auto d = TestInstance { &enemy_pawn };
+    auto e = TestInstance { &light };
+    auto no_class = TestInstance { nullptr };
+
+    auto objects = std::vector<TestInstance*> { &a, nullptr, &b, &c, &no_class, &d, &e };
+
+    auto registry = ClassRegistry<TestInstance>();
+    EXPECT_EQ(registry.Update(objects.data(), objects.size()), size_t(6));
+    EXPECT_EQ(registry.GetInstanceCount(), size_t(5));
+    EXPECT_EQ(registry.GetClassCount(), size_t(4));
+
+    EXPECT_TRUE(collect(registry, objects, &enemy_pawn) == sorted({ &c, &d }));
+    EXPECT_TRUE(collect(registry, objects, &pawn) == sorted({ &a, &b, &c, &d }));
+    EXPECT_TRUE(collect(registry, objects, &actor) == sorted({ &a, &b, &c, &d, &e }));
+    EXPECT_TRUE(collect(registry, objects, &light) == sorted({ &e }));
+    EXPECT_TRUE(collect(registry, objects, nullptr).empty());
+
+    auto unused = TestClass { nullptr };
+    EXPECT_TRUE(collect(registry, objects, &unused).empty());
+
+    // Freed slots get skipped before the sweep reaches them
+    objects[3] = nullptr;
+    EXPECT_TRUE(collect(registry, objects, &enemy_pawn) == sorted({ &d }));
+    EXPECT_EQ(registry.Update(objects.data(), objects.size()), size_t(1));
+    EXPECT_EQ(registry.GetInstanceCount(), size_t(4));
+
+    // A new class in a reused slot
+    auto vehicle = TestClass { &pawn };
+    auto f = TestInstance { &vehicle };
+    objects[1] = &f;
+    EXPECT_EQ(registry.Update(objects.data(), objects.size()), size_t(1));
+    EXPECT_TRUE(collect(registry, objects, &pawn) == sorted({ &a, &b, &d, &f }));
+
+    // Same object with another class
+    f.class_object = &light;
+    EXPECT_TRUE(collect(registry, objects, &vehicle).empty());
+    EXPECT_EQ(registry.Update(objects.data(), objects.size()), size_t(1));
+    EXPECT_TRUE(collect(registry, objects, &light) == sorted({ &e, &f }));
+
+    // Shrunk table
+    objects.resize(2);
+    EXPECT_EQ(registry.Update(objects.data(), objects.size()), size_t(0));
+    EXPECT_EQ(registry.GetInstanceCount(), size_t(2));
+    EXPECT_TRUE(collect(registry, objects, &actor) == sorted({ &a, &f }));
+
+    registry.Clear();
+    EXPECT_EQ(registry.GetInstanceCount(), size_t(0));
+    EXPECT_TRUE(collect(registry, objects, &actor).empty());
+}
+
+TEST(class_registry, sweeps_within_budget)
+{
+    auto pawn = TestClass { nullptr };
+    auto instances = std::vector<TestInstance>(100, TestInstance { &pawn });
+
+    auto objects = std::vector<TestInstance*>();
+    for (auto& instance : instances) {
+        objects.push_back(&instance);
+    }
+
+    auto registry = ClassRegistry<TestInstance>();
+    EXPECT_EQ(registry.Update(objects.data(), 50, 10), size_t(50));
+
+    // New slots are always checked, old ones only within the budget
+    for (auto i = 0; i < 50; ++i) {
+        objects[i] = nullptr;
+    }
+    EXPECT_EQ(registry.Update(objects.data(), objects.size(), 10), size_t(60));
+    EXPECT_EQ(registry.GetInstanceCount(), size_t(90));
+    EXPECT_EQ(collect(registry, objects, &pawn).size(), size_t(50));
+
+    for (auto i = 0; i < 4; ++i) {
+        registry.Update(objects.data(), objects.size(), 10);
+    }
+    EXPECT_EQ(registry.GetInstanceCount(), size_t(50));
+    EXPECT_EQ(registry.Update(objects.data(), objects.size(), 1000), size_t(0));
+}
+
+TEST(class_registry, skips_templates_outside_of_world)
+{
+    auto package_class = TestClass { nullptr };
+    auto level_class = TestClass { nullptr };
+    auto pawn = TestClass { nullptr };
+    auto enemy_pawn = TestClass { &pawn };
+
+    auto package = TestActor { &package_class, nullptr, "PgGame" };
+    auto level = TestActor { &level_class, nullptr, "PersistentLevel" };
+    auto default_object = TestActor { &enemy_pawn, &package, "Default__PgEnemyPawn" };
+    auto archetype = TestActor { &enemy_pawn, &package, "PgEnemyPawn_Arc" };
+    auto default_in_level = TestActor { &enemy_pawn, &level, "Default__PgEnemyPawn_0" };
+    auto enemy = TestActor { &enemy_pawn, &level, "PgEnemyPawn_0" };
+
+    auto objects = std::vector<TestActor*> { &package, &level, &default_object, &archetype, &default_in_level, &enemy };
+
+    auto registry = ClassRegistry<TestActor>();
+    registry.Update(objects.data(), objects.size());
+
+    auto get_name = [](const TestActor* object) { return object->name; };
+
+    auto live = std::vector<TestActor*>();
+    auto visited = registry.ForEach(objects.data(), objects.size(), &pawn, [&](TestActor* object) {
+        if (ClassRegistry<TestActor>::IsWorldInstance(object, &level_class, get_name)) {
+            live.push_back(object);
+        }
+    });
+    EXPECT_EQ(visited, size_t(4));
+    EXPECT_TRUE(live == std::vector<TestActor*> { &enemy });
+
+    EXPECT_TRUE(!ClassRegistry<TestActor>::IsWorldInstance(&enemy, nullptr, get_name));
+    EXPECT_TRUE(!ClassRegistry<TestActor>::IsWorldInstance(nullptr, &level_class, get_name));
+}
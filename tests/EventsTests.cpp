@@ -0,0 +1,69 @@
+/*
+ * Copyright (c) 2022-2023, NeKz
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "../src/Events.hpp"
+#include "Tests.hpp"
+#include <string>
+
+static auto calls = std::string();
+
+static auto on_first(UObject*, UFunction*, void*) -> bool
+{
+    calls += "a";
+    return true;
+}
+static auto on_second(UObject*, UFunction*, void*) -> bool
+{
+    calls += "b";
+    return true;
+}
+static auto on_skip(UObject*, UFunction*, void*) -> bool
+{
+    calls += "s";
+    return false;
+}
+
+TEST(events, dispatch_by_object_and_function)
+{
+    Events::Clear();
+    calls.clear();
+
+    EXPECT_TRUE(Events::Dispatch(0x197B, 0x150, nullptr, nullptr, nullptr));
+    EXPECT_EQ(Events::Register(0x197B, 0x150, nullptr), uint32_t(0));
+
+    auto first = Events::Register(0x197B, 0x150, on_first);
+    auto second = Events::Register(0x197B, 0x150, on_second);
+    Events::Register(0x2FE, 0x150, on_skip);
+    EXPECT_EQ(Events::GetHandlerCount(), size_t(3));
+
+    // Same object with another function, same function on another object, out of range
+    EXPECT_TRUE(Events::Dispatch(0x197B, 0x12D, nullptr, nullptr, nullptr));
+    EXPECT_TRUE(Events::Dispatch(0x197A, 0x150, nullptr, nullptr, nullptr));
+    EXPECT_TRUE(Events::Dispatch(0xFFFFFFFF, 0x150, nullptr, nullptr, nullptr));
+    EXPECT_EQ(calls, std::string());
+
+    EXPECT_TRUE(Events::Dispatch(0x197B, 0x150, nullptr, nullptr, nullptr));
+    EXPECT_EQ(calls, std::string("ab"));
+
+    EXPECT_TRUE(!Events::Dispatch(0x2FE, 0x150, nullptr, nullptr, nullptr));
+    EXPECT_EQ(calls, std::string("abs"));
+
+    // A table which a dispatch already loaded stays valid after a removal
+    auto previous = Events::current.load();
+    EXPECT_TRUE(Events::Remove(first));
+    EXPECT_TRUE(!Events::Remove(first));
+    EXPECT_TRUE(Events::current.load() != previous);
+    EXPECT_EQ(previous->objects[0x197B]->size(), size_t(2));
+
+    calls.clear();
+    EXPECT_TRUE(Events::Dispatch(0x197B, 0x150, nullptr, nullptr, nullptr));
+    EXPECT_EQ(calls, std::string("b"));
+
+    EXPECT_TRUE(Events::Remove(second));
+    Events::Clear();
+    EXPECT_EQ(Events::GetHandlerCount(), size_t(0));
+    EXPECT_TRUE(Events::current.load() == nullptr);
+}
@@ -0,0 +1,123 @@
+/*
+ * Copyright (c) 2022-2023, NeKz
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "../src/HookStats.hpp"
+#include "Tests.hpp"
+#include <thread>
+
+static auto find_hook(const HookStats::Snapshot& snapshot, const char* name) -> const HookStats::HookSnapshot*
+{
+    for (const auto& hook : snapshot.hooks) {
+        if (hook.name == name) {
+            return &hook;
+        }
+    }
+    return nullptr;
+}
+
+TEST(hook_stats, counts_and_histogram)
+{
+    auto id = HookStats::Register("UEngine::ProcessEvent");
+    EXPECT_TRUE(id >= 0);
+    EXPECT_EQ(HookStats::Register("UEngine::ProcessEvent"), id);
+
+    HookStats::Reset();
+
+    // Nothing gets recorded until enabled
+    {
+        auto scope = HookStats::Scope(id);
+    }
+    EXPECT_TRUE(find_hook(HookStats::GetSnapshot(), "UEngine::ProcessEvent") == nullptr);
+
+    HookStats::SetEnabled(true);
+
+    auto threads = std::vector<std::thread>();
+    for (auto i = 0; i < 4; ++i) {
+        threads.emplace_back([id]() {
+            for (auto j = 0; j < 10'000; ++j) {
+                HookStats::Record(id, 100, 10); // Bucket 6: [64, 128)
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    HookStats::Record(id, 5000, 5000); // Bucket 12: [4096, 8192)
+
+    auto snapshot = HookStats::GetSnapshot();
+    auto hook = find_hook(snapshot, "UEngine::ProcessEvent");
+    EXPECT_TRUE(hook != nullptr);
+    EXPECT_EQ(hook->calls, uint64_t(40'001));
+    EXPECT_EQ(hook->histogram[6], uint64_t(40'000));
+    EXPECT_EQ(hook->histogram[12], uint64_t(1));
+    EXPECT_TRUE(snapshot.ticks_per_us > 0.0);
+    EXPECT_TRUE(hook->max_us * snapshot.ticks_per_us > 4999.0);
+    EXPECT_TRUE(hook->p50_us * snapshot.ticks_per_us > 127.0 && hook->p50_us * snapshot.ticks_per_us < 129.0);
+    EXPECT_TRUE(hook->self_us < hook->inclusive_us);
+
+    auto json = HookStats::ToJson(snapshot);
+    EXPECT_TRUE(json.find("\"name\": \"UEngine::ProcessEvent\"") != std::string::npos);
+    EXPECT_TRUE(json.find("\"calls\": 40001") != std::string::npos);
+
+    HookStats::Reset();
+    HookStats::Record(id, 1, 1);
+    EXPECT_EQ(find_hook(HookStats::GetSnapshot(), "UEngine::ProcessEvent")->calls, uint64_t(1));
+
+    HookStats::SetEnabled(false);
+}
+
+TEST(hook_stats, pause_leaves_out_original)
+{
+    auto id = HookStats::Register("IDirect3DDevice9::Present");
+    HookStats::Reset();
+    HookStats::SetEnabled(true);
+
+    {
+        auto scope = HookStats::Scope(id);
+        scope.Pause();
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        scope.Resume();
+    }
+
+    HookStats::SetEnabled(false);
+
+    auto snapshot = HookStats::GetSnapshot();
+    auto hook = find_hook(snapshot, "IDirect3DDevice9::Present");
+    EXPECT_TRUE(hook != nullptr);
+    EXPECT_EQ(hook->calls, uint64_t(1));
+    EXPECT_TRUE(hook->inclusive_us > 15'000.0);
+    EXPECT_TRUE(hook->self_us < 5'000.0);
+}
+
+TEST(hook_stats, difference_between_snapshots)
+{
+    auto id = HookStats::Register("UGameViewportClient::ConsoleCommand");
+    HookStats::Reset();
+    HookStats::SetEnabled(true);
+
+    HookStats::Record(id, 100, 100);
+    auto earlier = HookStats::GetSnapshot();
+
+    HookStats::Record(id, 5000, 5000);
+    HookStats::Record(id, 5000, 5000);
+    auto later = HookStats::GetSnapshot();
+
+    // Counters keep accumulating, only the difference covers the two calls in between
+    auto difference = HookStats::GetDifference(later, earlier);
+    auto hook = find_hook(difference, "UGameViewportClient::ConsoleCommand");
+    EXPECT_TRUE(hook != nullptr);
+    EXPECT_EQ(hook->calls, uint64_t(2));
+    EXPECT_EQ(hook->histogram[6], uint64_t(0));
+    EXPECT_EQ(hook->histogram[12], uint64_t(2));
+    EXPECT_TRUE(hook->p50_us * difference.ticks_per_us > 8191.0);
+    EXPECT_EQ(find_hook(later, "UGameViewportClient::ConsoleCommand")->calls, uint64_t(3));
+
+    // No calls in between
+    EXPECT_TRUE(find_hook(HookStats::GetDifference(later, later), "UGameViewportClient::ConsoleCommand") == nullptr);
+
+    HookStats::SetEnabled(false);
+}
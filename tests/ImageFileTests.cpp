@@ -0,0 +1,138 @@
+/*
+ * Copyright (c) 2022-2023, NeKz
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "../src/ImageFile.hpp"
+#include "Tests.hpp"
+#include <cstdio>
+#include <cstring>
+
+template <typename T> static auto write_at(std::vector<uint8_t>& image, size_t offset, T value) -> void
+{
+    std::memcpy(image.data() + offset, &value, sizeof(T));
+}
+
+/*
+ * PE32 file with ImageBase 0x400000, .text at RVA 0x1000 (file offset 0x400)
+ * and .rdata at RVA 0x2000 (file offset 0x600).
+ */
+static auto write_pe_file(const char* path) -> bool
+{
+    const auto nt = 0x80;
+    const auto optional_header = nt + 24;
+    const auto section_table = optional_header + 0xE0;
+
+    auto image = std::vector<uint8_t>(0x800, 0xCC);
+    std::memset(image.data(), 0, 0x400);
+    write_at<uint16_t>(image, 0x00, 0x5A4D);
+    write_at<uint32_t>(image, 0x3C, nt);
+    write_at<uint32_t>(image, nt, 0x00004550);
+    write_at<uint16_t>(image, nt + 6, 2);
+    write_at<uint32_t>(image, nt + 8, 0x4CF3A1B2);
+    write_at<uint16_t>(image, nt + 20, 0xE0);
+    write_at<uint16_t>(image, optional_header, 0x10B);
+    write_at<uint32_t>(image, optional_header + 28, 0x400000);
+    write_at<uint32_t>(image, optional_header + 56, 0x3000);
+
+    std::memcpy(image.data() + section_table, ".text", 5);
+    write_at<uint32_t>(image, section_table + 8, 0x180);
+    write_at<uint32_t>(image, section_table + 12, 0x1000);
+    write_at<uint32_t>(image, section_table + 16, 0x200);
+    write_at<uint32_t>(image, section_table + 20, 0x400);
+    write_at<uint32_t>(image, section_table + 36, 0x60000020);
+
+    std::memcpy(image.data() + section_table + 40, ".rdata", 6);
+    write_at<uint32_t>(image, section_table + 40 + 8, 0x200);
+    write_at<uint32_t>(image, section_table + 40 + 12, 0x2000);
+    write_at<uint32_t>(image, section_table + 40 + 16, 0x200);
+    write_at<uint32_t>(image, section_table + 40 + 20, 0x600);
+    write_at<uint32_t>(image, section_table + 40 + 36, 0x40000040);
+
+    // call rel32; mov eax, [rel32]
+    const uint8_t code[] = { 0xE8, 0x10, 0x20, 0x30, 0x40, 0x8B, 0x05 };
+    std::memcpy(image.data() + 0x450, code, sizeof(code));
+    std::memcpy(image.data() + 0x650, code, sizeof(code));
+
+    // Past the virtual size of .text, never part of the loaded image
+    std::memcpy(image.data() + 0x5A0, code, sizeof(code));
+
+    auto file = std::fopen(path, "wb");
+    if (!file) {
+        return false;
+    }
+
+    auto written = std::fwrite(image.data(), 1, image.size(), file);
+    return std::fclose(file) == 0 && written == image.size();
+}
+
+TEST(image_file, scan_sections_as_rva)
+{
+    const auto path = "tem_image_file_test.exe";
+    EXPECT_TRUE(write_pe_file(path));
+
+    auto image = Memory::ImageFile();
+    EXPECT_TRUE(image.Open(path));
+    EXPECT_EQ(image.GetImageBase(), uint64_t(0x400000));
+    EXPECT_EQ(image.GetSections().size(), size_t(2));
+    EXPECT_EQ(image.GetFingerprint().timestamp, uint32_t(0x4CF3A1B2));
+
+    auto match = uintptr_t();
+    EXPECT_TRUE(image.Scan("E8 ? ? ? ? 8B 05", &match));
+    EXPECT_EQ(match, uintptr_t(0x1050));
+    EXPECT_EQ(image.ToVirtualAddress(match), uint64_t(0x401050));
+    EXPECT_TRUE(image.Scan("E8 ? ? ? ? 8B 05", &match, 5, Memory::Section::Code));
+    EXPECT_EQ(match, uintptr_t(0x1055));
+    EXPECT_TRUE(image.Scan("E8 ? ? ? ? 8B 05", &match, 0, Memory::Section::ReadOnlyData));
+    EXPECT_EQ(match, uintptr_t(0x2050));
+    EXPECT_TRUE(!image.Scan("E8 ? ? ? ? 8B 06", &match));
+    EXPECT_TRUE(!image.Scan("not a pattern", &match));
+
+    // The DOS header is a match at RVA 0
+    match = uintptr_t(1);
+    EXPECT_TRUE(image.Scan("4D 5A", &match));
+    EXPECT_EQ(match, uintptr_t(0));
+
+    EXPECT_EQ(image.MultiScan("E8 ? ? ? ? 8B 05"), (std::vector<uintptr_t> { 0x1050, 0x2050 }));
+
+    auto signature = Scanner::Signature();
+    Scanner::Parse("E8 ? ? ? ? 8B 05", &signature);
+    auto pattern = Memory::Pattern { "E8 ? ? ? ? 8B 05", signature.view(), { 1, 7 } };
+    auto patterns = Memory::Patterns { &pattern };
+
+    EXPECT_EQ(image.Scan(&pattern, Memory::Section::Code), (std::vector<uintptr_t> { 0x1051, 0x1057 }));
+    EXPECT_EQ(image.MultiScan(&patterns).size(), size_t(2));
+    EXPECT_EQ(image.MultiScan(&patterns, Memory::Section::ReadOnlyData).at(0),
+        (std::vector<uintptr_t> { 0x2051, 0x2057 }));
+
+    auto offset = size_t();
+    auto rva = uintptr_t();
+    EXPECT_TRUE(image.RvaToOffset(0x1050, &offset));
+    EXPECT_EQ(offset, size_t(0x450));
+    EXPECT_TRUE(image.OffsetToRva(0x650, &rva));
+    EXPECT_EQ(rva, uintptr_t(0x2050));
+    EXPECT_TRUE(!image.OffsetToRva(0x5A0, &rva));
+
+    image.Close();
+    EXPECT_TRUE(!image.IsOpen());
+
+    std::remove(path);
+}
+
+TEST(image_file, reject_non_pe_files)
+{
+    const auto path = "tem_image_file_test.txt";
+
+    auto file = std::fopen(path, "wb");
+    EXPECT_TRUE(file != nullptr);
+    std::fputs("not an image", file);
+    std::fclose(file);
+
+    auto image = Memory::ImageFile();
+    EXPECT_TRUE(!image.Open(path));
+    EXPECT_TRUE(!image.Open("does_not_exist.exe"));
+    EXPECT_TRUE(!image.IsOpen());
+
+    std::remove(path);
+}
@@ -0,0 +1,76 @@
+/*
+ * Copyright (c) 2022-2023, NeKz
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "../src/Memory.hpp"
+#include "Tests.hpp"
+#include <algorithm>
+#include <memory>
+
+class Actor {
+public:
+    virtual ~Actor() = default;
+    virtual auto Tick() -> int { return 1; }
+    virtual auto Health() -> int { return 100; }
+};
+
+// Its vtable provides a detour with the right calling convention on every ABI
+class HookedActor : public Actor {
+public:
+    auto Tick() -> int override { return 42; }
+};
+
+// Itanium has two destructor slots, MSVC one
+#ifdef _WIN32
+constexpr auto tick_index = 1;
+#else
+constexpr auto tick_index = 2;
+#endif
+
+static auto current_vtable(const std::unique_ptr<Actor>& actor) -> uintptr_t*
+{
+    return *reinterpret_cast<uintptr_t**>(actor.get());
+}
+
+TEST(memory_interface, shared_vtable_shadows)
+{
+    auto actors = std::vector<std::unique_ptr<Actor>>();
+    auto interfaces = std::vector<std::unique_ptr<Memory::Interface>>();
+    for (auto i = 0; i < 1000; ++i) {
+        actors.push_back(std::make_unique<Actor>());
+        interfaces.push_back(std::make_unique<Memory::Interface>(uintptr_t(actors.back().get())));
+    }
+
+    auto original = interfaces[0]->vtable;
+    EXPECT_TRUE(interfaces[0]->vtableSize > tick_index);
+    EXPECT_EQ(interfaces[999]->vtableSize, interfaces[0]->vtableSize);
+
+    // Every object points at the same copy
+    auto shadow = current_vtable(actors[0]);
+    EXPECT_TRUE(shadow != original);
+    auto shares_shadow = [&](auto& actor) { return current_vtable(actor) == shadow; };
+    EXPECT_TRUE(std::all_of(actors.begin(), actors.end(), shares_shadow));
+
+    auto hooked = HookedActor();
+    auto detour = Memory::Interface(uintptr_t(&hooked), false);
+
+    // Hooks through one interface apply to every object which shares the copy
+    auto tick = uintptr_t();
+    EXPECT_TRUE(interfaces[0]->Hook(detour.Original(tick_index), tick, tick_index));
+    EXPECT_EQ(tick, original[tick_index]);
+    EXPECT_EQ(actors[500]->Tick(), 42);
+    EXPECT_EQ(actors[999]->Health(), 100);
+
+    EXPECT_TRUE(interfaces[999]->Unhook(tick_index));
+    EXPECT_EQ(actors[0]->Tick(), 1);
+
+    // Last reference restores the objects and frees the copy
+    interfaces.resize(1);
+    EXPECT_TRUE(current_vtable(actors[999]) == original);
+    EXPECT_TRUE(current_vtable(actors[0]) == shadow);
+
+    interfaces.clear();
+    EXPECT_TRUE(current_vtable(actors[0]) == original);
+}
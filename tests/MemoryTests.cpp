@@ -0,0 +1,284 @@
+/*
+ * Copyright (c) 2022-2023, NeKz
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "../src/Memory.hpp"
+#include "Tests.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+template <typename T> static auto write_at(std::vector<uint8_t>& image, size_t offset, T value) -> void
+{
+    std::memcpy(image.data() + offset, &value, sizeof(T));
+}
+
+// Minimal PE image with a DOS header, NT headers and a section table.
+static auto make_pe_headers(const std::vector<std::pair<const char*, uint32_t>>& sections) -> std::vector<uint8_t>
+{
+    const auto nt = 0x80;
+    const auto size_of_optional_header = 0xE0;
+
+    auto image = std::vector<uint8_t>(0x400, 0x00);
+    write_at<uint16_t>(image, 0x00, 0x5A4D);
+    write_at<uint32_t>(image, 0x3C, nt);
+    write_at<uint32_t>(image, nt, 0x00004550);
+    write_at<uint16_t>(image, nt + 6, uint16_t(sections.size()));
+    write_at<uint16_t>(image, nt + 20, size_of_optional_header);
+
+    auto header = size_t(nt + 24 + size_of_optional_header);
+    auto rva = uint32_t(0x1000);
+    for (const auto& [name, characteristics] : sections) {
+        std::memcpy(image.data() + header, name, std::strlen(name));
+        write_at<uint32_t>(image, header + 8, 0x800);
+        write_at<uint32_t>(image, header + 12, rva);
+        write_at<uint32_t>(image, header + 36, characteristics);
+        header += 40;
+        rva += 0x1000;
+    }
+    return image;
+}
+
+TEST(memory_sections, parse_pe_section_table)
+{
+    auto image = make_pe_headers({
+        { ".text", 0x60000020 },
+        { ".rdata", 0x40000040 },
+        { ".data", 0xC0000040 },
+        { ".reloc", 0x42000040 },
+    });
+
+    auto sections = std::vector<Memory::SectionInfo>();
+    EXPECT_TRUE(Memory::ParseSections(image.data(), image.size(), &sections));
+    EXPECT_EQ(sections.size(), size_t(4));
+
+    EXPECT_EQ(std::string(sections[0].name), std::string(".text"));
+    EXPECT_EQ(sections[0].base, uintptr_t(0x1000));
+    EXPECT_EQ(sections[0].size, uintptr_t(0x800));
+    EXPECT_EQ(sections[0].flags, uint32_t(SECTION_READ | SECTION_EXECUTE));
+    EXPECT_EQ(sections[2].base, uintptr_t(0x3000));
+    EXPECT_EQ(sections[2].flags, uint32_t(SECTION_READ | SECTION_WRITE));
+
+    EXPECT_TRUE(Memory::MatchesSection(sections[0], Memory::Section::Code));
+    EXPECT_TRUE(!Memory::MatchesSection(sections[0], Memory::Section::ReadOnlyData));
+    EXPECT_TRUE(Memory::MatchesSection(sections[1], Memory::Section::ReadOnlyData));
+    EXPECT_TRUE(!Memory::MatchesSection(sections[1], Memory::Section::Code));
+    EXPECT_TRUE(Memory::MatchesSection(sections[2], Memory::Section::Data));
+    EXPECT_TRUE(Memory::MatchesSection(sections[3], Memory::Section::Readable));
+
+    auto module = Memory::ModuleInfo();
+    module.sections = sections;
+    EXPECT_EQ(module.FindSection(".rdata"), &module.sections[1]);
+    EXPECT_EQ(module.FindSection(".bss"), static_cast<const Memory::SectionInfo*>(nullptr));
+}
+
+TEST(memory_sections, reject_malformed_headers)
+{
+    auto image = make_pe_headers({ { ".text", 0x60000020 } });
+    auto sections = std::vector<Memory::SectionInfo>();
+
+    EXPECT_TRUE(!Memory::ParseSections(image.data(), 0x40, &sections));
+
+    auto truncated = image;
+    write_at<uint16_t>(truncated, 0x80 + 6, 0x1000);
+    EXPECT_TRUE(!Memory::ParseSections(truncated.data(), truncated.size(), &sections));
+
+    auto invalid = image;
+    write_at<uint32_t>(invalid, 0x80, 0x00000000);
+    EXPECT_TRUE(!Memory::ParseSections(invalid.data(), invalid.size(), &sections));
+    EXPECT_TRUE(sections.empty());
+}
+
+TEST(memory_sections, parse_fingerprint)
+{
+    auto image = make_pe_headers({ { ".text", 0x60000020 } });
+    write_at<uint32_t>(image, 0x80 + 8, 0x4CF3A1B2);
+    write_at<uint32_t>(image, 0x80 + 24 + 56, 0x02400000);
+    write_at<uint32_t>(image, 0x80 + 24 + 64, 0x0231D5E4);
+
+    auto fingerprint = ScanCache::Fingerprint();
+    EXPECT_TRUE(Memory::ParseFingerprint(image.data(), image.size(), &fingerprint));
+    EXPECT_EQ(fingerprint.timestamp, uint32_t(0x4CF3A1B2));
+    EXPECT_EQ(fingerprint.size, uint32_t(0x02400000));
+    EXPECT_EQ(fingerprint.checksum, uint32_t(0x0231D5E4));
+
+    EXPECT_TRUE(!Memory::ParseFingerprint(image.data(), 0x90, &fingerprint));
+}
+
+#ifdef _WIN32
+#define SYSTEM_MODULE "kernel32.dll"
+#define SYSTEM_MODULE_UPPER "KERNEL32.DLL"
+#define LATE_MODULE "version.dll"
+#else
+#define SYSTEM_MODULE "libc.so.6"
+#define SYSTEM_MODULE_UPPER "LIBC.SO.6"
+#define LATE_MODULE "libresolv.so.2"
+#endif
+
+TEST(memory_modules, case_insensitive_lookup)
+{
+    auto module = Memory::ModuleInfo();
+    auto upper = Memory::ModuleInfo();
+    EXPECT_TRUE(Memory::TryGetModule(SYSTEM_MODULE, &module));
+    EXPECT_TRUE(Memory::TryGetModule(SYSTEM_MODULE_UPPER, &upper));
+    EXPECT_EQ(module.base, upper.base);
+    EXPECT_TRUE(module.size != 0);
+
+    auto process = Memory::ModuleInfo();
+    EXPECT_TRUE(Memory::TryGetModule(Memory::GetProcessName().c_str(), &process));
+
+    EXPECT_TRUE(!Memory::TryGetModule("does_not_exist.dll", nullptr));
+    EXPECT_TRUE(!Memory::TryGetModule(nullptr, nullptr));
+}
+
+TEST(memory_modules, stable_module_path)
+{
+    auto path = Memory::GetModulePath(SYSTEM_MODULE);
+    EXPECT_TRUE(path != nullptr);
+
+    auto copy = std::string(path);
+    Memory::RefreshModules();
+    Memory::TryGetModule("does_not_exist.dll", nullptr);
+
+    EXPECT_EQ(std::string(path), copy);
+    EXPECT_EQ(Memory::GetModulePath(SYSTEM_MODULE), path);
+}
+
+TEST(memory_modules, refresh_after_load)
+{
+#ifdef _WIN32
+    auto handle = LoadLibraryA(LATE_MODULE);
+#else
+    auto handle = dlopen(LATE_MODULE, RTLD_NOW);
+#endif
+    if (!handle) {
+        return;
+    }
+
+    auto module = Memory::ModuleInfo();
+    EXPECT_TRUE(Memory::TryGetModule(LATE_MODULE, &module));
+
+    auto modules = Memory::GetModules();
+    auto found
+        = std::find_if(modules.begin(), modules.end(), [&](const auto& item) { return item.base == module.base; });
+    EXPECT_TRUE(found != modules.end());
+}
+
+TEST(memory_modules, scan_added_module)
+{
+    auto image = std::vector<uint8_t>(0x3000, 0xCC);
+    image[0x0800] = 0xE8; // Header
+    image[0x1800] = 0xE8; // Code
+    image[0x2800] = 0xE8; // Data
+
+    auto module = Memory::ModuleInfo();
+    std::snprintf(module.name, sizeof(module.name), "%s", "Synthetic.bin");
+    module.base = uintptr_t(image.data());
+    module.size = image.size();
+    module.sections.push_back(
+        { ".text", module.base + 0x1000, 0x1000, SECTION_READ | SECTION_EXECUTE, 0x1000, 0x1000 });
+    module.sections.push_back({ ".data", module.base + 0x2000, 0x1000, SECTION_READ | SECTION_WRITE, 0x2000, 0x1000 });
+    EXPECT_TRUE(Memory::AddModule(module));
+
+    EXPECT_EQ(Memory::Scan("synthetic.bin", "E8 CC"), module.base + 0x0800);
+    EXPECT_EQ(Memory::Scan("synthetic.bin", "E8 CC", 1, Memory::Section::Code), module.base + 0x1801);
+    EXPECT_EQ(Memory::MultiScan("synthetic.bin", "E8 CC").size(), size_t(3));
+    EXPECT_EQ(Memory::MultiScan("synthetic.bin", "E8 CC", 0, Memory::Section::Readable).size(), size_t(2));
+    EXPECT_EQ(Memory::MultiScan("synthetic.bin", "E8 CC", 0, Memory::Section::Data),
+        std::vector<uintptr_t> { module.base + 0x2800 });
+
+    EXPECT_TRUE(Memory::RemoveModule("SYNTHETIC.BIN"));
+    EXPECT_TRUE(!Memory::TryGetModule("synthetic.bin", nullptr));
+}
+
+TEST(memory_modules, visit_matches_without_allocation)
+{
+    auto image = std::vector<uint8_t>(0x3000, 0xCC);
+    for (auto offset : { 0x0100, 0x0900, 0x1100, 0x1900, 0x2100 }) {
+        image[offset] = 0xE8;
+    }
+
+    auto module = Memory::ModuleInfo();
+    std::snprintf(module.name, sizeof(module.name), "%s", "visited.bin");
+    module.base = uintptr_t(image.data());
+    module.size = image.size();
+    module.sections.push_back(
+        { ".text", module.base + 0x1000, 0x1000, SECTION_READ | SECTION_EXECUTE, 0x1000, 0x1000 });
+    EXPECT_TRUE(Memory::AddModule(module));
+
+    constexpr auto signature = Scanner::StaticSignature("E8 CC");
+
+    auto visited = std::vector<uintptr_t>();
+    auto count = Memory::ForEachMatch("visited.bin", signature.view(), [&visited](uintptr_t match) {
+        visited.push_back(match);
+        return true;
+    });
+    EXPECT_EQ(count, size_t(5));
+    EXPECT_EQ(visited, Memory::MultiScan("visited.bin", "E8 CC"));
+
+    // Stops at the limit or when the callback says so
+    EXPECT_EQ(Memory::ForEachMatch("visited.bin", signature.view(), [](uintptr_t) { return true; }, 2), size_t(2));
+    EXPECT_EQ(Memory::ForEachMatch("visited.bin", signature.view(), [](uintptr_t) { return false; }), size_t(1));
+    EXPECT_EQ(Memory::ForEachMatch("missing.bin", signature.view(), [](uintptr_t) { return true; }), size_t(0));
+
+    auto results = Memory::SmallVector<uintptr_t, 3>();
+    EXPECT_EQ(Memory::MultiScan("visited.bin", signature.view(), &results, 1), size_t(3));
+    EXPECT_TRUE(results.full());
+    EXPECT_EQ(results[2], module.base + 0x1101);
+    EXPECT_EQ(Memory::MultiScan("visited.bin", signature.view(), &results), size_t(0));
+
+    results.clear();
+    EXPECT_EQ(Memory::MultiScan("visited.bin", signature.view(), &results, 0, Memory::Section::Code), size_t(2));
+    EXPECT_EQ(std::vector<uintptr_t>(results.begin(), results.end()),
+        (std::vector<uintptr_t> { module.base + 0x1100, module.base + 0x1900 }));
+
+    EXPECT_TRUE(Memory::RemoveModule("visited.bin"));
+}
+
+TEST(memory_modules, multi_scan_same_results_on_threads)
+{
+    auto image = std::vector<uint8_t>(4 * Scanner::chunk_size + 123, 0x90);
+    auto offsets = std::vector<size_t> { 0, 17, Scanner::chunk_size - 1, 2 * Scanner::chunk_size - 2,
+        3 * Scanner::chunk_size + 5, image.size() - 2 };
+    for (auto offset = size_t(4099); offset < image.size() - 1; offset += 65'537) {
+        offsets.push_back(offset);
+    }
+    for (auto offset : offsets) {
+        image[offset] = 0xE8;
+        image[offset + 1] = 0xCC;
+    }
+    image[Scanner::chunk_size + 7] = 0xE9; // Second pattern
+    image[Scanner::chunk_size + 8] = 0x90;
+
+    auto module = Memory::ModuleInfo();
+    std::snprintf(module.name, sizeof(module.name), "%s", "threaded.bin");
+    module.base = uintptr_t(image.data());
+    module.size = image.size();
+    EXPECT_TRUE(Memory::AddModule(module));
+
+    auto call = Scanner::Signature();
+    auto jump = Scanner::Signature();
+    Scanner::Parse("E8 CC", &call);
+    Scanner::Parse("E9 90", &jump);
+    auto call_pattern = Memory::Pattern { "E8 CC", call.view(), { 1 } };
+    auto jump_pattern = Memory::Pattern { "E9 90", jump.view(), { 0 } };
+    auto patterns = Memory::Patterns { &call_pattern, &jump_pattern };
+
+    Scanner::SetThreadCount(1);
+    auto single = Memory::MultiScan("threaded.bin", "E8 CC", 1);
+    auto single_patterns = Memory::MultiScan("threaded.bin", &patterns);
+
+    Scanner::SetThreadCount(4);
+    auto threaded = Memory::MultiScan("threaded.bin", "E8 CC", 1);
+    auto threaded_patterns = Memory::MultiScan("threaded.bin", &patterns);
+    Scanner::SetThreadCount(1);
+
+    EXPECT_EQ(single.size(), offsets.size());
+    EXPECT_TRUE(single == threaded);
+    EXPECT_EQ(single_patterns.size(), offsets.size() + 1);
+    EXPECT_TRUE(single_patterns == threaded_patterns);
+
+    EXPECT_TRUE(Memory::RemoveModule("threaded.bin"));
+}
@@ -0,0 +1,68 @@
+/*
+ * Copyright (c) 2022-2023, NeKz
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "../src/NameIndex.hpp"
+#include "Tests.hpp"
+#include <memory>
+#include <string>
+
+namespace {
+// Same layout as FNameEntry in SDK.hpp
+struct TestNameEntry {
+    int unk0;
+    int unk1;
+    int index;
+    int unk2;
+    char name[64];
+};
+}
+
+static auto make_entry(uint32_t index, const std::string& name) -> std::unique_ptr<TestNameEntry>
+{
+    auto entry = std::make_unique<TestNameEntry>();
+    entry->index = int(index << 1);
+    name.copy(entry->name, sizeof(entry->name) - 1);
+    return entry;
+}
+
+TEST(name_index, lookup_in_both_directions)
+{
+    auto storage = std::vector<std::unique_ptr<TestNameEntry>>();
+    auto entries = std::vector<TestNameEntry*>();
+    for (auto i = uint32_t(0); i < 5000; ++i) {
+        storage.push_back(make_entry(i, "Name_" + std::to_string(i)));
+        entries.push_back(storage.back().get());
+    }
+
+    entries[10] = nullptr; // Not created yet
+    storage[20]->index = 0; // Stale entry
+    storage[30] = make_entry(30, "Name_29"); // Duplicate
+    entries[30] = storage[30].get();
+
+    auto index = NameIndex();
+    EXPECT_EQ(index.FindIndex("Name_0"), -1);
+
+    EXPECT_EQ(index.Update(entries.data(), 4000), size_t(3998));
+    EXPECT_EQ(index.FindIndex("Name_3999"), 3999);
+    EXPECT_EQ(index.FindIndex("Name_4000"), -1);
+    EXPECT_EQ(index.FindIndex("Name_10"), -1);
+    EXPECT_EQ(index.FindIndex("Name_20"), -1);
+    EXPECT_EQ(index.FindIndex("Name_29"), 29);
+    EXPECT_EQ(index.FindIndex("Name_"), -1);
+    EXPECT_TRUE(index.Find(1234) == "Name_1234");
+    EXPECT_TRUE(index.Find(10).empty());
+    EXPECT_TRUE(index.Find(99999).empty());
+
+    // Growing the table indexes the new entries and the ones which were missing
+    entries[10] = storage[10].get();
+    EXPECT_EQ(index.Update(entries.data(), entries.size()), size_t(4999));
+    EXPECT_EQ(index.FindIndex("Name_10"), 10);
+    EXPECT_EQ(index.FindIndex("Name_4999"), 4999);
+    EXPECT_EQ(index.size(), size_t(5000));
+
+    index.Clear();
+    EXPECT_EQ(index.FindIndex("Name_10"), -1);
+}
@@ -0,0 +1,172 @@
+/*
+ * Copyright (c) 2022-2023, NeKz
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "../src/ObjectIndex.hpp"
+#include "Tests.hpp"
+#include <memory>
+#include <string>
+
+namespace {
+// Same layout as FNameEntry in SDK.hpp
+struct TestObjectName {
+    int unk0;
+    int unk1;
+    int index;
+    int unk2;
+    char name[64];
+};
+
+// Same members as UObject in SDK.hpp
+struct TestObject {
+    TestObject* outer_object;
+    struct {
+        unsigned int index;
+        unsigned int number;
+    } name;
+    TestObject* class_object;
+};
+
+struct TestNames {
+    std::vector<std::unique_ptr<TestObjectName>> storage = {};
+    std::vector<TestObjectName*> entries = {};
+    NameIndex index = {};
+
+    TestNames(std::initializer_list<std::string> names)
+    {
+        for (const auto& name : names) {
+            auto entry = std::make_unique<TestObjectName>();
+            entry->index = int(this->entries.size() << 1);
+            name.copy(entry->name, sizeof(entry->name) - 1);
+            this->entries.push_back(entry.get());
+            this->storage.push_back(std::move(entry));
+        }
+        this->index.Update(this->entries.data(), this->entries.size());
+    }
+};
+}
+
+enum : unsigned int { None, Core, Engine, Pawn, Class, Package, Function, Tick, Default__Pawn, Mesh_0 };
+
+TEST(object_index, parse_object_path)
+{
+    auto names = TestNames({ "None", "Core", "Engine", "Pawn", "Class", "Package", "Function", "Tick",
+        "Default__Pawn", "Mesh_0" });
+
+    ObjectName path[max_object_depth];
+    EXPECT_EQ(ParseObjectPath("Engine.Pawn", names.index, path), size_t(2));
+    EXPECT_TRUE(path[0].index == Engine && path[1].index == Pawn && path[1].number == 0);
+
+    EXPECT_EQ(ParseObjectPath("Engine::Pawn:Tick", names.index, path), size_t(3));
+    EXPECT_TRUE(path[2].index == Tick && path[2].number == 0);
+
+    // Numbered names, unless the whole component is a name
+    EXPECT_EQ(ParseObjectPath("Engine.Pawn_3", names.index, path), size_t(2));
+    EXPECT_TRUE(path[1].index == Pawn && path[1].number == 4);
+    EXPECT_EQ(ParseObjectPath("Mesh_0", names.index, path), size_t(1));
+    EXPECT_TRUE(path[0].index == Mesh_0 && path[0].number == 0);
+    EXPECT_EQ(ParseObjectPath("Default__Pawn_0", names.index, path), size_t(1));
+    EXPECT_TRUE(path[0].index == Default__Pawn && path[0].number == 1);
+
+    EXPECT_EQ(ParseObjectPath("", names.index, path), size_t(0));
+    EXPECT_EQ(ParseObjectPath("Engine.", names.index, path), size_t(0));
+    EXPECT_EQ(ParseObjectPath("Engine..Pawn", names.index, path), size_t(0));
+    EXPECT_EQ(ParseObjectPath("Engine.Pawn_", names.index, path), size_t(0));
+    EXPECT_EQ(ParseObjectPath("Engine.Pawn_01", names.index, path), size_t(0));
+    EXPECT_EQ(ParseObjectPath("Engine.Missing", names.index, path), size_t(0));
+
+    auto deep = std::string("Engine");
+    for (auto i = 1; i < int(max_object_depth); ++i) {
+        deep += ".Pawn";
+    }
+    EXPECT_EQ(ParseObjectPath(deep, names.index, path), max_object_depth);
+    EXPECT_EQ(ParseObjectPath(deep + ".Pawn", names.index, path), size_t(0));
+}
+
+TEST(object_index, find_by_path_and_class)
+{
+    auto names = TestNames({ "None", "Core", "Engine", "Pawn", "Class", "Package", "Function", "Tick" });
+
+    auto class_class = TestObject { nullptr, { Class, 0 }, nullptr };
+    class_class.class_object = &class_class;
+    auto package_class = TestObject { nullptr, { Package, 0 }, &class_class };
+    auto function_class = TestObject { nullptr, { Function, 0 }, &class_class };
+
+    auto engine = TestObject { nullptr, { Engine, 0 }, &package_class };
+    auto pawn = TestObject { &engine, { Pawn, 0 }, &class_class };
+    auto pawn_tick = TestObject { &pawn, { Tick, 0 }, &function_class };
+    auto pawn_3 = TestObject { &engine, { Pawn, 4 }, &package_class };
+    auto pawn_package = TestObject { &engine, { Pawn, 0 }, &package_class };
+
+    auto objects = std::vector<TestObject*> { &class_class, &package_class, &function_class, &engine, &pawn_package,
+        &pawn, &pawn_tick, nullptr, &pawn_3 };
+
+    auto index = ObjectIndex<TestObject>();
+    EXPECT_EQ(index.Update(objects.data(), objects.size()), objects.size());
+
+    auto find = [&](const char* path, int class_name = -1) -> TestObject* {
+        ObjectName components[max_object_depth];
+        auto depth = ParseObjectPath(path, names.index, components);
+        return index.Find(objects.data(), objects.size(), components, depth, class_name);
+    };
+
+    EXPECT_TRUE(find("Engine") == &engine);
+    EXPECT_TRUE(find("Engine.Pawn", Class) == &pawn);
+    EXPECT_TRUE(find("Engine.Pawn", Package) == &pawn_package);
+    EXPECT_TRUE(find("Engine.Pawn", Function) == nullptr);
+    EXPECT_TRUE(find("Engine.Pawn") == &pawn_package); // First one in the table
+    EXPECT_TRUE(find("Engine.Pawn.Tick", Function) == &pawn_tick);
+    EXPECT_TRUE(find("Engine.Pawn_3") == &pawn_3);
+    EXPECT_TRUE(find("Pawn") == nullptr);
+    EXPECT_TRUE(find("Core.Pawn") == nullptr);
+
+    // Nothing changed
+    EXPECT_EQ(index.Update(objects.data(), objects.size()), size_t(0));
+
+    // Freed slot, lookups skip it even before the next update
+    objects[4] = nullptr;
+    EXPECT_TRUE(find("Engine.Pawn") == &pawn);
+
+    // Reused slot
+    auto core = TestObject { nullptr, { Core, 0 }, &package_class };
+    objects[7] = &core;
+    EXPECT_TRUE(find("Core") == nullptr);
+    EXPECT_EQ(index.Update(objects.data(), objects.size()), size_t(2));
+    EXPECT_TRUE(find("Core") == &core);
+
+    // Grown table
+    auto core_pawn = TestObject { &core, { Pawn, 0 }, &class_class };
+    objects.push_back(&core_pawn);
+    EXPECT_EQ(index.Update(objects.data(), objects.size()), size_t(1));
+    EXPECT_TRUE(find("Core.Pawn", Class) == &core_pawn);
+    EXPECT_TRUE(find("Engine.Pawn", Class) == &pawn);
+
+    index.Clear();
+    EXPECT_TRUE(find("Engine") == nullptr);
+}
+
+TEST(object_index, rebuilds_with_many_objects)
+{
+    auto names = TestNames({ "None", "Core", "Engine", "Pawn", "Class" });
+
+    auto storage = std::vector<std::unique_ptr<TestObject>>();
+    auto objects = std::vector<TestObject*>();
+    auto engine = TestObject { nullptr, { Engine, 0 }, nullptr };
+    for (auto i = 0u; i < 10000; ++i) {
+        storage.push_back(std::make_unique<TestObject>(TestObject { &engine, { Pawn, i + 1 }, nullptr }));
+        objects.push_back(storage.back().get());
+    }
+
+    auto index = ObjectIndex<TestObject>();
+    EXPECT_EQ(index.Update(objects.data(), 5000), size_t(5000));
+    EXPECT_EQ(index.Update(objects.data(), objects.size()), size_t(5000));
+
+    auto found = 0;
+    for (auto i = 0u; i < 10000; ++i) {
+        ObjectName path[] = { { Engine, 0 }, { Pawn, i + 1 } };
+        found += index.Find(objects.data(), objects.size(), path, 2) == objects[i];
+    }
+    EXPECT_EQ(found, 10000);
+}
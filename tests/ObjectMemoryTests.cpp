@@ -0,0 +1,139 @@
+/*
+ * Copyright (c) 2022-2023, NeKz
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "../src/ObjectMemory.hpp"
+#include "Tests.hpp"
+
+namespace {
+struct TestClass {
+    const char* name;
+    int property_size;
+};
+
+struct TestObject {
+    const char* name;
+    TestObject* outer_object;
+    TestClass* class_object;
+};
+
+template <typename T> struct TestArray {
+    T* data;
+    uint32_t size;
+    uint32_t max;
+};
+
+struct TestActor {
+    TestObject object;
+    TestArray<wchar_t> tag;
+    TestArray<int> components;
+};
+
+using Memory = ObjectMemory<TestObject>;
+}
+
+static auto get_arrays(const TestClass* class_object, std::vector<Memory::OwnedArray>& arrays) -> void
+{
+    if (std::string_view(class_object->name) == "Actor") {
+        arrays.push_back({ int32_t(offsetof(TestActor, tag)), sizeof(wchar_t) });
+        arrays.push_back({ int32_t(offsetof(TestActor, components)), sizeof(int) });
+    }
+}
+
+static auto get_name = [](const auto* object) -> std::string { return object->name; };
+
+TEST(object_memory, accounts_classes_and_packages)
+{
+    auto package_class = TestClass { "Package", 0x40 };
+    auto actor_class = TestClass { "Actor", int(sizeof(TestActor)) };
+
+    auto engine = TestObject { "Engine", nullptr, &package_class };
+    auto level = TestObject { "Level", nullptr, &package_class };
+    auto world = TestObject { "World", &level, &package_class };
+
+    wchar_t tag[16] = {};
+    int components[4] = {};
+    auto a = TestActor { { "A", &world, &actor_class }, { tag, 3, 16 }, { components, 4, 4 } };
+    auto b = TestActor { { "B", &world, &actor_class }, { nullptr, 0, 8 }, { nullptr, 0, 0 } };
+    auto c = TestActor { { "C", &engine, &actor_class }, { tag, 0, 1 }, { nullptr, 0, 0 } };
+    auto no_class = TestObject { "None", nullptr, nullptr };
+
+    auto objects
+        = std::vector<TestObject*> { &engine, &level, nullptr, &world, &a.object, &b.object, &no_class, &c.object };
+
+    auto memory = Memory();
+    EXPECT_TRUE(memory.Step(objects.data(), objects.size(), objects.size(), get_arrays, get_name));
+    EXPECT_EQ(memory.GetPassCount(), size_t(1));
+
+    const auto& classes = memory.GetClasses();
+    EXPECT_EQ(classes.size(), size_t(2));
+    EXPECT_TRUE(classes[0].name == "Actor");
+    EXPECT_EQ(classes[0].instances, uint32_t(3));
+    EXPECT_EQ(classes[0].bytes, uint64_t(3 * sizeof(TestActor)));
+    // Arrays without data own nothing no matter their capacity
+    EXPECT_EQ(classes[0].heap_bytes, uint64_t(17 * sizeof(wchar_t) + 4 * sizeof(int)));
+    EXPECT_TRUE(classes[1].name == "Package");
+    EXPECT_EQ(classes[1].instances, uint32_t(3));
+    EXPECT_EQ(classes[1].heap_bytes, uint64_t(0));
+
+    const auto& packages = memory.GetPackages();
+    EXPECT_EQ(packages.size(), size_t(2));
+    EXPECT_TRUE(packages[0].name == "Level");
+    EXPECT_EQ(packages[0].instances, uint32_t(4));
+    EXPECT_EQ(packages[0].bytes, uint64_t(0x80 + 2 * sizeof(TestActor)));
+    EXPECT_EQ(packages[0].heap_bytes, uint64_t(16 * sizeof(wchar_t) + 4 * sizeof(int)));
+    EXPECT_TRUE(packages[1].name == "Engine");
+    EXPECT_EQ(packages[1].instances, uint32_t(2));
+}
+
+TEST(object_memory, spreads_passes_over_steps)
+{
+    auto level_class = TestClass { "Level", int(sizeof(TestObject)) };
+    auto actor_class = TestClass { "Actor", int(sizeof(TestActor)) };
+    auto level = TestObject { "Level", nullptr, &level_class };
+    auto a = TestActor { { "A", &level, &actor_class }, { nullptr, 0, 0 }, { nullptr, 0, 0 } };
+    auto b = TestActor { { "B", &level, &actor_class }, { nullptr, 0, 0 }, { nullptr, 0, 0 } };
+
+    auto objects = std::vector<TestObject*> { &level, &a.object, &b.object };
+
+    auto memory = Memory();
+    EXPECT_TRUE(!memory.Step(objects.data(), objects.size(), 2, get_arrays, get_name));
+    EXPECT_EQ(memory.GetCursor(), size_t(2));
+    EXPECT_TRUE(memory.GetClasses().empty());
+    EXPECT_TRUE(memory.Step(objects.data(), objects.size(), 2, get_arrays, get_name));
+    EXPECT_EQ(memory.GetCursor(), size_t(0));
+    EXPECT_EQ(memory.GetClasses()[0].instances, uint32_t(2));
+    EXPECT_EQ(memory.GetPackages()[0].instances, uint32_t(3));
+
+    // The next pass starts over and keeps the last report until it completes
+    objects.pop_back();
+    EXPECT_TRUE(!memory.Step(objects.data(), objects.size(), 1, get_arrays, get_name));
+    EXPECT_EQ(memory.GetPackages()[0].instances, uint32_t(3));
+    EXPECT_TRUE(memory.Step(objects.data(), objects.size(), 1, get_arrays, get_name));
+    EXPECT_EQ(memory.GetPackages()[0].instances, uint32_t(2));
+    EXPECT_EQ(memory.GetPassCount(), size_t(2));
+
+    // Arrays past the end of the class never get read
+    auto small_class = TestClass { "Actor", int(sizeof(TestObject)) };
+    auto small = TestObject { "Small", nullptr, &small_class };
+    objects = { &small };
+    memory.Clear();
+    EXPECT_TRUE(memory.Step(objects.data(), objects.size(), 1, get_arrays, get_name));
+    EXPECT_EQ(memory.GetClasses()[0].heap_bytes, uint64_t(0));
+}
+
+TEST(object_memory, exports_csv)
+{
+    auto quoted_class = TestClass { "Say \"Hi\"", 8 };
+    auto object = TestObject { "Object", nullptr, &quoted_class };
+    auto objects = std::vector<TestObject*> { &object };
+
+    auto memory = Memory();
+    memory.Step(objects.data(), objects.size(), 1, get_arrays, get_name);
+    EXPECT_TRUE(memory.ToCsv()
+        == "kind,name,instances,bytes,heap_bytes\n"
+           "class,\"Say \"\"Hi\"\"\",1,8,0\n"
+           "package,\"Object\",1,8,0\n");
+}
@@ -0,0 +1,137 @@
+/*
+ * Copyright (c) 2022-2023, NeKz
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "../src/PatchSet.hpp"
+#include "Tests.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+#ifdef _WIN32
+#include <windows.h>
+#define READ_ONLY PAGE_READONLY
+#else
+#include <sys/mman.h>
+#define READ_ONLY PROT_READ
+#endif
+
+static auto allocate_read_only(size_t size) -> uint8_t*
+{
+#ifdef _WIN32
+    auto pages = static_cast<uint8_t*>(VirtualAlloc(nullptr, size, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE));
+    std::memset(pages, 0xCC, size);
+    auto old_protection = DWORD(0);
+    VirtualProtect(pages, size, PAGE_READONLY, &old_protection);
+    return pages;
+#else
+    auto pages = static_cast<uint8_t*>(mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0));
+    std::memset(pages, 0xCC, size);
+    mprotect(pages, size, PROT_READ);
+    return pages;
+#endif
+}
+
+static auto release(uint8_t* pages, size_t size) -> void
+{
+#ifdef _WIN32
+    (void)size;
+    VirtualFree(pages, 0, MEM_RELEASE);
+#else
+    munmap(pages, size);
+#endif
+}
+
+static auto get_protection(const uint8_t* page) -> uint32_t
+{
+#ifdef _WIN32
+    auto info = MEMORY_BASIC_INFORMATION();
+    VirtualQuery(page, &info, sizeof(info));
+    return info.Protect;
+#else
+    auto protection = uint32_t(0);
+    auto maps = std::fopen("/proc/self/maps", "r");
+    char line[4096 + 128];
+    while (maps && std::fgets(line, sizeof(line), maps)) {
+        auto start = 0ull;
+        auto end = 0ull;
+        char permissions[5] = {};
+        if (std::sscanf(line, "%llx-%llx %4s", &start, &end, permissions) == 3 && uintptr_t(page) >= start
+            && uintptr_t(page) < end) {
+            protection |= permissions[0] == 'r' ? PROT_READ : 0;
+            protection |= permissions[1] == 'w' ? PROT_WRITE : 0;
+            protection |= permissions[2] == 'x' ? PROT_EXEC : 0;
+        }
+    }
+    if (maps) {
+        std::fclose(maps);
+    }
+    return protection;
+#endif
+}
+
+TEST(patch_set, apply_and_restore_by_page)
+{
+    auto page_size = Memory::PatchSet::GetPageSize();
+    auto pages = allocate_read_only(3 * page_size);
+    auto base = uintptr_t(pages);
+
+    auto set = Memory::PatchSet();
+    EXPECT_TRUE(set.Add(base + 0x10, { 0x90, 0x90 }));
+    EXPECT_TRUE(set.Add(base + 0x20, { 0xE9, 0x00, 0x00, 0x00, 0x00 }));
+    EXPECT_TRUE(set.Add(base + page_size - 2, { 0x01, 0x02, 0x03, 0x04 })); // Crosses into the second page
+    EXPECT_TRUE(set.Add(base + 2 * page_size + 8, { 0xC3 }));
+    EXPECT_TRUE(!set.Add(base + 0x11, { 0x00 })); // Overlaps the first patch
+    EXPECT_EQ(set.size(), size_t(4));
+
+    EXPECT_TRUE(set.Apply());
+    EXPECT_TRUE(set.IsApplied());
+    EXPECT_TRUE(!set.Add(base + 0x100, { 0x00 }));
+
+    EXPECT_EQ(pages[0x10], uint8_t(0x90));
+    EXPECT_EQ(pages[0x20], uint8_t(0xE9));
+    EXPECT_EQ(pages[page_size + 1], uint8_t(0x04));
+    EXPECT_EQ(pages[2 * page_size + 8], uint8_t(0xC3));
+    EXPECT_EQ(set.at(2).original, std::vector<uint8_t>(4, 0xCC));
+
+    // Three pages with the same protection are one run: one change to make them writable, one to restore
+    EXPECT_EQ(set.GetStats().pages, size_t(3));
+    EXPECT_EQ(set.GetStats().protection_changes, size_t(2));
+    EXPECT_EQ(get_protection(pages), uint32_t(READ_ONLY));
+    EXPECT_EQ(get_protection(pages + 2 * page_size), uint32_t(READ_ONLY));
+
+    EXPECT_TRUE(set.Restore());
+    EXPECT_TRUE(!set.IsApplied());
+    EXPECT_TRUE(std::all_of(pages, pages + 3 * page_size, [](uint8_t value) { return value == 0xCC; }));
+    EXPECT_EQ(get_protection(pages + page_size), uint32_t(READ_ONLY));
+
+    EXPECT_TRUE(set.Clear());
+    EXPECT_EQ(set.size(), size_t(0));
+
+    release(pages, 3 * page_size);
+}
+
+TEST(patch_set, rollback_on_unmapped_page)
+{
+    auto page_size = Memory::PatchSet::GetPageSize();
+    auto pages = allocate_read_only(2 * page_size);
+    auto unmapped = allocate_read_only(page_size);
+    release(unmapped, page_size);
+
+    auto set = Memory::PatchSet();
+    EXPECT_TRUE(set.Add(uintptr_t(pages) + 4, { 0x90 }));
+    EXPECT_TRUE(set.Add(uintptr_t(pages) + page_size + 4, { 0x90 }));
+    EXPECT_TRUE(set.Add(uintptr_t(unmapped) + 4, { 0x90 }));
+
+    // Nothing gets written and the mapped pages keep their protection
+    EXPECT_TRUE(!set.Apply());
+    EXPECT_TRUE(!set.IsApplied());
+    EXPECT_EQ(pages[4], uint8_t(0xCC));
+    EXPECT_EQ(pages[page_size + 4], uint8_t(0xCC));
+    EXPECT_EQ(get_protection(pages), uint32_t(READ_ONLY));
+    EXPECT_TRUE(!set.Restore());
+
+    release(pages, 2 * page_size);
+}
@@ -0,0 +1,91 @@
+/*
+ * Copyright (c) 2022-2023, NeKz
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "../src/Memory.hpp"
+#include "Tests.hpp"
+
+#ifndef _WIN32
+#include <sys/mman.h>
+#endif
+
+static auto allocate_pages(size_t count) -> uint8_t*
+{
+#ifdef _WIN32
+    return static_cast<uint8_t*>(VirtualAlloc(nullptr, count * 0x1000, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE));
+#else
+    auto pages = mmap(nullptr, count * 0x1000, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    return pages != MAP_FAILED ? static_cast<uint8_t*>(pages) : nullptr;
+#endif
+}
+
+static auto protect_page(uint8_t* page) -> void
+{
+#ifdef _WIN32
+    auto old_protection = DWORD(0);
+    VirtualProtect(page, 0x1000, PAGE_NOACCESS, &old_protection);
+#else
+    mprotect(page, 0x1000, PROT_NONE);
+#endif
+}
+
+static auto free_pages(uint8_t* pages, size_t count) -> void
+{
+#ifdef _WIN32
+    (void)count;
+    VirtualFree(pages, 0, MEM_RELEASE);
+#else
+    munmap(pages, count * 0x1000);
+#endif
+}
+
+TEST(region_map, readable_memory)
+{
+    auto local = 42;
+    auto heap = std::vector<int>(64, 7);
+
+    EXPECT_TRUE(Memory::IsReadable(&local));
+    EXPECT_TRUE(Memory::IsReadable(uintptr_t(heap.data()), heap.size() * sizeof(int)));
+    EXPECT_TRUE(!Memory::IsReadable(static_cast<int*>(nullptr)));
+    EXPECT_TRUE(!Memory::IsReadable(uintptr_t(0x1234)));
+    EXPECT_TRUE(!Memory::IsReadable(~uintptr_t(0) - 2, 8));
+
+    auto value = 0;
+    EXPECT_TRUE(Memory::TryDeref(uintptr_t(&local), &value));
+    EXPECT_EQ(value, 42);
+
+    auto pointer = &local;
+    value = 0;
+    EXPECT_TRUE(Memory::TryDerefDeref(uintptr_t(&pointer), &value));
+    EXPECT_EQ(value, 42);
+
+    auto bad_pointer = reinterpret_cast<int*>(0x10);
+    EXPECT_TRUE(!Memory::TryDerefDeref(uintptr_t(&bad_pointer), &value));
+}
+
+TEST(region_map, protected_and_freed_pages)
+{
+    Memory::RefreshRegions();
+    EXPECT_TRUE(Memory::GetRegionCount() != 0);
+
+    // Mapped after the refresh, has to be picked up on the first miss
+    auto pages = allocate_pages(3);
+    EXPECT_TRUE(pages != nullptr);
+    EXPECT_TRUE(Memory::IsReadable(uintptr_t(pages), 3 * 0x1000));
+
+    protect_page(pages + 0x1000);
+    Memory::RefreshRegions();
+
+    EXPECT_TRUE(Memory::IsReadable(uintptr_t(pages), 0x1000));
+    EXPECT_TRUE(Memory::IsReadable(uintptr_t(pages + 0x2000), 0x1000));
+    EXPECT_TRUE(!Memory::IsReadable(uintptr_t(pages + 0x1000)));
+    EXPECT_TRUE(!Memory::IsReadable(uintptr_t(pages + 0x1000 - 4), 8));
+
+    free_pages(pages, 3);
+    Memory::RefreshRegions();
+
+    EXPECT_TRUE(!Memory::IsReadable(uintptr_t(pages)));
+    EXPECT_TRUE(!Memory::IsReadable(uintptr_t(pages + 0x2000)));
+}
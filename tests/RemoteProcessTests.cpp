@@ -0,0 +1,139 @@
+/*
+ * Copyright (c) 2022-2023, NeKz
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "../src/RemoteProcess.hpp"
+#include "Tests.hpp"
+
+#ifndef _WIN32
+#include <cstring>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+/*
+ * Child process with three pages: a marker in the first one, an unreadable
+ * page in the middle and a signature in the last one. The child only writes
+ * after fork so the parent can only find the data by reading the child.
+ */
+struct Child {
+    pid_t pid = 0;
+    uintptr_t pages = 0;
+    int done[2] = { -1, -1 };
+
+    auto start() -> bool
+    {
+        int ready[2];
+        if (pipe(ready) || pipe(this->done)) {
+            return false;
+        }
+
+        this->pid = fork();
+        if (this->pid == 0) {
+            close(ready[0]);
+            close(this->done[1]);
+
+            auto memory = static_cast<uint8_t*>(
+                mmap(nullptr, 3 * 0x1000, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0));
+            std::memcpy(memory + 0x10, "tem remote marker", 18);
+
+            const uint8_t signature[] = { 0xE8, 0x11, 0x22, 0x33, 0x44, 0x8B, 0x0D };
+            std::memcpy(memory + 0x2000 + 0x40, signature, sizeof(signature));
+
+            // Across the boundary to the unreadable page, must never match
+            std::memcpy(memory + 0x1000 - 3, signature, 3);
+            mprotect(memory + 0x1000, 0x1000, PROT_NONE);
+
+            auto address = uintptr_t(memory);
+            write(ready[1], &address, sizeof(address));
+
+            char byte;
+            read(this->done[0], &byte, 1);
+            _exit(0);
+        }
+
+        close(ready[1]);
+        close(this->done[0]);
+        auto result = read(ready[0], &this->pages, sizeof(this->pages)) == sizeof(this->pages);
+        close(ready[0]);
+        return result;
+    }
+
+    ~Child()
+    {
+        if (this->pid > 0) {
+            close(this->done[1]);
+            waitpid(this->pid, nullptr, 0);
+        }
+    }
+};
+
+TEST(remote_process, read_child_process)
+{
+    auto child = Child();
+    EXPECT_TRUE(child.start());
+
+    auto process = Memory::RemoteProcess();
+    EXPECT_TRUE(process.Open(child.pid));
+
+    char marker[18] = {};
+    EXPECT_TRUE(process.Read(child.pages + 0x10, marker, sizeof(marker)));
+    EXPECT_EQ(std::string(marker), std::string("tem remote marker"));
+
+    // Second read of the page is served by the cache
+    auto calls = process.GetStats().system_calls;
+    auto value = uint32_t();
+    EXPECT_TRUE(process.Read(child.pages + 0x14, &value));
+    EXPECT_EQ(process.GetStats().system_calls, calls);
+
+    EXPECT_TRUE(!process.Read(child.pages + 0x1000, &value));
+    EXPECT_TRUE(!process.Read(child.pages + 0xFFE, &value));
+
+    auto first = uint8_t();
+    auto last = uint8_t();
+    auto hidden = uint8_t();
+    auto requests = std::vector<Memory::RemoteProcess::ReadRequest> {
+        { child.pages + 0x10, &first, 1, false },
+        { child.pages + 0x2040, &last, 1, false },
+        { child.pages + 0x1800, &hidden, 1, false },
+    };
+    EXPECT_TRUE(!process.ReadBatch(requests));
+    EXPECT_TRUE(requests[0].succeeded && requests[1].succeeded && !requests[2].succeeded);
+    EXPECT_EQ(first, uint8_t('t'));
+    EXPECT_EQ(last, uint8_t(0xE8));
+    EXPECT_TRUE(process.GetStats().unreadable_pages != 0);
+}
+
+TEST(remote_process, scan_child_process)
+{
+    auto child = Child();
+    EXPECT_TRUE(child.start());
+
+    auto process = Memory::RemoteProcess();
+    EXPECT_TRUE(process.Open(child.pid));
+
+    auto signature = Scanner::Signature();
+    Scanner::Parse("E8 ? ? ? ? 8B 0D", &signature);
+
+    auto start = child.pages;
+    auto end = child.pages + 3 * 0x1000;
+    EXPECT_EQ(process.Find(start, end, signature.view()), child.pages + 0x2040);
+    EXPECT_EQ(process.FindAll(start, end, signature.view()), std::vector<uintptr_t> { child.pages + 0x2040 });
+    EXPECT_EQ(process.Find(start, child.pages + 0x2046, signature.view()), uintptr_t(0));
+
+    auto modules = process.GetModules();
+    EXPECT_TRUE(!modules.empty());
+
+    auto libc = Memory::ModuleInfo();
+    EXPECT_TRUE(process.TryGetModule("libc.so.6", &libc));
+    EXPECT_TRUE(!libc.sections.empty());
+
+    // Same module mapped in the parent, code has to match
+    auto local = Memory::ModuleInfo();
+    EXPECT_TRUE(Memory::TryGetModule("libc.so.6", &local));
+    EXPECT_EQ(process.Scan("libc.so.6", "48 8B ? ? 48", 0, Memory::Section::Code),
+        Memory::Scan("libc.so.6", "48 8B ? ? 48", 0, Memory::Section::Code));
+}
+#endif
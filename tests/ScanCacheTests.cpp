@@ -0,0 +1,83 @@
+/*
+ * Copyright (c) 2022-2023, NeKz
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "../src/ScanCache.hpp"
+#include "../src/Scanner.hpp"
+#include "Tests.hpp"
+#include <cstdio>
+
+TEST(scan_cache, signature_hash)
+{
+    auto a = Scanner::Signature();
+    auto b = Scanner::Signature();
+    auto c = Scanner::Signature();
+    Scanner::Parse("E8 ? ? ? ? 8B", &a);
+    Scanner::Parse("E8 ? ? ? ? 8B", &b);
+    Scanner::Parse("E8 ? ? ? ? ? 8B", &c);
+
+    EXPECT_EQ(ScanCache::HashSignature(a.view()), ScanCache::HashSignature(b.view()));
+    EXPECT_TRUE(ScanCache::HashSignature(a.view()) != ScanCache::HashSignature(c.view()));
+    EXPECT_TRUE(ScanCache::HashSignature(a.view(), 0) != ScanCache::HashSignature(a.view(), 1));
+}
+
+TEST(scan_cache, lookup_and_fingerprint_mismatch)
+{
+    const auto fingerprint = ScanCache::Fingerprint { 0x4CF3A1B2, 0x02400000, 0x0231D5E4 };
+    const auto updated = ScanCache::Fingerprint { 0x4D0C7E10, 0x02400000, 0x0231F0A8 };
+
+    ScanCache::Clear();
+    ScanCache::ResetStats();
+
+    auto rva = uintptr_t();
+    EXPECT_TRUE(!ScanCache::Lookup("GridGame.exe", fingerprint, 0x1234, &rva));
+
+    ScanCache::Store("GridGame.exe", fingerprint, 0x1234, 0xA20BD0);
+    EXPECT_TRUE(ScanCache::Lookup("GridGame.exe", fingerprint, 0x1234, &rva));
+    EXPECT_EQ(rva, uintptr_t(0xA20BD0));
+
+    EXPECT_TRUE(!ScanCache::Lookup("GridGame.exe", updated, 0x1234, &rva));
+    EXPECT_TRUE(!ScanCache::Lookup("xlive.dll", fingerprint, 0x1234, &rva));
+    EXPECT_TRUE(!ScanCache::Lookup("GridGame.exe", fingerprint, 0x4321, &rva));
+
+    auto stats = ScanCache::GetStats();
+    EXPECT_EQ(stats.hits, size_t(1));
+    EXPECT_EQ(stats.misses, size_t(4));
+    EXPECT_EQ(stats.stores, size_t(1));
+    EXPECT_EQ(stats.entries, size_t(1));
+
+    ScanCache::SetEnabled(false);
+    EXPECT_TRUE(!ScanCache::Lookup("GridGame.exe", fingerprint, 0x1234, &rva));
+    ScanCache::SetEnabled(true);
+
+    ScanCache::Clear();
+}
+
+TEST(scan_cache, save_and_load)
+{
+    const auto path = std::string("tem_scan_cache_test.txt");
+    const auto fingerprint = ScanCache::Fingerprint { 0x4CF3A1B2, 0x02400000, 0x0231D5E4 };
+
+    ScanCache::Clear();
+    ScanCache::Store("GridGame.exe", fingerprint, 0xFFEEDDCCBBAA9988, 0x1439DF0);
+    ScanCache::Store("xlive.dll", fingerprint, 0x1, 0xF370C);
+    EXPECT_TRUE(ScanCache::Save(path));
+
+    ScanCache::Clear();
+    EXPECT_TRUE(ScanCache::Load(path));
+    EXPECT_EQ(ScanCache::GetStats().entries, size_t(2));
+
+    auto rva = uintptr_t();
+    EXPECT_TRUE(ScanCache::Lookup("GridGame.exe", fingerprint, 0xFFEEDDCCBBAA9988, &rva));
+    EXPECT_EQ(rva, uintptr_t(0x1439DF0));
+    EXPECT_TRUE(ScanCache::Lookup("xlive.dll", fingerprint, 0x1, &rva));
+    EXPECT_EQ(rva, uintptr_t(0xF370C));
+
+    std::remove(path.c_str());
+    EXPECT_TRUE(!ScanCache::Load(path));
+
+    ScanCache::Clear();
+    ScanCache::ResetStats();
+}
@@ -0,0 +1,354 @@
+/*
+ * Copyright (c) 2022-2023, NeKz
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "../src/Memory.hpp"
+#include "../src/Scanner.hpp"
+#include "Tests.hpp"
+#include <random>
+
+static const Scanner::Backend all_backends[] = {
+    Scanner::Backend::Scalar,
+    Scanner::Backend::SSE2,
+    Scanner::Backend::AVX2,
+};
+
+static auto parse(const char* text) -> Scanner::Signature
+{
+    auto signature = Scanner::Signature();
+    Scanner::Parse(text, &signature);
+    return signature;
+}
+
+// Straightforward byte by byte scan every backend gets compared against.
+static auto reference_find_all(const std::vector<uint8_t>& buffer, const Scanner::Signature& signature)
+    -> std::vector<size_t>
+{
+    auto result = std::vector<size_t>();
+    for (auto i = size_t(0); i + signature.bytes.size() <= buffer.size(); ++i) {
+        auto matches = true;
+        for (auto j = size_t(0); j < signature.bytes.size() && matches; ++j) {
+            matches = !signature.mask[j] || buffer[i + j] == signature.bytes[j];
+        }
+        if (matches) {
+            result.push_back(i);
+        }
+    }
+    return result;
+}
+
+static auto find_all(const std::vector<uint8_t>& buffer, const Scanner::Signature& signature, Scanner::Backend backend)
+    -> std::vector<size_t>
+{
+    auto result = std::vector<size_t>();
+    auto start = buffer.data();
+    auto end = buffer.data() + buffer.size();
+
+    while (auto match = Scanner::Find(start, end, signature.view(), backend)) {
+        result.push_back(size_t(match - buffer.data()));
+        start = match + 1;
+    }
+    return result;
+}
+
+TEST(scanner_parse, valid_signatures)
+{
+    auto signature = parse("E8 ? ? ?? ? 8b 05");
+
+    EXPECT_EQ(signature.bytes.size(), 7u);
+    EXPECT_EQ(int(signature.bytes[0]), 0xE8);
+    EXPECT_EQ(int(signature.mask[1]), 0x00);
+    EXPECT_EQ(int(signature.mask[3]), 0x00);
+    EXPECT_EQ(int(signature.bytes[5]), 0x8B);
+    EXPECT_EQ(int(signature.mask[6]), 0xFF);
+
+    // 0x05 is the rarest fixed byte
+    EXPECT_EQ(signature.anchor, 6u);
+}
+
+TEST(scanner_parse, malformed_signatures)
+{
+    auto signature = Scanner::Signature();
+
+    EXPECT_TRUE(!Scanner::Parse("", &signature));
+    EXPECT_TRUE(!Scanner::Parse("? ? ?", &signature));
+    EXPECT_TRUE(!Scanner::Parse("E8 0", &signature));
+    EXPECT_TRUE(!Scanner::Parse("E8 XY", &signature));
+    EXPECT_TRUE(!Scanner::Parse("E80", &signature));
+    EXPECT_TRUE(!Scanner::Parse(nullptr, &signature));
+}
+
+TEST(scanner_find, overlapping_and_partial_matches)
+{
+    auto buffer = std::vector<uint8_t>(100, 0x90);
+    buffer[40] = 0xAA;
+    buffer[41] = 0xAA;
+    buffer[42] = 0xBB;
+    buffer[43] = 0xAA;
+    buffer[44] = 0xBB;
+
+    auto signature = parse("AA BB");
+
+    for (auto backend : all_backends) {
+        if (!Scanner::IsSupported(backend)) {
+            continue;
+        }
+
+        EXPECT_EQ(find_all(buffer, signature, backend), std::vector<size_t>({ 41, 43 }));
+    }
+
+    auto repeated = std::vector<uint8_t>(64, 0xAA);
+    auto signature2 = parse("AA AA AA");
+
+    for (auto backend : all_backends) {
+        if (!Scanner::IsSupported(backend)) {
+            continue;
+        }
+
+        EXPECT_EQ(find_all(repeated, signature2, backend).size(), 62u);
+    }
+}
+
+TEST(scanner_find, match_at_buffer_edges)
+{
+    auto buffer = std::vector<uint8_t>(77, 0x00);
+    buffer[0] = 0x12;
+    buffer[1] = 0x34;
+    buffer[75] = 0x12;
+    buffer[76] = 0x34;
+
+    auto signature = parse("12 34");
+
+    for (auto backend : all_backends) {
+        if (!Scanner::IsSupported(backend)) {
+            continue;
+        }
+
+        EXPECT_EQ(find_all(buffer, signature, backend), std::vector<size_t>({ 0, 75 }));
+
+        // Truncated match at the end must not be reported
+        auto truncated = std::vector<uint8_t>(buffer.begin(), buffer.end() - 1);
+        EXPECT_EQ(find_all(truncated, signature, backend), std::vector<size_t>({ 0 }));
+    }
+}
+
+TEST(scanner_find, random_buffers_match_reference)
+{
+    auto rng = std::mt19937(1337);
+    auto byte = std::uniform_int_distribution<int>(0, 3);
+
+    const char* signatures[] = {
+        "01",
+        "01 02",
+        "00 ? 02",
+        "? 03 ? ? 01",
+        "01 02 03 00 01 02 03 00 01 02 03 00 01 02 03 00 01 02 03",
+        "02 ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? 02",
+    };
+
+    for (auto size : { 0, 1, 15, 16, 17, 31, 32, 33, 63, 64, 65, 1000, 4099 }) {
+        auto buffer = std::vector<uint8_t>(size);
+        for (auto& value : buffer) {
+            value = uint8_t(byte(rng));
+        }
+
+        for (auto text : signatures) {
+            auto signature = parse(text);
+            auto expected = reference_find_all(buffer, signature);
+
+            for (auto backend : all_backends) {
+                if (!Scanner::IsSupported(backend)) {
+                    continue;
+                }
+
+                EXPECT_EQ(find_all(buffer, signature, backend), expected);
+            }
+        }
+    }
+}
+
+TEST(memory_find_address, text_signature)
+{
+    auto buffer = std::vector<uint8_t>(256, 0xCC);
+    buffer[200] = 0xE8;
+    buffer[205] = 0x8B;
+
+    auto start = uintptr_t(buffer.data());
+    auto end = start + buffer.size();
+
+    EXPECT_EQ(Memory::FindAddress(start, end, "E8 ? ? ? ? 8B"), start + 200);
+    EXPECT_EQ(Memory::FindAddress(start, end, "E8 ? ? ? ? 8C"), uintptr_t(0));
+    EXPECT_EQ(Memory::FindAddress(start, end, "invalid"), uintptr_t(0));
+}
+
+TEST(static_signature, decoded_at_compile_time)
+{
+    constexpr auto signature = Scanner::StaticSignature("E8 ? ? ?? ? 8b 05");
+
+    static_assert(signature.size == 7);
+    static_assert(signature.bytes[0] == 0xE8 && signature.mask[0] == 0xFF);
+    static_assert(signature.bytes[3] == 0x00 && signature.mask[3] == 0x00);
+    static_assert(signature.anchor == 6);
+
+    auto runtime = parse("E8 ? ? ?? ? 8b 05");
+    auto view = signature.view();
+
+    EXPECT_EQ(view.size, runtime.bytes.size());
+    EXPECT_EQ(view.anchor, runtime.anchor);
+    EXPECT_EQ(view.guard, runtime.guard);
+    EXPECT_EQ(std::vector<uint8_t>(view.bytes, view.bytes + view.size), runtime.bytes);
+    EXPECT_EQ(std::vector<uint8_t>(view.mask, view.mask + view.size), runtime.mask);
+}
+
+TEST(static_signature, pattern_macro)
+{
+    PATTERN(pattern, "E8 ? ? ? ? 8B", 1, 5);
+
+    auto buffer = std::vector<uint8_t>(128, 0x90);
+    buffer[100] = 0xE8;
+    buffer[105] = 0x8B;
+
+    auto start = uintptr_t(buffer.data());
+    auto end = start + buffer.size();
+
+    EXPECT_EQ(pattern.binary.size, 6u);
+    EXPECT_EQ(pattern.offsets.size(), 2u);
+    EXPECT_EQ(Memory::FindAddress(start, end, pattern.binary), start + 100);
+}
+
+TEST(signature_set, matches_single_signature_scans)
+{
+    auto rng = std::mt19937(42);
+    auto byte = std::uniform_int_distribution<int>(0, 3);
+
+    auto buffer = std::vector<uint8_t>(5000);
+    for (auto& value : buffer) {
+        value = uint8_t(byte(rng));
+    }
+
+    auto texts = std::vector<const char*>({
+        "01",
+        "01 02",
+        "03 ? 02",
+        "? 03 ? ? 01",
+        "00 01 02 03",
+        "00 01 02 03",
+        "02 ? ? ? ? ? ? ? ? ? 02",
+        "02 02 02",
+        "? ? 01 01",
+        "03 ? ? 03 03 ? 00",
+        "03 ? 01 ? 00",
+    });
+
+    // Small sets are scanned per signature, make sure the sweep is tested too
+    EXPECT_TRUE(texts.size() >= Scanner::SignatureSet::min_batch_size);
+
+    auto signatures = std::vector<Scanner::Signature>();
+    auto views = std::vector<Scanner::SignatureView>();
+    for (auto text : texts) {
+        signatures.push_back(parse(text));
+    }
+    for (auto& signature : signatures) {
+        views.push_back(signature.view());
+    }
+
+    auto set = Scanner::SignatureSet(views);
+    auto results = set.FindAll(buffer.data(), buffer.data() + buffer.size());
+
+    EXPECT_EQ(results.size(), texts.size());
+
+    for (auto i = size_t(0); i < signatures.size(); ++i) {
+        auto expected = reference_find_all(buffer, signatures[i]);
+        auto actual = std::vector<size_t>();
+        for (auto match : results[i]) {
+            actual.push_back(size_t(match - buffer.data()));
+        }
+
+        EXPECT_EQ(actual, expected);
+    }
+
+    // Visitor sees the same matches and can stop the sweep
+    auto visited = size_t(0);
+    auto count = [&visited](size_t, const uint8_t*) {
+        ++visited;
+        return true;
+    };
+    auto counter = Scanner::MatchCallback(count);
+    EXPECT_TRUE(set.ForEachMatch(buffer.data(), buffer.data() + buffer.size(), counter));
+
+    auto expected = size_t(0);
+    for (auto& matches : results) {
+        expected += matches.size();
+    }
+    EXPECT_EQ(visited, expected);
+
+    auto stop = [](size_t, const uint8_t*) { return false; };
+    auto stopper = Scanner::MatchCallback(stop);
+    EXPECT_TRUE(!set.ForEachMatch(buffer.data(), buffer.data() + buffer.size(), stopper));
+}
+
+TEST(parallel_scan, matches_single_threaded_scan)
+{
+    auto rng = std::mt19937(7);
+    auto byte = std::uniform_int_distribution<int>(0, 255);
+
+    auto buffer = std::vector<uint8_t>(Scanner::chunk_size * 5 + 123);
+    for (auto& value : buffer) {
+        value = uint8_t(byte(rng));
+    }
+
+    auto texts = std::vector<const char*>({
+        "11 22 33",
+        "11 ? ? 44 55",
+        "AA ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? ? BB",
+        "11",
+        "12 34",
+        "56 ? 78",
+        "9A BC DE",
+        "F0 ? ? F1",
+    });
+
+    auto signatures = std::vector<Scanner::Signature>();
+    auto views = std::vector<Scanner::SignatureView>();
+    for (auto text : texts) {
+        signatures.push_back(parse(text));
+    }
+    for (auto& signature : signatures) {
+        views.push_back(signature.view());
+    }
+
+    // Put matches right across every chunk boundary
+    for (auto chunk = size_t(1); chunk < 6; ++chunk) {
+        auto boundary = chunk * Scanner::chunk_size;
+        buffer[boundary - 1] = 0x11;
+        buffer[boundary] = 0x22;
+        buffer[boundary + 1] = 0x33;
+        if (boundary + 20 < buffer.size()) {
+            buffer[boundary - 11] = 0xAA;
+            buffer[boundary + 20] = 0xBB;
+        }
+    }
+
+    auto start = buffer.data();
+    auto end = buffer.data() + buffer.size();
+
+    for (auto& view : views) {
+        auto expected = Scanner::FindAll(start, end, view, 1);
+
+        EXPECT_EQ(Scanner::FindAll(start, end, view, 4), expected);
+        EXPECT_EQ(Scanner::Find(start, end, view, Scanner::GetBackend(), 4), expected.empty() ? nullptr : expected[0]);
+    }
+
+    auto set = Scanner::SignatureSet(views);
+    auto expected = set.FindAll(start, end, 1);
+    auto actual = set.FindAll(start, end, 4);
+
+    EXPECT_EQ(expected[0].size(), 5u);
+    EXPECT_EQ(actual.size(), expected.size());
+
+    for (auto i = size_t(0); i < expected.size(); ++i) {
+        EXPECT_EQ(actual[i], expected[i]);
+    }
+}
@@ -0,0 +1,178 @@
+/*
+ * Copyright (c) 2022-2023, NeKz
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "../src/SnapshotDiff.hpp"
+#include "Tests.hpp"
+#include <algorithm>
+
+using Snapshot::none;
+
+namespace {
+struct TestObject {
+    const char* name;
+    uint32_t number;
+    uint32_t outer;
+    uint32_t class_object;
+    uint32_t property_size;
+};
+}
+
+// Every object gets its own name index, equal strings still have to match
+static auto make_snapshot(const std::vector<TestObject>& objects) -> std::vector<uint8_t>
+{
+    auto writer = Snapshot::Writer();
+    for (auto i = uint32_t(0); i < objects.size(); ++i) {
+        const auto& object = objects[i];
+        if (!object.name) {
+            continue;
+        }
+        writer.SetName(i + 7, object.name);
+        writer.SetObject(i,
+            { 0x1000 + uint64_t(i) * 0x100, i + 7, object.number, object.outer, object.class_object, none, none,
+                none, object.property_size });
+    }
+    return writer.Serialize();
+}
+
+TEST(snapshot_diff, path_hashes)
+{
+    auto before_data = make_snapshot({
+        { "Engine", 0, none, none, 0 },
+        { "Pawn", 0, 0, none, 0 },
+        { "Pawn", 1, 0, none, 0 },
+        { "Health", 0, 1, none, 0 },
+    });
+    // Same paths at other indices
+    auto after_data = make_snapshot({
+        { nullptr, 0, none, none, 0 },
+        { "Health", 0, 3, none, 0 },
+        { "Engine", 0, none, none, 0 },
+        { "Pawn", 0, 2, none, 0 },
+        { "Pawn", 0, 1, none, 0 },
+    });
+
+    auto before = Snapshot::Reader();
+    auto after = Snapshot::Reader();
+    EXPECT_TRUE(before.Open(before_data.data(), before_data.size()));
+    EXPECT_TRUE(after.Open(after_data.data(), after_data.size()));
+
+    auto old_hashes = Snapshot::GetPathHashes(before);
+    auto new_hashes = Snapshot::GetPathHashes(after);
+    EXPECT_EQ(new_hashes[0], uint64_t(0));
+    EXPECT_EQ(old_hashes[0], new_hashes[2]);
+    EXPECT_EQ(old_hashes[1], new_hashes[3]);
+    EXPECT_EQ(old_hashes[3], new_hashes[1]);
+    EXPECT_TRUE(old_hashes[1] != old_hashes[2]);
+    EXPECT_TRUE(new_hashes[4] != new_hashes[1]);
+}
+
+TEST(snapshot_diff, created_destroyed_and_reclassified)
+{
+    enum : uint32_t { Core, Class, Engine, Pawn, Actor };
+    auto before_data = make_snapshot({
+        { "Core", 0, none, none, 0 },
+        { "Class", 0, Core, Class, 0x100 },
+        { "Engine", 0, none, none, 0 },
+        { "Pawn", 0, Engine, Class, 0x400 },
+        { "Actor", 0, Engine, Class, 0x200 },
+        { "Map", 0, none, none, 0 },
+        { "Pawn", 1, 5, Pawn, 0 },
+        { "Pawn", 2, 5, Pawn, 0 },
+        { "Light", 0, 5, Actor, 0 },
+    });
+    auto after_data = make_snapshot({
+        { "Core", 0, none, none, 0 },
+        { "Class", 0, Core, Class, 0x100 },
+        { "Engine", 0, none, none, 0 },
+        { "Pawn", 0, Engine, Class, 0x400 },
+        { "Actor", 0, Engine, Class, 0x200 },
+        { "Map", 0, none, none, 0 },
+        { "Pawn", 1, 5, Pawn, 0 },
+        { "Light", 0, 5, Pawn, 0 },
+        { "Other", 0, none, none, 0 },
+        { "Pawn", 1, 8, Pawn, 0 },
+        { "Pawn", 2, 8, Pawn, 0 },
+    });
+
+    auto before = Snapshot::Reader();
+    auto after = Snapshot::Reader();
+    EXPECT_TRUE(before.Open(before_data.data(), before_data.size()));
+    EXPECT_TRUE(after.Open(after_data.data(), after_data.size()));
+
+    auto diff = Snapshot::Diff(before, after);
+    EXPECT_EQ(diff.unchanged, size_t(7));
+    EXPECT_EQ(diff.changes.size(), size_t(5));
+
+    auto created = std::vector<std::string>();
+    auto destroyed = std::vector<std::string>();
+    auto reclassified = std::vector<std::string>();
+    for (const auto& change : diff.changes) {
+        switch (change.kind) {
+        case Snapshot::ChangeKind::Created:
+            EXPECT_EQ(change.before, none);
+            created.push_back(after.GetPath(change.after));
+            break;
+        case Snapshot::ChangeKind::Destroyed:
+            EXPECT_EQ(change.after, none);
+            destroyed.push_back(before.GetPath(change.before));
+            break;
+        case Snapshot::ChangeKind::Reclassified:
+            reclassified.push_back(before.GetPath(change.before) + " " + after.GetPath(change.after));
+            break;
+        }
+    }
+    std::sort(created.begin(), created.end());
+    EXPECT_TRUE(created == (std::vector<std::string> { "Other", "Other.Pawn_0", "Other.Pawn_1" }));
+    EXPECT_TRUE(destroyed == std::vector<std::string> { "Map.Pawn_1" });
+    EXPECT_TRUE(reclassified == std::vector<std::string> { "Map.Light Map.Light" });
+
+    // Pawn gained two instances and one reclassified from Actor
+    EXPECT_EQ(diff.classes.size(), size_t(2));
+    const auto& pawn = diff.classes[0];
+    EXPECT_TRUE(after.GetPath(pawn.after) == "Engine.Pawn");
+    EXPECT_EQ(pawn.before, uint32_t(Pawn));
+    EXPECT_EQ(pawn.created, uint32_t(2));
+    EXPECT_EQ(pawn.destroyed, uint32_t(1));
+    EXPECT_EQ(pawn.reclassified, uint32_t(1));
+    EXPECT_EQ(pawn.created_bytes, uint64_t(3 * 0x400));
+    EXPECT_EQ(pawn.destroyed_bytes, uint64_t(0x400 + 0x200));
+
+    const auto& other = diff.packages[0];
+    EXPECT_TRUE(after.GetPath(other.after) == "Other");
+    EXPECT_EQ(other.before, none);
+    EXPECT_EQ(other.created, uint32_t(3));
+    EXPECT_EQ(other.created_bytes, uint64_t(2 * 0x400));
+
+    const auto& map = diff.packages[1];
+    EXPECT_TRUE(before.GetPath(map.before) == "Map");
+    EXPECT_EQ(map.after, uint32_t(5));
+    EXPECT_EQ(map.destroyed, uint32_t(1));
+    EXPECT_EQ(map.reclassified, uint32_t(1));
+}
+
+TEST(snapshot_diff, identical_and_empty_snapshots)
+{
+    auto data = make_snapshot({
+        { "Engine", 0, none, none, 0 },
+        { "Pawn", 0, 0, none, 0 },
+    });
+    auto empty_data = Snapshot::Writer().Serialize();
+
+    auto snapshot = Snapshot::Reader();
+    auto empty = Snapshot::Reader();
+    EXPECT_TRUE(snapshot.Open(data.data(), data.size()));
+    EXPECT_TRUE(empty.Open(empty_data.data(), empty_data.size()));
+
+    auto same = Snapshot::Diff(snapshot, snapshot);
+    EXPECT_EQ(same.unchanged, size_t(2));
+    EXPECT_TRUE(same.changes.empty());
+    EXPECT_TRUE(same.classes.empty());
+
+    auto everything = Snapshot::Diff(empty, snapshot);
+    EXPECT_EQ(everything.changes.size(), size_t(2));
+    EXPECT_EQ(everything.packages.size(), size_t(1));
+    EXPECT_EQ(everything.packages[0].created, uint32_t(2));
+}
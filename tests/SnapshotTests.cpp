@@ -0,0 +1,160 @@
+/*
+ * Copyright (c) 2022-2023, NeKz
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "../src/Snapshot.hpp"
+#include "Tests.hpp"
+#include <cstdio>
+#include <cstring>
+
+using Snapshot::none;
+
+enum : uint32_t { None, Core, Engine, Class, Package, Pawn, Health, IntProperty, EPhysics, PHYS_None, PHYS_Walking };
+enum : uint32_t { CoreObject, EngineObject, ClassClass, PawnClass, HealthProperty, PhysicsEnum, IntPropertyClass };
+
+static auto make_snapshot() -> std::vector<uint8_t>
+{
+    auto writer = Snapshot::Writer();
+
+    const char* names[] = { "None", "Core", "Engine", "Class", "Package", "Pawn", "Health", "IntProperty",
+        "EPhysics", "PHYS_None", "PHYS_Walking" };
+    for (auto i = uint32_t(0); i < std::size(names); ++i) {
+        writer.SetName(i, names[i]);
+    }
+
+    // Objects are set out of order with a gap at index 7
+    writer.SetObject(8, { 0x1800, Pawn, 3, EngineObject, PawnClass, none, none, none, 0 });
+    writer.SetObject(CoreObject, { 0x1000, Core, 0, none, none, none, none, none, 0 });
+    writer.SetObject(EngineObject, { 0x1100, Engine, 0, none, none, none, none, none, 0 });
+    writer.SetObject(ClassClass, { 0x1200, Class, 0, CoreObject, ClassClass, none, none, none, 0x100 });
+    writer.SetObject(PawnClass, { 0x1300, Pawn, 0, EngineObject, ClassClass, none, none, HealthProperty, 0x500 });
+    writer.SetObject(HealthProperty,
+        { 0x1400, Health, 0, PawnClass, IntPropertyClass, none, PhysicsEnum, none, 0 });
+    writer.SetObject(PhysicsEnum, { 0x1500, EPhysics, 0, PawnClass, none, none, none, none, 0 });
+    writer.SetObject(IntPropertyClass, { 0x1600, IntProperty, 0, CoreObject, ClassClass, none, none, none, 0x80 });
+
+    writer.AddProperty({ HealthProperty, Snapshot::PropertyKind::Int, 0x2F0, 4, 1, 0x1, 0, none, none, 0 });
+    writer.AddEnum(PhysicsEnum, { PHYS_None, PHYS_Walking });
+    writer.AddConst(PawnClass, "100");
+
+    return writer.Serialize();
+}
+
+TEST(snapshot, read_written_snapshot)
+{
+    auto data = make_snapshot();
+
+    auto snapshot = Snapshot::Reader();
+    EXPECT_TRUE(snapshot.Open(data.data(), data.size()));
+    EXPECT_TRUE(snapshot.IsOpen());
+
+    EXPECT_EQ(snapshot.GetNameCount(), size_t(11));
+    EXPECT_TRUE(snapshot.GetName(Engine) == "Engine");
+    EXPECT_TRUE(snapshot.GetName(100).empty());
+
+    EXPECT_EQ(snapshot.GetObjects().size(), size_t(9));
+    EXPECT_TRUE(snapshot.FindObject(7) == nullptr);
+    EXPECT_TRUE(snapshot.FindObject(9) == nullptr);
+    EXPECT_TRUE(snapshot.FindObject(none) == nullptr);
+    EXPECT_EQ(snapshot.FindObject(PawnClass)->property_size, uint32_t(0x500));
+    EXPECT_TRUE(snapshot.GetObjectName(PawnClass) == "Pawn");
+
+    EXPECT_TRUE(snapshot.GetPath(PawnClass) == "Engine.Pawn");
+    EXPECT_TRUE(snapshot.GetPath(HealthProperty) == "Engine.Pawn.Health");
+    EXPECT_TRUE(snapshot.GetPath(8) == "Engine.Pawn_2");
+    EXPECT_TRUE(snapshot.GetPath(7).empty());
+
+    // Children chain of the class
+    auto children = std::vector<std::string_view>();
+    for (auto field = snapshot.FindObject(snapshot.FindObject(PawnClass)->children); field;
+         field = snapshot.FindObject(field->next)) {
+        children.push_back(snapshot.GetName(field->name));
+    }
+    EXPECT_TRUE(children == (std::vector<std::string_view> { "Health", "EPhysics" }));
+
+    auto property = snapshot.FindProperty(HealthProperty);
+    EXPECT_TRUE(property != nullptr);
+    EXPECT_TRUE(property->kind == Snapshot::PropertyKind::Int);
+    EXPECT_EQ(property->offset, 0x2F0);
+    EXPECT_TRUE(snapshot.FindProperty(PawnClass) == nullptr);
+
+    auto values = snapshot.FindEnum(PhysicsEnum);
+    EXPECT_EQ(values.size(), size_t(2));
+    EXPECT_TRUE(snapshot.GetName(values[1]) == "PHYS_Walking");
+    EXPECT_TRUE(snapshot.FindEnum(PawnClass).empty());
+
+    EXPECT_TRUE(snapshot.FindConst(PawnClass) == "100");
+    EXPECT_TRUE(snapshot.FindConst(PhysicsEnum).empty());
+
+    snapshot.Close();
+    EXPECT_TRUE(!snapshot.IsOpen());
+    EXPECT_TRUE(snapshot.GetObjects().empty());
+}
+
+TEST(snapshot, map_snapshot_file)
+{
+    const auto path = "tem_snapshot_test.snapshot";
+
+    auto writer = Snapshot::Writer();
+    writer.SetName(0, "None");
+    writer.SetName(1, "Engine");
+    writer.SetObject(0, { 0x1000, 1, 0, none, none, none, none, none, 0 });
+    EXPECT_TRUE(writer.Save(path));
+
+    auto snapshot = Snapshot::Reader();
+    EXPECT_TRUE(snapshot.Open(path));
+    EXPECT_TRUE(snapshot.GetPath(0) == "Engine");
+    snapshot.Close();
+
+    EXPECT_TRUE(!snapshot.Open("does_not_exist.snapshot"));
+    std::remove(path);
+}
+
+TEST(snapshot, reject_invalid_data)
+{
+    auto data = make_snapshot();
+    auto snapshot = Snapshot::Reader();
+
+    EXPECT_TRUE(!snapshot.Open(nullptr, 0));
+    EXPECT_TRUE(!snapshot.Open(data.data(), sizeof(Snapshot::Header) - 1));
+
+    // Sections past the end of a truncated file
+    EXPECT_TRUE(!snapshot.Open(data.data(), data.size() / 2));
+
+    auto copy = data;
+    copy[0] ^= 0xFF;
+    EXPECT_TRUE(!snapshot.Open(copy.data(), copy.size()));
+
+    copy = data;
+    auto header = Snapshot::Header();
+    std::memcpy(&header, copy.data(), sizeof(header));
+    header.version += 1;
+    std::memcpy(copy.data(), &header, sizeof(header));
+    EXPECT_TRUE(!snapshot.Open(copy.data(), copy.size()));
+
+    // Records have to be aligned
+    auto unaligned = std::vector<uint8_t>(data.size() + 8);
+    std::memcpy(unaligned.data() + 1, data.data(), data.size());
+    EXPECT_TRUE(!snapshot.Open(unaligned.data() + 1, data.size()));
+    EXPECT_TRUE(!snapshot.IsOpen());
+
+    // Unknown sections get skipped
+    copy = data;
+    auto section = Snapshot::SectionRecord();
+    std::memcpy(&section, copy.data() + sizeof(header), sizeof(section));
+    section.id = Snapshot::SectionId(99);
+    std::memcpy(copy.data() + sizeof(header), &section, sizeof(section));
+    EXPECT_TRUE(snapshot.Open(copy.data(), copy.size()));
+    EXPECT_EQ(snapshot.GetNameCount(), size_t(0));
+    EXPECT_EQ(snapshot.GetObjects().size(), size_t(9));
+}
+
+TEST(snapshot, property_kinds)
+{
+    EXPECT_TRUE(Snapshot::GetPropertyKind("StructProperty") == Snapshot::PropertyKind::Struct);
+    EXPECT_TRUE(Snapshot::GetPropertyKind("ComponentProperty") == Snapshot::PropertyKind::Component);
+    EXPECT_TRUE(Snapshot::GetPropertyKind("Function") == Snapshot::PropertyKind::Unknown);
+    EXPECT_TRUE(std::strcmp(Snapshot::GetPropertyKindName(Snapshot::PropertyKind::Map), "MapProperty") == 0);
+}
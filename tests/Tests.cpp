@@ -0,0 +1,48 @@
+/*
+ * Copyright (c) 2022-2023, NeKz
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "Tests.hpp"
+#include <iostream>
+
+std::vector<UnitTest*>& UnitTest::test_cases()
+{
+    static std::vector<UnitTest*> list;
+    return list;
+}
+
+UnitTest::UnitTest(const char* case_name, const char* description, _UnitTestFunction callback)
+    : case_name(case_name)
+    , description(description)
+    , callback(callback)
+{
+    UnitTest::test_cases().push_back(this);
+}
+
+auto run_all_tests() -> int
+{
+    auto succeeded = 0;
+    auto failed = 0;
+
+    std::cout << "running " << UnitTest::test_cases().size() << " test cases..." << std::endl << std::endl;
+
+    for (auto& test_case : UnitTest::test_cases()) {
+        try {
+            test_case->callback(test_case);
+            std::cout << "[succeeded] " << test_case->case_name << " - " << test_case->description << std::endl
+                      << std::endl;
+            ++succeeded;
+        } catch (const std::exception& ex) {
+            std::cout << ex.what() << std::endl << std::endl;
+            ++failed;
+        }
+    }
+
+    std::cout << "completed all tests: " << std::endl;
+    std::cout << " - succeeded: " << succeeded << std::endl;
+    std::cout << " - failed: " << failed << std::endl;
+
+    return failed == 0 ? 0 : 1;
+}
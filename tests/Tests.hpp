@@ -0,0 +1,67 @@
+/*
+ * Copyright (c) 2022-2023, NeKz
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using _UnitTestFunction = void (*)(struct UnitTest* test);
+
+struct UnitTest {
+    const char* case_name;
+    const char* description;
+    _UnitTestFunction callback;
+
+    static std::vector<UnitTest*>& test_cases();
+
+    UnitTest(const char* case_name, const char* description, _UnitTestFunction callback);
+};
+
+// <format> is not available everywhere these tests have to run, streams are.
+template <typename T> inline auto to_test_string(const T& value) -> std::string
+{
+    auto stream = std::ostringstream();
+    stream << value;
+    return stream.str();
+}
+inline auto to_test_string(const void* value) -> std::string
+{
+    auto stream = std::ostringstream();
+    stream << value;
+    return stream.str();
+}
+template <typename T> inline auto to_test_string(const T* value) -> std::string
+{
+    return to_test_string(static_cast<const void*>(value));
+}
+template <typename T> inline auto to_test_string(const std::vector<T>& values) -> std::string
+{
+    auto result = std::string("[");
+    for (auto i = size_t(0); i < values.size(); ++i) {
+        result += (i ? ", " : "") + to_test_string(values[i]);
+    }
+    return result + "]";
+}
+
+#define TEST(case_name, description)                                                                                   \
+    void case_name##description##_callback(UnitTest* test);                                                            \
+    UnitTest case_name##description(#case_name, #description, case_name##description##_callback);                      \
+    void case_name##description##_callback(UnitTest* test)
+
+#define EXPECT_TRUE(condition)                                                                                         \
+    if (!(condition)) {                                                                                                \
+        throw std::runtime_error(std::string("[failed] ") + test->case_name + " - " + test->description                \
+            + "\n - condition \"" #condition "\" evaluated to false");                                                 \
+    }
+#define EXPECT_EQ(actual, expected)                                                                                    \
+    if (!((actual) == (expected))) {                                                                                   \
+        throw std::runtime_error(std::string("[failed] ") + test->case_name + " - " + test->description                \
+            + "\n - expected: " + to_test_string(expected) + "\n - actual: " + to_test_string(actual));                \
+    }
+
+extern auto run_all_tests() -> int;
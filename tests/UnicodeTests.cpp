@@ -0,0 +1,120 @@
+/*
+ * Copyright (c) 2022-2023, NeKz
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "../src/Unicode.hpp"
+#include "Tests.hpp"
+#include <cstring>
+#include <random>
+
+// Straightforward encoder to compare against
+static auto reference_utf8(const std::u16string& text) -> std::string
+{
+    auto result = std::string();
+    for (auto i = size_t(0); i < text.size(); ++i) {
+        auto code_point = char32_t(text[i]);
+        if (code_point >= 0xD800 && code_point <= 0xDFFF) {
+            auto paired = code_point <= 0xDBFF && i + 1 < text.size() && text[i + 1] >= 0xDC00 && text[i + 1] <= 0xDFFF;
+            code_point = paired ? 0x10000 + ((code_point - 0xD800) << 10) + (text[++i] - 0xDC00) : 0xFFFD;
+        }
+
+        if (code_point < 0x80) {
+            result += char(code_point);
+        } else if (code_point < 0x800) {
+            result += char(0xC0 | (code_point >> 6));
+            result += char(0x80 | (code_point & 0x3F));
+        } else if (code_point < 0x10000) {
+            result += char(0xE0 | (code_point >> 12));
+            result += char(0x80 | ((code_point >> 6) & 0x3F));
+            result += char(0x80 | (code_point & 0x3F));
+        } else {
+            result += char(0xF0 | (code_point >> 18));
+            result += char(0x80 | ((code_point >> 12) & 0x3F));
+            result += char(0x80 | ((code_point >> 6) & 0x3F));
+            result += char(0x80 | (code_point & 0x3F));
+        }
+    }
+    return result;
+}
+
+static auto to_utf8(const std::u16string& text) -> std::string { return Unicode::ToUtf8(text.data(), text.size()); }
+
+TEST(unicode, converts_utf16_to_utf8)
+{
+    EXPECT_TRUE(to_utf8(u"").empty());
+    EXPECT_TRUE(to_utf8(u"Tron Evolution") == "Tron Evolution");
+    EXPECT_TRUE(to_utf8(u"café") == "caf\xc3\xa9");
+    EXPECT_TRUE(to_utf8(u"€100") == "\xe2\x82\xac" "100");
+    EXPECT_TRUE(to_utf8(u"\U0001F600") == "\xf0\x9f\x98\x80");
+    EXPECT_TRUE(to_utf8(u"\uFFFF") == "\xef\xbf\xbf");
+    EXPECT_TRUE(to_utf8(std::u16string(1, u'\0')) == std::string(1, '\0'));
+
+    // Longer than one SIMD block with the non-ASCII part at the end of it
+    EXPECT_TRUE(to_utf8(u"open MP_CMI_C1_BIT?é") == "open MP_CMI_C1_BIT?\xc3\xa9");
+    EXPECT_TRUE(to_utf8(u"0123456789abcdeé") == "0123456789abcde\xc3\xa9");
+}
+
+TEST(unicode, replaces_unpaired_surrogates)
+{
+    auto replacement = std::string("\xef\xbf\xbd");
+
+    EXPECT_TRUE(to_utf8(std::u16string(1, char16_t(0xD83D))) == replacement);
+    EXPECT_TRUE(to_utf8(std::u16string(1, char16_t(0xDE00))) == replacement);
+    EXPECT_TRUE(to_utf8(std::u16string { char16_t(0xDE00), char16_t(0xD83D) }) == replacement + replacement);
+    EXPECT_TRUE(to_utf8(std::u16string { char16_t(0xD83D), u'a' }) == replacement + "a");
+
+    // Pair split by the end of a SIMD block
+    auto text = std::u16string(15, u'a') + u"\U0001F600";
+    EXPECT_TRUE(to_utf8(text) == std::string(15, 'a') + "\xf0\x9f\x98\x80");
+}
+
+TEST(unicode, matches_reference_encoder)
+{
+    auto rng = std::mt19937(22);
+
+    // Mostly ASCII with runs of every other kind of unit
+    const char16_t samples[] = { u'x', u'é', u'中', char16_t(0xD83D), char16_t(0xDE00), u'\0' };
+
+    for (auto round = 0; round < 500; ++round) {
+        auto text = std::u16string(rng() % 200, u' ');
+        for (auto& unit : text) {
+            auto kind = rng() % 16;
+            unit = kind < 10 ? char16_t(0x20 + rng() % 0x5F) : samples[kind % std::size(samples)];
+        }
+
+        auto expected = reference_utf8(text);
+        auto result = to_utf8(text);
+        if (result != expected) {
+            EXPECT_TRUE(result == expected);
+            return;
+        }
+
+        EXPECT_EQ(Unicode::Utf8Size(text.data(), text.size()), expected.size());
+    }
+}
+
+TEST(unicode, writes_into_buffer)
+{
+    auto text = std::u16string(u"abcdefghijklmnopqrstuvwxyzé\U0001F600");
+    auto expected = reference_utf8(text);
+
+    char buffer[64];
+    EXPECT_EQ(Unicode::ToUtf8(text.data(), text.size(), buffer, sizeof(buffer)), expected.size());
+    EXPECT_TRUE(std::string(buffer, expected.size()) == expected);
+
+    // Never splits a code point and never writes past the capacity
+    for (auto capacity = size_t(0); capacity <= expected.size(); ++capacity) {
+        char small[64];
+        std::memset(small, '#', sizeof(small));
+
+        auto written = Unicode::ToUtf8(text.data(), text.size(), small, capacity);
+        auto fits = capacity >= 32 ? 32 : capacity >= 28 ? 28 : capacity >= 26 ? 26 : capacity;
+        if (written != size_t(fits) || std::string(small, written) != expected.substr(0, written)
+            || small[capacity] != '#') {
+            EXPECT_EQ(written, size_t(fits));
+            return;
+        }
+    }
+}
@@ -0,0 +1,154 @@
+/*
+ * Copyright (c) 2022-2023, NeKz
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "../src/Scanner.hpp"
+#include "../src/Xrefs.hpp"
+#include "Tests.hpp"
+#include <algorithm>
+#include <cstring>
+#include <random>
+
+static const Scanner::Backend all_backends[] = {
+    Scanner::Backend::Scalar,
+    Scanner::Backend::SSE2,
+    Scanner::Backend::AVX2,
+};
+
+static auto write_branch(std::vector<uint8_t>& code, size_t position, uint8_t opcode, uintptr_t base, uintptr_t target)
+    -> void
+{
+    auto relative = int32_t(target - (base + position + 5));
+    code[position] = opcode;
+    std::memcpy(code.data() + position + 1, &relative, sizeof(relative));
+}
+
+static auto write_pointer(std::vector<uint8_t>& code, size_t position, uint32_t target) -> void
+{
+    std::memcpy(code.data() + position, &target, sizeof(target));
+}
+
+// Straightforward byte by byte scan every backend gets compared against.
+static auto reference_xrefs(const std::vector<uint8_t>& code, uintptr_t base, const std::vector<uintptr_t>& targets)
+    -> std::vector<std::pair<uintptr_t, uintptr_t>>
+{
+    auto result = std::vector<std::pair<uintptr_t, uintptr_t>>();
+    auto is_target = [&](uintptr_t value) { return std::find(targets.begin(), targets.end(), value) != targets.end(); };
+
+    for (auto i = size_t(0); i + 4 <= code.size(); ++i) {
+        if (i + 5 <= code.size() && (code[i] == 0xE8 || code[i] == 0xE9)) {
+            auto relative = int32_t();
+            std::memcpy(&relative, code.data() + i + 1, sizeof(relative));
+            auto to = uintptr_t(base + i + 5 + intptr_t(relative));
+            if (is_target(to)) {
+                result.push_back({ base + i, to });
+            }
+        }
+
+        auto value = uint32_t();
+        std::memcpy(&value, code.data() + i, sizeof(value));
+        if (is_target(value)) {
+            result.push_back({ base + i, value });
+        }
+    }
+
+    std::sort(result.begin(), result.end(),
+        [](auto& a, auto& b) { return a.second != b.second ? a.second < b.second : a.first < b.first; });
+    return result;
+}
+
+TEST(xrefs, calls_jumps_and_pointers)
+{
+    const auto base = uintptr_t(0x401000);
+    const auto g_engine = uintptr_t(0x2686CA8);
+    const auto function = uintptr_t(0x401800);
+
+    auto code = std::vector<uint8_t>(0x1000, 0xCC);
+    write_branch(code, 0x010, 0xE8, base, function);
+    write_branch(code, 0x100, 0xE9, base, function);
+    write_branch(code, 0xFFB, 0xE8, base, function); // Last possible position
+    write_pointer(code, 0x202, uint32_t(g_engine)); // mov eax, [g_Engine]
+    write_pointer(code, 0xFFC - 0x400, uint32_t(function));
+
+    for (auto backend : all_backends) {
+        if (!Scanner::SetBackend(backend)) {
+            continue;
+        }
+
+        auto index = Xrefs::Index({ g_engine, function });
+        index.Scan(code.data(), code.data() + code.size(), base);
+
+        auto calls = index.Find(function, XREF_CALL);
+        EXPECT_EQ(calls.size(), size_t(2));
+        EXPECT_EQ(calls.at(0).from, base + 0x010);
+        EXPECT_EQ(calls.at(1).from, base + 0xFFB);
+
+        auto jumps = index.Find(function, XREF_JUMP);
+        EXPECT_EQ(jumps.size(), size_t(1));
+        EXPECT_EQ(jumps.at(0).from, base + 0x100);
+
+        auto pointers = index.Find(function, XREF_ABSOLUTE);
+        EXPECT_EQ(pointers.size(), size_t(1));
+        EXPECT_EQ(pointers.at(0).from, base + 0xBFC);
+
+        auto engine = index.Find(g_engine);
+        EXPECT_EQ(engine.size(), size_t(1));
+        EXPECT_EQ(engine[0].from, base + 0x202);
+        EXPECT_EQ(engine[0].kind, uint32_t(XREF_ABSOLUTE));
+
+        EXPECT_EQ(index.Find(0x12345678).size(), size_t(0));
+    }
+
+    Scanner::SetBackend(Scanner::DetectBackend());
+}
+
+TEST(xrefs, random_code_matches_reference)
+{
+    auto rng = std::mt19937(1337);
+    const auto base = uintptr_t(0x400000);
+
+    for (auto round = 0; round < 20; ++round) {
+        auto code = std::vector<uint8_t>(1000 + rng() % 5000);
+        for (auto& value : code) {
+            value = rng() % 3 ? uint8_t(rng()) : uint8_t(0xE8 + rng() % 2);
+        }
+
+        auto targets = std::vector<uintptr_t>();
+        for (auto i = 0; i < 8; ++i) {
+            targets.push_back(base + rng() % code.size());
+        }
+
+        for (auto i = 0; i < 32; ++i) {
+            auto position = rng() % (code.size() - 5);
+            auto target = targets[rng() % targets.size()];
+            if (rng() % 2) {
+                write_branch(code, position, uint8_t(0xE8 + rng() % 2), base, target);
+            } else {
+                write_pointer(code, position, uint32_t(target));
+            }
+        }
+
+        auto expected = reference_xrefs(code, base, targets);
+
+        for (auto backend : all_backends) {
+            if (!Scanner::SetBackend(backend)) {
+                continue;
+            }
+
+            auto index = Xrefs::Index(targets);
+            index.Scan(code.data(), code.data() + code.size(), base);
+
+            auto actual = std::vector<std::pair<uintptr_t, uintptr_t>>();
+            for (const auto& reference : index.GetReferences()) {
+                actual.push_back({ reference.from, reference.to });
+            }
+
+            EXPECT_EQ(actual.size(), expected.size());
+            EXPECT_TRUE(actual == expected);
+        }
+    }
+
+    Scanner::SetBackend(Scanner::DetectBackend());
+}
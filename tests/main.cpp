@@ -0,0 +1,13 @@
+/*
+ * Copyright (c) 2022-2023, NeKz
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ *
+ * Unit tests for the platform independent parts of tem.
+ * Everything in here has to build and run on Windows and Linux.
+ */
+
+#include "Tests.hpp"
+
+int main() { return run_all_tests(); }